@@ -0,0 +1,403 @@
+/*
+ * hsh_bench: throughput and latency of every algorithm in the hsh_hash
+ * registry, one-shot and streaming, for message sizes from 0 B to 64 MiB,
+ * plus the multi-buffer batch APIs (MD5, SHA-2, SHA-3) hashing
+ * BENCH_BATCH messages of each size per call, for sizes up to 64 KiB.
+ *
+ * Each CPU level (see HSH_CPU in cpu.h) runs in a forked child, since the
+ * library probes the feature mask once per process. An algorithm is only
+ * measured again at a lower level if that selects a different backend.
+ *
+ *   hsh_bench [-j] [-a alg,...] [-l level;...] [-s size,...] [-c chunk] [-t sec]
+ *
+ *   -j  JSON Lines on stdout (one object per measurement) instead of a table
+ *   -a  algorithms to run (registry names), default all
+ *   -l  CPU levels separated by ';': "native", "none" or an HSH_CPU list,
+ *       default "native;sse2,ssse3,sse41;none" (or just $HSH_CPU if set)
+ *   -s  message sizes in bytes, k / m suffixes allowed
+ *   -c  update() chunk size for the streaming runs, default 4096
+ *   -t  target time per measurement in seconds, default 0.1
+ *
+ * Batch rows are not deduplicated by backend: the lane kernels are chosen
+ * apart from the single-stream backend, so they run at every level.
+ *
+ * Throughput (GB/s, cycles/byte) comes from an untimed loop of calls; the
+ * p50/p99 latencies come from a separate pass that reads the tick counter
+ * after every call.
+ *
+ * Cycles are TSC reference cycles where available, so cycles/byte is only
+ * comparable between runs at the same core clock.
+ */
+
+#include "hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+#define BENCH_MAX_SIZE     (64u << 20)
+#define BENCH_LATENCY_MAX  (64u << 10)  /* per-call latency up to this size */
+#define BENCH_MAX_SAMPLES  (1u << 20)
+#define BENCH_MIN_ITERS    2
+#define BENCH_MAX_SEEN     256
+#define BENCH_BATCH        8            /* messages per batch call */
+
+/* ==== Options and shared state ==== */
+
+typedef struct {
+    int json;
+    const char *algs;
+    size_t sizes[64];
+    size_t nsizes;
+    size_t chunk;
+    double target;
+} bench_opts;
+
+/* (algorithm, backend) pairs already measured, shared with the children */
+typedef struct {
+    int count;
+    char key[BENCH_MAX_SEEN][48];
+} bench_seen;
+
+static const size_t bench_default_sizes[] = {
+    0, 1, 16, 64, 256, 1024, 4096, 16384, 65536,
+    256u << 10, 1u << 20, 4u << 20, 16u << 20, 64u << 20,
+};
+
+static volatile uint8_t bench_sink;
+
+typedef void (*bench_batch_fn)(const uint8_t *const *data, const size_t *lens, size_t count,
+                               uint8_t *digests);
+
+/* Registry entries with a multi-buffer batch API */
+static const struct {
+    const hsh_hash_alg *alg;
+    bench_batch_fn batch;
+} bench_batches[] = {
+    {&hsh_hash_md5, hsh_md5_batch},
+    {&hsh_hash_sha224, hsh_sha2_224_batch},
+    {&hsh_hash_sha256, hsh_sha2_256_batch},
+    {&hsh_hash_sha384, hsh_sha2_384_batch},
+    {&hsh_hash_sha512, hsh_sha2_512_batch},
+    {&hsh_hash_sha3_224, hsh_sha3_224_batch},
+    {&hsh_hash_sha3_256, hsh_sha3_256_batch},
+    {&hsh_hash_sha3_384, hsh_sha3_384_batch},
+    {&hsh_hash_sha3_512, hsh_sha3_512_batch},
+};
+
+typedef enum { BENCH_ONESHOT, BENCH_STREAM, BENCH_BATCHED } bench_mode;
+
+static const char *const bench_mode_names[] = {"oneshot", "stream", "batch"};
+
+/* ==== Timers ==== */
+
+static uint64_t bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Per-call tick counter: TSC cycles, or nanoseconds without one */
+static inline uint64_t bench_ticks(void) {
+#if BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return bench_ns();
+#endif
+}
+
+/* Ticks per second */
+static double bench_tick_rate(void) {
+#if BENCH_HAVE_TSC
+    uint64_t t0 = bench_ns(), c0 = bench_ticks(), t1;
+    do {
+        t1 = bench_ns();
+    } while (t1 - t0 < 50000000u);
+    return (double)(bench_ticks() - c0) * 1e9 / (double)(t1 - t0);
+#else
+    return 1e9;
+#endif
+}
+
+static int bench_cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* ==== Measurement ==== */
+
+typedef struct {
+    size_t iters;
+    double gbps;
+    double cpb;
+    double p50_ns;
+    double p99_ns;
+} bench_result;
+
+/* Batch calls hash BENCH_BATCH consecutive len-byte messages from data */
+static void bench_once(const hsh_hash_alg *alg, bench_mode mode, bench_batch_fn batch,
+                       size_t chunk, const uint8_t *data, size_t len) {
+    static hsh_hash_ctx ctx;
+    static const uint8_t *msgs[BENCH_BATCH];
+    static size_t lens[BENCH_BATCH];
+    uint8_t digest[BENCH_BATCH * HSH_HASH_MAX_DIGEST];
+
+    if (mode == BENCH_STREAM) {
+        hsh_hash_init(&ctx, alg);
+        for (size_t off = 0; off < len; off += chunk)
+            hsh_hash_update(&ctx, data + off, len - off < chunk ? len - off : chunk);
+        hsh_hash_finalize(&ctx, digest);
+    } else if (mode == BENCH_BATCHED) {
+        for (size_t m = 0; m < BENCH_BATCH; m++) {
+            msgs[m] = data + m * len;
+            lens[m] = len;
+        }
+        batch(msgs, lens, BENCH_BATCH, digest);
+    } else {
+        hsh_hash(alg, data, len, digest);
+    }
+    bench_sink ^= digest[0];
+}
+
+static void bench_run(const hsh_hash_alg *alg, bench_mode mode, bench_batch_fn batch,
+                      const bench_opts *opts, const uint8_t *data, size_t len, double tick_rate,
+                      uint64_t *samples, bench_result *res) {
+    int latency = len <= BENCH_LATENCY_MAX;
+    double bytes = (double)len * (mode == BENCH_BATCHED ? BENCH_BATCH : 1);
+    uint64_t t0, c0, elapsed, cycles;
+    size_t iters;
+
+    /* Warm-up call doubles as the estimate for the iteration count */
+    t0 = bench_ns();
+    bench_once(alg, mode, batch, opts->chunk, data, len);
+    elapsed = bench_ns() - t0;
+    iters = (size_t)(opts->target * 1e9 / (double)(elapsed ? elapsed : 1));
+    if (iters < BENCH_MIN_ITERS) iters = BENCH_MIN_ITERS;
+    if (iters > BENCH_MAX_SAMPLES) iters = BENCH_MAX_SAMPLES;
+
+    /* Throughput: no per-call timer reads, whose cost would dominate the
+     * smallest sizes */
+    t0 = bench_ns();
+    c0 = bench_ticks();
+    for (size_t i = 0; i < iters; i++)
+        bench_once(alg, mode, batch, opts->chunk, data, len);
+    cycles = bench_ticks() - c0;
+    elapsed = bench_ns() - t0;
+
+    res->iters = iters;
+    res->gbps = bytes * (double)iters / (double)(elapsed ? elapsed : 1);
+    res->cpb = BENCH_HAVE_TSC && len ? (double)cycles / (bytes * (double)iters) : -1.0;
+    res->p50_ns = res->p99_ns = -1.0;
+    if (latency) {
+        uint64_t prev = bench_ticks();
+        for (size_t i = 0; i < iters; i++) {
+            bench_once(alg, mode, batch, opts->chunk, data, len);
+            uint64_t now = bench_ticks();
+            samples[i] = now - prev;
+            prev = now;
+        }
+        qsort(samples, iters, sizeof(samples[0]), bench_cmp_u64);
+        res->p50_ns = (double)samples[iters / 2] * 1e9 / tick_rate;
+        res->p99_ns = (double)samples[iters * 99 / 100] * 1e9 / tick_rate;
+    }
+}
+
+/* ==== Output ==== */
+
+static void bench_json_num(const char *key, double v) {
+    if (v < 0)
+        printf(",\"%s\":null", key);
+    else
+        printf(",\"%s\":%.4f", key, v);
+}
+
+static void bench_report(const bench_opts *opts, const char *level, const hsh_hash_alg *alg,
+                         const char *backend, bench_mode m, size_t len, const bench_result *r) {
+    const char *mode = bench_mode_names[m];
+
+    if (opts->json) {
+        printf("{\"alg\":\"%s\",\"backend\":\"%s\",\"cpu\":\"%s\",\"mode\":\"%s\","
+               "\"size\":%zu,\"chunk\":%zu,\"iters\":%zu",
+               alg->name, backend, level, mode, len, m == BENCH_STREAM ? opts->chunk : len,
+               r->iters);
+        bench_json_num("gbps", r->gbps);
+        bench_json_num("cpb", r->cpb);
+        bench_json_num("p50_ns", r->p50_ns);
+        bench_json_num("p99_ns", r->p99_ns);
+        printf("}\n");
+        return;
+    }
+
+    printf("%-10s %-8s %-8s %10zu %9.3f", alg->name, backend, mode, len, r->gbps);
+    if (r->cpb >= 0) printf(" %9.2f", r->cpb); else printf(" %9s", "-");
+    if (r->p50_ns >= 0) printf(" %11.0f %11.0f\n", r->p50_ns, r->p99_ns);
+    else printf(" %11s %11s\n", "-", "-");
+}
+
+static int bench_selected(const char *list, const char *name) {
+    size_t n = strlen(name);
+    if (!list) return 1;
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        if (len == n && strncasecmp(list, name, n) == 0) return 1;
+        list += len;
+        if (*list) list++;
+    }
+    return 0;
+}
+
+/* Runs in the child for one CPU level */
+static void bench_level(const bench_opts *opts, const char *level, bench_seen *seen,
+                        const uint8_t *data, uint64_t *samples, double tick_rate) {
+    if (!opts->json) {
+        printf("# cpu level: %s\n", level);
+        printf("%-10s %-8s %-8s %10s %9s %9s %11s %11s\n",
+               "alg", "backend", "mode", "bytes", "GB/s", "cyc/B", "p50 ns", "p99 ns");
+    }
+
+    for (size_t i = 0; i < hsh_hash_count(); i++) {
+        const hsh_hash_alg *alg = hsh_hash_get(i);
+        const char *backend = hsh_hash_backend(alg);
+        char key[48];
+        int k;
+
+        if (!bench_selected(opts->algs, alg->name)) continue;
+        snprintf(key, sizeof(key), "%s/%s", alg->name, backend);
+        for (k = 0; k < seen->count && strcmp(seen->key[k], key) != 0; k++)
+            ;
+        if (k < seen->count || seen->count == BENCH_MAX_SEEN) continue;
+        strcpy(seen->key[seen->count++], key);
+
+        for (bench_mode m = BENCH_ONESHOT; m <= BENCH_STREAM; m++) {
+            for (size_t s = 0; s < opts->nsizes; s++) {
+                bench_result r;
+                bench_run(alg, m, NULL, opts, data, opts->sizes[s], tick_rate, samples, &r);
+                bench_report(opts, level, alg, backend, m, opts->sizes[s], &r);
+                fflush(stdout);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(bench_batches) / sizeof(bench_batches[0]); i++) {
+        const hsh_hash_alg *alg = bench_batches[i].alg;
+
+        if (!bench_selected(opts->algs, alg->name)) continue;
+        for (size_t s = 0; s < opts->nsizes; s++) {
+            bench_result r;
+            if (opts->sizes[s] > BENCH_LATENCY_MAX) continue;
+            bench_run(alg, BENCH_BATCHED, bench_batches[i].batch, opts, data, opts->sizes[s],
+                      tick_rate, samples, &r);
+            bench_report(opts, level, alg, hsh_hash_backend(alg), BENCH_BATCHED, opts->sizes[s], &r);
+            fflush(stdout);
+        }
+    }
+}
+
+/* ==== Main ==== */
+
+static size_t bench_parse_size(const char *s) {
+    char *end;
+    size_t v = (size_t)strtoull(s, &end, 10);
+    if (*end == 'k' || *end == 'K') v <<= 10;
+    if (*end == 'm' || *end == 'M') v <<= 20;
+    return v;
+}
+
+static void bench_usage(void) {
+    fprintf(stderr, "usage: hsh_bench [-j] [-a alg,...] [-l level;...] [-s size,...] "
+                    "[-c chunk] [-t sec]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    bench_opts opts = { 0, NULL, {0}, 0, 4096, 0.1 };
+    const char *levels = getenv("HSH_CPU") ? getenv("HSH_CPU") : "native;sse2,ssse3,sse41;none";
+    char *level_list, *level, *save = NULL;
+    size_t max_size = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "ja:l:s:c:t:")) != -1) {
+        switch (opt) {
+        case 'j': opts.json = 1; break;
+        case 'a': opts.algs = optarg; break;
+        case 'l': levels = optarg; break;
+        case 'c': opts.chunk = bench_parse_size(optarg); break;
+        case 't': opts.target = atof(optarg); break;
+        case 's':
+            for (char *p = optarg; *p && opts.nsizes < 64; p += strcspn(p, ","), p += *p == ',')
+                opts.sizes[opts.nsizes++] = bench_parse_size(p);
+            break;
+        default: bench_usage();
+        }
+    }
+    if (opts.chunk == 0 || opts.target <= 0) bench_usage();
+    if (opts.nsizes == 0) {
+        opts.nsizes = sizeof(bench_default_sizes) / sizeof(bench_default_sizes[0]);
+        memcpy(opts.sizes, bench_default_sizes, sizeof(bench_default_sizes));
+    }
+    for (size_t i = 0; i < opts.nsizes; i++) {
+        if (opts.sizes[i] > BENCH_MAX_SIZE) opts.sizes[i] = BENCH_MAX_SIZE;
+        if (opts.sizes[i] > max_size) max_size = opts.sizes[i];
+    }
+
+    /* Batch runs read BENCH_BATCH messages of up to BENCH_LATENCY_MAX bytes */
+    if (max_size < BENCH_BATCH * BENCH_LATENCY_MAX) max_size = BENCH_BATCH * BENCH_LATENCY_MAX;
+    uint8_t *data = malloc(max_size);
+    uint64_t *samples = malloc(BENCH_MAX_SAMPLES * sizeof(uint64_t));
+    bench_seen *seen = mmap(NULL, sizeof(*seen), PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (!data || !samples || seen == MAP_FAILED) {
+        fprintf(stderr, "hsh_bench: out of memory\n");
+        return 1;
+    }
+    srand(1);
+    for (size_t i = 0; i < max_size; i++)
+        data[i] = (uint8_t)rand();
+    seen->count = 0;
+
+    double tick_rate = bench_tick_rate();
+    if (!opts.json)
+        printf("# tick rate %.3f GHz%s\n", tick_rate / 1e9, BENCH_HAVE_TSC ? " (TSC)" : "");
+
+    level_list = strdup(levels);
+    for (level = strtok_r(level_list, ";", &save); level; level = strtok_r(NULL, ";", &save)) {
+        pid_t pid;
+        int status;
+
+        if (strcmp(level, "native") == 0)
+            unsetenv("HSH_CPU");
+        else
+            setenv("HSH_CPU", level, 1);
+
+        fflush(stdout);
+        pid = fork();
+        if (pid < 0) {
+            perror("hsh_bench: fork");
+            return 1;
+        }
+        if (pid == 0) {
+            bench_level(&opts, level, seen, data, samples, tick_rate);
+            exit(0);
+        }
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "hsh_bench: level %s failed\n", level);
+            return 1;
+        }
+    }
+
+    free(level_list);
+    free(samples);
+    free(data);
+    return 0;
+}
@@ -16,6 +16,8 @@ typedef struct {
     uint8_t buffer[128];
     size_t buffer_len;
     size_t digest_size;
+    uint64_t key_h[8];   /* h after the key block, compressed once at init */
+    int key_pending;     /* buffer still holds the key block */
 } hsh_blake2b_ctx;
 
 /* BLAKE2s (32-bit) context */
@@ -25,12 +27,37 @@ typedef struct {
     uint8_t buffer[64];
     size_t buffer_len;
     size_t digest_size;
+    uint32_t key_h[8];   /* h after the key block, compressed once at init */
+    int key_pending;     /* buffer still holds the key block */
 } hsh_blake2s_ctx;
 
+/* Parallel tree modes: interleaved blocks spread over independent leaves */
+#define HSH_BLAKE2BP_LEAVES 4
+#define HSH_BLAKE2SP_LEAVES 8
+
+/* BLAKE2bp: 4 BLAKE2b leaves over 128-byte blocks, one root */
+typedef struct {
+    hsh_blake2b_ctx leaves[HSH_BLAKE2BP_LEAVES];
+    hsh_blake2b_ctx root;
+    uint8_t buffer[HSH_BLAKE2BP_LEAVES * 128];
+    size_t buffer_len;
+} hsh_blake2bp_ctx;
+
+/* BLAKE2sp: 8 BLAKE2s leaves over 64-byte blocks, one root */
+typedef struct {
+    hsh_blake2s_ctx leaves[HSH_BLAKE2SP_LEAVES];
+    hsh_blake2s_ctx root;
+    uint8_t buffer[HSH_BLAKE2SP_LEAVES * 64];
+    size_t buffer_len;
+} hsh_blake2sp_ctx;
+
 /* ============================================
  * Public API
  * ============================================ */
 
+/* Keyed init compresses the key block right away and keeps the result in
+ * the context, so a keyed context can be set up once and copied for each
+ * message without paying for the key block again. */
 int hsh_blake2b_init(hsh_blake2b_ctx *ctx, size_t digest_size,
                      const uint8_t *key, size_t key_len,
                      const uint8_t *personal, size_t pers_len);
@@ -48,5 +75,37 @@ void hsh_blake2s_update(hsh_blake2s_ctx *ctx, const uint8_t *data, size_t len);
 
 void hsh_blake2s_finalize(hsh_blake2s_ctx *ctx, uint8_t *digest);
 
+
+/* Large updates hash the leaves on worker threads */
+int hsh_blake2bp_init(hsh_blake2bp_ctx *ctx, size_t digest_size,
+                      const uint8_t *key, size_t key_len);
+
+void hsh_blake2bp_update(hsh_blake2bp_ctx *ctx, const uint8_t *data, size_t len);
+
+void hsh_blake2bp_finalize(hsh_blake2bp_ctx *ctx, uint8_t *digest);
+
+
+int hsh_blake2sp_init(hsh_blake2sp_ctx *ctx, size_t digest_size,
+                      const uint8_t *key, size_t key_len);
+
+void hsh_blake2sp_update(hsh_blake2sp_ctx *ctx, const uint8_t *data, size_t len);
+
+void hsh_blake2sp_finalize(hsh_blake2sp_ctx *ctx, uint8_t *digest);
+
+
+/* One-shot hashing of data[0..len); key may be NULL with key_len 0.
+ * Return -1 on bad sizes like the init functions. */
+int hsh_blake2b(const uint8_t *data, size_t len, uint8_t *digest, size_t digest_size,
+                const uint8_t *key, size_t key_len);
+
+int hsh_blake2s(const uint8_t *data, size_t len, uint8_t *digest, size_t digest_size,
+                const uint8_t *key, size_t key_len);
+
+int hsh_blake2bp(const uint8_t *data, size_t len, uint8_t *digest, size_t digest_size,
+                 const uint8_t *key, size_t key_len);
+
+int hsh_blake2sp(const uint8_t *data, size_t len, uint8_t *digest, size_t digest_size,
+                 const uint8_t *key, size_t key_len);
+
 #endif /* HSH_BLAKE2_H */
 
@@ -0,0 +1,63 @@
+#ifndef HSH_BLAKE3_H
+#define HSH_BLAKE3_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HSH_BLAKE3_OUT_LEN   32
+#define HSH_BLAKE3_KEY_LEN   32
+#define HSH_BLAKE3_BLOCK_LEN 64
+#define HSH_BLAKE3_CHUNK_LEN 1024
+#define HSH_BLAKE3_MAX_DEPTH 54  /* 2^54 chunks = 2^64 bytes */
+
+/* ============================================
+ * Structures
+ * ============================================ */
+
+/* The 1 KiB chunk currently being absorbed */
+typedef struct {
+    uint32_t cv[8];
+    uint64_t chunk_counter;
+    uint8_t buf[HSH_BLAKE3_BLOCK_LEN];
+    uint8_t buf_len;
+    uint8_t blocks_compressed;
+    uint8_t flags;
+} hsh_blake3_chunk_state;
+
+/* BLAKE3 context: key words, current chunk and the stack of subtree
+ * chaining values still waiting for a right sibling */
+typedef struct {
+    uint32_t key[8];
+    hsh_blake3_chunk_state chunk;
+    uint8_t cv_stack_len;
+    uint8_t cv_stack[(HSH_BLAKE3_MAX_DEPTH + 1) * HSH_BLAKE3_OUT_LEN];
+} hsh_blake3_ctx;
+
+/* ============================================
+ * Public API
+ * ============================================ */
+
+void hsh_blake3_init(hsh_blake3_ctx *ctx);
+
+void hsh_blake3_init_keyed(hsh_blake3_ctx *ctx, const uint8_t key[HSH_BLAKE3_KEY_LEN]);
+
+/* Key derivation: context should be a hardcoded, globally unique string */
+void hsh_blake3_init_derive_key(hsh_blake3_ctx *ctx, const char *context);
+
+void hsh_blake3_update(hsh_blake3_ctx *ctx, const uint8_t *data, size_t len);
+
+/* Same result as hsh_blake3_update; inputs of several MiB are split into
+ * subtrees that are hashed on worker threads */
+void hsh_blake3_update_parallel(hsh_blake3_ctx *ctx, const uint8_t *data, size_t len);
+
+/* Extendable output: any out_len, the first 32 bytes are the usual digest.
+ * The context is left untouched, so more input may follow. */
+void hsh_blake3_finalize(const hsh_blake3_ctx *ctx, uint8_t *out, size_t out_len);
+
+/* One-shot hashing of data[0..len) into out_len bytes; inputs of up to one
+ * chunk (1 KiB) are compressed directly without a context */
+void hsh_blake3(const uint8_t *data, size_t len, uint8_t *out, size_t out_len);
+void hsh_blake3_keyed(const uint8_t key[HSH_BLAKE3_KEY_LEN], const uint8_t *data, size_t len,
+                      uint8_t *out, size_t out_len);
+
+#endif /* HSH_BLAKE3_H */
@@ -0,0 +1,73 @@
+#ifndef HSH_CDC_H
+#define HSH_CDC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HSH_CDC_DIGEST_SIZE 32
+#define HSH_CDC_MIN_LIMIT   64          /* smallest allowed min_size */
+#define HSH_CDC_MAX_LIMIT   (1u << 26)  /* largest allowed max_size (64 MiB) */
+
+/* ============================================
+ * Structures
+ * ============================================ */
+
+/* Digest computed for every chunk */
+typedef enum {
+    HSH_CDC_BLAKE2B_256,
+    HSH_CDC_SHA256
+} hsh_cdc_digest;
+
+typedef struct {
+    size_t min_size;          /* no cut before this many bytes */
+    size_t avg_size;          /* target size, rounded to a power of two */
+    size_t max_size;          /* forced cut here */
+    hsh_cdc_digest digest;
+} hsh_cdc_params;
+
+typedef struct {
+    uint64_t offset;          /* position in the whole stream */
+    size_t length;
+    uint8_t digest[HSH_CDC_DIGEST_SIZE];
+} hsh_cdc_chunk;
+
+/* Called once per chunk, in stream order, from the thread calling
+ * update / finalize. chunk->offset + data locate the bytes only for the
+ * duration of the call. */
+typedef void (*hsh_cdc_emit_fn)(void *arg, const hsh_cdc_chunk *chunk, const uint8_t *data);
+
+/*
+ * FastCDC content-defined chunker (Gear rolling hash with normalized
+ * chunking) fused with per-chunk digests. Chunks of each update() are cut
+ * and hashed while still in cache; with several worker threads
+ * (HSH_THREADS) the digests of a batch of chunks are computed in parallel.
+ * Only the bytes of an unfinished chunk are copied into the context.
+ */
+typedef struct {
+    hsh_cdc_params params;
+    uint64_t mask_s;          /* stricter mask below avg_size */
+    uint64_t mask_l;          /* looser mask above it */
+    hsh_cdc_emit_fn emit;
+    void *arg;
+    uint64_t offset;          /* stream offset of pending[0] */
+    uint8_t *pending;         /* unfinished chunk, max_size bytes */
+    size_t pending_len;
+    size_t scan_pos;          /* resume point of the cut search in pending */
+    uint64_t fp;              /* Gear hash at scan_pos */
+} hsh_cdc_ctx;
+
+/* ============================================
+ * Public API
+ * ============================================ */
+
+/* Returns -1 for sizes outside HSH_CDC_MIN_LIMIT <= min <= avg <= max <=
+ * HSH_CDC_MAX_LIMIT, or if the chunk buffer cannot be allocated */
+int hsh_cdc_init(hsh_cdc_ctx *ctx, const hsh_cdc_params *params, hsh_cdc_emit_fn emit, void *arg);
+
+void hsh_cdc_update(hsh_cdc_ctx *ctx, const uint8_t *data, size_t len);
+
+/* Emits the last chunk and frees the buffer; must be called once for
+ * every successful init */
+void hsh_cdc_finalize(hsh_cdc_ctx *ctx);
+
+#endif /* HSH_CDC_H */
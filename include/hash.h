@@ -0,0 +1,160 @@
+#ifndef HSH_HASH_H
+#define HSH_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "md5.h"
+#include "sha1.h"
+#include "sha2.h"
+#include "sha3.h"
+#include "blake2.h"
+#include "blake3.h"
+
+/* Largest digest_size / block_size of any registered algorithm */
+#define HSH_HASH_MAX_DIGEST 64
+#define HSH_HASH_MAX_BLOCK  168  /* SHAKE128 rate */
+
+/* ============================================
+ * Structures
+ * ============================================ */
+
+/*
+ * Algorithm descriptor. The entries are constant; the compression kernel
+ * behind them is picked from the CPU features at run time, and backend()
+ * names the one in use ("shani", "avx2", "sse41" or "generic"). Setting
+ * HSH_CPU in the environment restricts the features considered, e.g.
+ * HSH_CPU=none forces the generic code and HSH_CPU=sse2,ssse3,sse41 the
+ * SSE4.1 kernels. XOFs are registered with a fixed output length.
+ */
+typedef struct hsh_hash_alg {
+    const char *name;
+    size_t block_size;
+    size_t digest_size;
+    void (*init)(void *ctx);
+    void (*update)(void *ctx, const uint8_t *data, size_t len);
+    void (*finalize)(void *ctx, uint8_t *digest);
+    void (*oneshot)(const uint8_t *data, size_t len, uint8_t *digest);
+    const char *(*backend)(void);
+} hsh_hash_alg;
+
+/* Context able to hold the state of any registered algorithm */
+typedef struct {
+    const hsh_hash_alg *alg;
+    union {
+        hsh_md5_ctx md5;
+        hsh_sha1_ctx sha1;
+        hsh_sha2_256_ctx sha256;
+        hsh_sha2_512_ctx sha512;
+        hsh_sha3_ctx sha3;
+        hsh_blake2b_ctx blake2b;
+        hsh_blake2s_ctx blake2s;
+        hsh_blake2bp_ctx blake2bp;
+        hsh_blake2sp_ctx blake2sp;
+        hsh_blake3_ctx blake3;
+    } u;
+} hsh_hash_ctx;
+
+/* ============================================
+ * Registered algorithms
+ * ============================================ */
+
+extern const hsh_hash_alg hsh_hash_md5;
+extern const hsh_hash_alg hsh_hash_sha1;
+extern const hsh_hash_alg hsh_hash_sha224;
+extern const hsh_hash_alg hsh_hash_sha256;
+extern const hsh_hash_alg hsh_hash_sha384;
+extern const hsh_hash_alg hsh_hash_sha512;
+extern const hsh_hash_alg hsh_hash_sha3_224;
+extern const hsh_hash_alg hsh_hash_sha3_256;
+extern const hsh_hash_alg hsh_hash_sha3_384;
+extern const hsh_hash_alg hsh_hash_sha3_512;
+extern const hsh_hash_alg hsh_hash_shake128;   /* 32-byte output */
+extern const hsh_hash_alg hsh_hash_shake256;   /* 64-byte output */
+extern const hsh_hash_alg hsh_hash_blake2b;    /* BLAKE2b-512 */
+extern const hsh_hash_alg hsh_hash_blake2s;    /* BLAKE2s-256 */
+extern const hsh_hash_alg hsh_hash_blake2bp;
+extern const hsh_hash_alg hsh_hash_blake2sp;
+extern const hsh_hash_alg hsh_hash_blake3;     /* 32-byte output */
+
+/* ============================================
+ * Public API
+ * ============================================ */
+
+/* Lookup by name ("sha256", "sha3-256", "blake2b", ...), case-insensitive;
+ * NULL if unknown */
+const hsh_hash_alg *hsh_hash_find(const char *name);
+
+/* Iteration over the registry: index 0 .. hsh_hash_count() - 1 */
+size_t hsh_hash_count(void);
+const hsh_hash_alg *hsh_hash_get(size_t index);
+
+/* Name of the backend currently selected for alg */
+const char *hsh_hash_backend(const hsh_hash_alg *alg);
+
+void hsh_hash_init(hsh_hash_ctx *ctx, const hsh_hash_alg *alg);
+void hsh_hash_update(hsh_hash_ctx *ctx, const uint8_t *data, size_t len);
+/* Writes alg->digest_size bytes; ctx needs a new init before reuse */
+void hsh_hash_finalize(hsh_hash_ctx *ctx, uint8_t *digest);
+
+/* One-shot hashing of data[0..len) */
+void hsh_hash(const hsh_hash_alg *alg, const uint8_t *data, size_t len, uint8_t *digest);
+
+/* ============================================
+ * Multi-digest hashing
+ * ============================================ */
+
+#define HSH_HASH_MULTI_MAX 8
+
+/*
+ * Several algorithms over the same input in one pass. update() walks the
+ * input in tiles small enough to stay in cache and runs every algorithm
+ * over a tile before moving on, so memory is read once however many
+ * digests are wanted. With threads enabled, the algorithms of each tile
+ * are spread over the worker pool (HSH_THREADS, see hsh_pool_threads).
+ */
+typedef struct {
+    size_t count;
+    int threaded;
+    hsh_hash_ctx ctx[HSH_HASH_MULTI_MAX];
+} hsh_hash_multi_ctx;
+
+/* Returns -1 if count is 0 or above HSH_HASH_MULTI_MAX */
+int hsh_hash_multi_init(hsh_hash_multi_ctx *ctx, const hsh_hash_alg *const *algs, size_t count,
+                        int threaded);
+void hsh_hash_multi_update(hsh_hash_multi_ctx *ctx, const uint8_t *data, size_t len);
+/* digests[i] receives algs[i]->digest_size bytes */
+void hsh_hash_multi_finalize(hsh_hash_multi_ctx *ctx, uint8_t *const *digests);
+
+/* ============================================
+ * File hashing
+ * ============================================ */
+
+/* How the input was read */
+typedef enum {
+    HSH_HASH_FILE_MMAP,      /* regular file, mapped and hashed in place */
+    HSH_HASH_FILE_READ,      /* small regular file, plain read() loop */
+    HSH_HASH_FILE_PIPELINE   /* reader thread filling two buffers, so the
+                                next read overlaps hashing of the last one */
+} hsh_hash_file_strategy;
+
+typedef struct {
+    hsh_hash_file_strategy strategy;
+    uint64_t bytes;
+    double seconds;
+    double gbps;             /* bytes / seconds / 1e9 */
+} hsh_hash_file_stats;
+
+/* Hash everything from the current offset of fd to end of file; fd is left
+ * at end of file. Regular files of 64 KiB and more are mmap()ed, pipes,
+ * sockets and anything that cannot be mapped go through the pipeline.
+ * stats may be NULL. Returns 0, or -1 with errno set. A mapped file that
+ * is truncated while being hashed raises SIGBUS, as with any mmap. */
+int hsh_hash_fd(const hsh_hash_alg *alg, int fd, uint8_t *digest, hsh_hash_file_stats *stats);
+
+/* Same for a path, opened read-only */
+int hsh_hash_file(const hsh_hash_alg *alg, const char *path, uint8_t *digest,
+                  hsh_hash_file_stats *stats);
+
+const char *hsh_hash_file_strategy_name(hsh_hash_file_strategy strategy);
+
+#endif /* HSH_HASH_H */
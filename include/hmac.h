@@ -0,0 +1,74 @@
+#ifndef HSH_HMAC_H
+#define HSH_HMAC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sha1.h"
+#include "sha2.h"
+
+/* ============================================
+ * Structures
+ * ============================================ */
+
+/*
+ * HMAC (RFC 2104) over the SHA-1 / SHA-2 contexts. init runs the key
+ * schedule once: inner and outer hold the midstates after the ipad and
+ * opad blocks. A context fresh from init can be kept per key and copied
+ * (plain struct assignment) for every message, which saves the two key
+ * block compressions per MAC.
+ */
+typedef struct {
+    hsh_sha1_ctx inner;
+    hsh_sha1_ctx outer;
+} hsh_hmac_sha1_ctx;
+
+typedef struct {
+    hsh_sha2_256_ctx inner;
+    hsh_sha2_256_ctx outer;
+} hsh_hmac_sha256_ctx;
+
+typedef struct {
+    hsh_sha2_512_ctx inner;
+    hsh_sha2_512_ctx outer;
+} hsh_hmac_sha512_ctx;
+
+/* SHA-224 / SHA-384 share the layouts of their wider siblings */
+typedef hsh_hmac_sha256_ctx hsh_hmac_sha224_ctx;
+typedef hsh_hmac_sha512_ctx hsh_hmac_sha384_ctx;
+
+/* ============================================
+ * Public API
+ * ============================================ */
+
+/* Keys longer than the block size are hashed first, as the RFC requires.
+ * finalize leaves ctx unusable until the next init or copy. */
+void hsh_hmac_sha1_init(hsh_hmac_sha1_ctx *ctx, const uint8_t *key, size_t key_len);
+void hsh_hmac_sha1_update(hsh_hmac_sha1_ctx *ctx, const uint8_t *data, size_t len);
+void hsh_hmac_sha1_finalize(hsh_hmac_sha1_ctx *ctx, uint8_t mac[20]);
+
+void hsh_hmac_sha224_init(hsh_hmac_sha224_ctx *ctx, const uint8_t *key, size_t key_len);
+void hsh_hmac_sha224_update(hsh_hmac_sha224_ctx *ctx, const uint8_t *data, size_t len);
+void hsh_hmac_sha224_finalize(hsh_hmac_sha224_ctx *ctx, uint8_t mac[28]);
+
+void hsh_hmac_sha256_init(hsh_hmac_sha256_ctx *ctx, const uint8_t *key, size_t key_len);
+void hsh_hmac_sha256_update(hsh_hmac_sha256_ctx *ctx, const uint8_t *data, size_t len);
+void hsh_hmac_sha256_finalize(hsh_hmac_sha256_ctx *ctx, uint8_t mac[32]);
+
+void hsh_hmac_sha384_init(hsh_hmac_sha384_ctx *ctx, const uint8_t *key, size_t key_len);
+void hsh_hmac_sha384_update(hsh_hmac_sha384_ctx *ctx, const uint8_t *data, size_t len);
+void hsh_hmac_sha384_finalize(hsh_hmac_sha384_ctx *ctx, uint8_t mac[48]);
+
+void hsh_hmac_sha512_init(hsh_hmac_sha512_ctx *ctx, const uint8_t *key, size_t key_len);
+void hsh_hmac_sha512_update(hsh_hmac_sha512_ctx *ctx, const uint8_t *data, size_t len);
+void hsh_hmac_sha512_finalize(hsh_hmac_sha512_ctx *ctx, uint8_t mac[64]);
+
+/* One message with an already initialized key context, which is left
+ * untouched: the per-message cost is the message blocks plus one outer
+ * compression */
+void hsh_hmac_sha1(const hsh_hmac_sha1_ctx *key, const uint8_t *data, size_t len, uint8_t mac[20]);
+void hsh_hmac_sha224(const hsh_hmac_sha224_ctx *key, const uint8_t *data, size_t len, uint8_t mac[28]);
+void hsh_hmac_sha256(const hsh_hmac_sha256_ctx *key, const uint8_t *data, size_t len, uint8_t mac[32]);
+void hsh_hmac_sha384(const hsh_hmac_sha384_ctx *key, const uint8_t *data, size_t len, uint8_t mac[48]);
+void hsh_hmac_sha512(const hsh_hmac_sha512_ctx *key, const uint8_t *data, size_t len, uint8_t mac[64]);
+
+#endif /* HSH_HMAC_H */
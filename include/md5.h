@@ -17,4 +17,12 @@ void hsh_md5_init(hsh_md5_ctx *ctx);
 void hsh_md5_update(hsh_md5_ctx *ctx, const unsigned char *data, size_t len);
 void hsh_md5_finalize(hsh_md5_ctx *ctx, unsigned char digest[16]);
 
+/* One-shot hash of data[0..len), no context needed */
+void hsh_md5(const unsigned char *data, size_t len, unsigned char digest[16]);
+
+/* Hash count independent messages (data[i], lens[i]) in SIMD lanes;
+ * digest i is written to digests + 16 * i */
+void hsh_md5_batch(const unsigned char *const *data, const size_t *lens,
+                   size_t count, unsigned char *digests);
+
 #endif /* HSH_MD5_H */
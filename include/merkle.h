@@ -0,0 +1,92 @@
+#ifndef HSH_MERKLE_H
+#define HSH_MERKLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HSH_MERKLE_DIGEST_SIZE 32
+#define HSH_MERKLE_MAX_DEPTH   40   /* 2^40 leaves */
+
+/* ============================================
+ * Structures
+ * ============================================ */
+
+/*
+ * SHA-256 Merkle tree over a fixed number of leaves (e.g. the 4 KiB pages
+ * of a device) that keeps every interior node, so changing a leaf only
+ * rehashes its path to the root.
+ *
+ * Hashes are domain separated as in RFC 6962: a leaf is SHA-256(0x00 ||
+ * data) and a node SHA-256(0x01 || left || right). The tree is padded to
+ * a power of two; a leaf that was never written, including the padding,
+ * has an all-zero digest.
+ *
+ * Nodes are stored as one array in heap order: nodes[1] is the root, the
+ * children of node i are 2i and 2i + 1 and leaf k is node capacity + k.
+ * Siblings share a 64-byte cache line and the upper levels, which every
+ * path crosses, sit together at the front. Slot 0 holds a header, so the
+ * array can be mapped from a file as is.
+ */
+typedef struct {
+    uint8_t (*nodes)[HSH_MERKLE_DIGEST_SIZE];
+    uint64_t leaves;
+    uint64_t capacity;        /* leaves rounded up to a power of two */
+    size_t depth;             /* log2(capacity): siblings in a proof */
+    size_t map_len;
+    int fd;                   /* backing file, -1 in memory */
+} hsh_merkle_tree;
+
+/* One leaf of a batch update */
+typedef struct {
+    uint64_t index;
+    const uint8_t *data;
+    size_t len;
+} hsh_merkle_leaf;
+
+/* ============================================
+ * Public API
+ * ============================================ */
+
+/* In-memory tree with all leaves unset. Returns -1 if leaves is 0 or above
+ * 2^HSH_MERKLE_MAX_DEPTH, or memory cannot be mapped. */
+int hsh_merkle_init(hsh_merkle_tree *tree, uint64_t leaves);
+
+/* Tree stored in the file at path. A new or empty file is created for
+ * `leaves` leaves; an existing one is used as is (its nodes are trusted)
+ * and must hold the same leaf count, or any if leaves is 0. Changes reach
+ * the file through a shared mapping; hsh_merkle_sync() flushes them.
+ * Returns -1 with errno set on failure (EINVAL for a mismatched file). */
+int hsh_merkle_open(hsh_merkle_tree *tree, const char *path, uint64_t leaves);
+
+int hsh_merkle_sync(hsh_merkle_tree *tree);
+
+/* Unmaps the node store and closes the file, if any */
+void hsh_merkle_close(hsh_merkle_tree *tree);
+
+/* Replace leaf index with data[0..len) and rehash its path. Returns -1 if
+ * index is out of range. */
+int hsh_merkle_update(hsh_merkle_tree *tree, uint64_t index, const uint8_t *data, size_t len);
+
+/* Replace several leaves, then rehash every affected node once, level by
+ * level; large batches are hashed on worker threads. If an index repeats,
+ * the last entry wins. Returns -1 (tree unchanged) if an index is out of
+ * range or memory runs out. */
+int hsh_merkle_update_batch(hsh_merkle_tree *tree, const hsh_merkle_leaf *leaves, size_t count);
+
+void hsh_merkle_root(const hsh_merkle_tree *tree, uint8_t root[HSH_MERKLE_DIGEST_SIZE]);
+
+/* Leaf digest as stored in the tree: SHA-256(0x00 || data) */
+void hsh_merkle_leaf_hash(const uint8_t *data, size_t len, uint8_t digest[HSH_MERKLE_DIGEST_SIZE]);
+
+/* Inclusion proof for leaf index: tree->depth sibling digests, from the
+ * leaf's sibling up to the root's children. Returns -1 if out of range. */
+int hsh_merkle_proof(const hsh_merkle_tree *tree, uint64_t index,
+                     uint8_t proof[][HSH_MERKLE_DIGEST_SIZE]);
+
+/* 1 if leaf_digest at index, with the depth siblings in proof, leads to
+ * root, else 0 */
+int hsh_merkle_verify(const uint8_t root[HSH_MERKLE_DIGEST_SIZE], uint64_t index,
+                      const uint8_t leaf_digest[HSH_MERKLE_DIGEST_SIZE],
+                      const uint8_t proof[][HSH_MERKLE_DIGEST_SIZE], size_t depth);
+
+#endif /* HSH_MERKLE_H */
@@ -19,4 +19,7 @@ void hsh_sha1_init(hsh_sha1_ctx *ctx);
 void hsh_sha1_update(hsh_sha1_ctx *ctx, const uint8_t *data, size_t len);
 void hsh_sha1_finalize(hsh_sha1_ctx *ctx, uint8_t digest[HSH_SHA1_DIGEST_SIZE]);
 
+/* One-shot hash of data[0..len), no context needed */
+void hsh_sha1(const uint8_t *data, size_t len, uint8_t digest[HSH_SHA1_DIGEST_SIZE]);
+
 #endif
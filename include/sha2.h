@@ -26,6 +26,17 @@ typedef struct {
 /* SHA-384 context is typedef alias of SHA-512 context */
 typedef hsh_sha2_512_ctx hsh_sha2_384_ctx;
 
+/* SHA-256 tree hash context (AWS Glacier / S3 layout) */
+#define HSH_SHA2_TREE_MAX_DEPTH 64
+typedef struct {
+    hsh_sha2_256_ctx leaf;    /* partly filled leaf */
+    size_t leaf_size;
+    size_t leaf_fill;         /* bytes in the current leaf */
+    uint64_t leaves;          /* completed leaves */
+    size_t stack_len;         /* digests of complete subtrees, largest first */
+    unsigned char stack[HSH_SHA2_TREE_MAX_DEPTH][32];
+} hsh_sha2_256_tree_ctx;
+
 
 /* Public APIs for SHA-224/256 */
 void hsh_sha2_256_init(hsh_sha2_256_ctx *ctx);
@@ -43,4 +54,34 @@ void hsh_sha2_384_update(hsh_sha2_384_ctx *ctx, const unsigned char *data, size_
 void hsh_sha2_512_finalize(hsh_sha2_512_ctx *ctx, unsigned char *digest);
 void hsh_sha2_384_finalize(hsh_sha2_384_ctx *ctx, unsigned char *digest);
 
+/* One-shot APIs: hash data[0..len) without a context. Inputs shorter than
+ * one block are padded and compressed directly on the stack. */
+void hsh_sha2_256(const unsigned char *data, size_t len, unsigned char *digest);
+void hsh_sha2_224(const unsigned char *data, size_t len, unsigned char *digest);
+void hsh_sha2_512(const unsigned char *data, size_t len, unsigned char *digest);
+void hsh_sha2_384(const unsigned char *data, size_t len, unsigned char *digest);
+
+/* Batch APIs: hash count independent messages of any lengths in one call.
+ * Message i is data[i][0..lens[i]) and its digest is written to
+ * digests + i * (digest size). Uses multi-buffer SIMD lanes when available. */
+void hsh_sha2_256_batch(const unsigned char *const *data, const size_t *lens,
+                        size_t count, unsigned char *digests);
+void hsh_sha2_224_batch(const unsigned char *const *data, const size_t *lens,
+                        size_t count, unsigned char *digests);
+void hsh_sha2_512_batch(const unsigned char *const *data, const size_t *lens,
+                        size_t count, unsigned char *digests);
+void hsh_sha2_384_batch(const unsigned char *const *data, const size_t *lens,
+                        size_t count, unsigned char *digests);
+
+/* SHA-256 tree hash: the input is cut into leaf_size byte leaves (the last
+ * may be shorter), every leaf is hashed with SHA-256 and adjacent digests
+ * are hashed together level by level, an odd one out moving up unchanged.
+ * With a 1 MiB leaf size this is the AWS Glacier / S3 tree hash. Leaves are
+ * hashed concurrently on worker threads. Init returns -1 for leaf_size 0. */
+#define HSH_SHA2_TREE_GLACIER_LEAF (1024 * 1024)
+int hsh_sha2_256_tree_init(hsh_sha2_256_tree_ctx *ctx, size_t leaf_size);
+void hsh_sha2_256_tree_update(hsh_sha2_256_tree_ctx *ctx, const unsigned char *data, size_t len);
+void hsh_sha2_256_tree_finalize(hsh_sha2_256_tree_ctx *ctx, unsigned char *digest);
+int hsh_sha2_256_tree(const unsigned char *data, size_t len, size_t leaf_size, unsigned char *digest);
+
 #endif /* HSH_SHA2_H */
@@ -19,6 +19,10 @@ typedef struct {
     int output_bits;
 } hsh_sha3_ctx;
 
+// SHAKE128/256 share the Keccak context; once squeezing starts buf_len
+// is the read cursor into the current output block
+typedef hsh_sha3_ctx hsh_shake_ctx;
+
 // ==== User-callable initialization ====
 void hsh_sha3_224_init(hsh_sha3_ctx *ctx);
 void hsh_sha3_256_init(hsh_sha3_ctx *ctx);
@@ -29,5 +33,29 @@ void hsh_sha3_512_init(hsh_sha3_ctx *ctx);
 void hsh_sha3_update(hsh_sha3_ctx *ctx, const uint8_t *data, size_t len);
 void hsh_sha3_finalize(hsh_sha3_ctx *ctx, uint8_t *out);
 
+// ==== SHAKE128/256 extendable output ====
+// squeeze may be called any number of times; consecutive calls continue
+// the same output stream. Update after the first squeeze is ignored.
+void hsh_shake128_init(hsh_shake_ctx *ctx);
+void hsh_shake256_init(hsh_shake_ctx *ctx);
+void hsh_shake_update(hsh_shake_ctx *ctx, const uint8_t *data, size_t len);
+void hsh_shake_squeeze(hsh_shake_ctx *ctx, uint8_t *out, size_t len);
+
+// ==== One-shot hashing ====
+// Hash data[0..len) in one call without a caller-side context
+void hsh_sha3_224(const uint8_t *data, size_t len, uint8_t *out);
+void hsh_sha3_256(const uint8_t *data, size_t len, uint8_t *out);
+void hsh_sha3_384(const uint8_t *data, size_t len, uint8_t *out);
+void hsh_sha3_512(const uint8_t *data, size_t len, uint8_t *out);
+void hsh_shake128(const uint8_t *data, size_t len, uint8_t *out, size_t out_len);
+void hsh_shake256(const uint8_t *data, size_t len, uint8_t *out, size_t out_len);
+
+// ==== Batch hashing of independent messages ====
+// Message i is data[i][0..lens[i]); its digest goes to digests + i * (digest size)
+void hsh_sha3_224_batch(const uint8_t *const *data, const size_t *lens, size_t count, uint8_t *digests);
+void hsh_sha3_256_batch(const uint8_t *const *data, const size_t *lens, size_t count, uint8_t *digests);
+void hsh_sha3_384_batch(const uint8_t *const *data, const size_t *lens, size_t count, uint8_t *digests);
+void hsh_sha3_512_batch(const uint8_t *const *data, const size_t *lens, size_t count, uint8_t *digests);
+
 #endif
 
@@ -0,0 +1,67 @@
+#ifndef HSH_STATE_H
+#define HSH_STATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "md5.h"
+#include "sha1.h"
+#include "sha2.h"
+#include "sha3.h"
+#include "blake2.h"
+
+/*
+ * Portable snapshots of hashing contexts, e.g. to checkpoint a long upload
+ * and resume it on another machine. A snapshot starts with the bytes
+ * 'h' 's', the format version and the context type, followed by the
+ * context fields in a fixed order, all integers little-endian. Unused
+ * buffer bytes are written as zero, so equal states give equal snapshots.
+ *
+ * Within one process a plain struct copy is enough to fork a state (for
+ * example to hash a shared prefix once and finish it with many suffixes).
+ */
+
+#define HSH_STATE_VERSION 1
+
+/* Context type byte */
+#define HSH_STATE_MD5      1
+#define HSH_STATE_SHA1     2
+#define HSH_STATE_SHA2_256 3   /* SHA-224 and SHA-256 */
+#define HSH_STATE_SHA2_512 4   /* SHA-384 and SHA-512 */
+#define HSH_STATE_SHA3     5   /* SHA3-* and SHAKE, including squeezing */
+#define HSH_STATE_BLAKE2B  6
+#define HSH_STATE_BLAKE2S  7
+
+/* Snapshot sizes in bytes */
+#define HSH_STATE_SIZE_MD5      93
+#define HSH_STATE_SIZE_SHA1     97
+#define HSH_STATE_SIZE_SHA2_256 109
+#define HSH_STATE_SIZE_SHA2_512 205
+#define HSH_STATE_SIZE_SHA3     411
+#define HSH_STATE_SIZE_BLAKE2B  279
+#define HSH_STATE_SIZE_BLAKE2S  143
+#define HSH_STATE_SIZE_MAX      411
+
+/* serialize writes exactly HSH_STATE_SIZE_<type> bytes. deserialize returns 0,
+ * or -1 (leaving ctx untouched) if len, header or any field is invalid. */
+void hsh_md5_serialize(const hsh_md5_ctx *ctx, uint8_t out[HSH_STATE_SIZE_MD5]);
+int hsh_md5_deserialize(hsh_md5_ctx *ctx, const uint8_t *in, size_t len);
+
+void hsh_sha1_serialize(const hsh_sha1_ctx *ctx, uint8_t out[HSH_STATE_SIZE_SHA1]);
+int hsh_sha1_deserialize(hsh_sha1_ctx *ctx, const uint8_t *in, size_t len);
+
+void hsh_sha2_256_serialize(const hsh_sha2_256_ctx *ctx, uint8_t out[HSH_STATE_SIZE_SHA2_256]);
+int hsh_sha2_256_deserialize(hsh_sha2_256_ctx *ctx, const uint8_t *in, size_t len);
+
+void hsh_sha2_512_serialize(const hsh_sha2_512_ctx *ctx, uint8_t out[HSH_STATE_SIZE_SHA2_512]);
+int hsh_sha2_512_deserialize(hsh_sha2_512_ctx *ctx, const uint8_t *in, size_t len);
+
+void hsh_sha3_serialize(const hsh_sha3_ctx *ctx, uint8_t out[HSH_STATE_SIZE_SHA3]);
+int hsh_sha3_deserialize(hsh_sha3_ctx *ctx, const uint8_t *in, size_t len);
+
+void hsh_blake2b_serialize(const hsh_blake2b_ctx *ctx, uint8_t out[HSH_STATE_SIZE_BLAKE2B]);
+int hsh_blake2b_deserialize(hsh_blake2b_ctx *ctx, const uint8_t *in, size_t len);
+
+void hsh_blake2s_serialize(const hsh_blake2s_ctx *ctx, uint8_t out[HSH_STATE_SIZE_BLAKE2S]);
+int hsh_blake2s_deserialize(hsh_blake2s_ctx *ctx, const uint8_t *in, size_t len);
+
+#endif /* HSH_STATE_H */
@@ -0,0 +1,102 @@
+#include "batch_internal.h"
+
+/* Lanes with no message compress this block; their results are discarded */
+static const unsigned char hsh_batch_zero_block[HSH_BATCH_MAX_BLOCK];
+
+typedef struct {
+    const unsigned char *next;  /* next full block inside the message */
+    size_t full_blocks;         /* full message blocks left */
+    unsigned char tail[2 * HSH_BATCH_MAX_BLOCK];  /* padded final block(s) */
+    size_t tail_blocks;         /* padded blocks left */
+    size_t tail_total;          /* padded blocks in tail */
+    size_t msg;                 /* index of the message in the batch */
+    int active;
+} hsh_batch_lane;
+
+static void hsh_batch_lane_load(const hsh_batch_engine *e, hsh_batch_lane *lane, size_t l,
+                                const unsigned char *data, size_t len, size_t msg) {
+    size_t full = len / e->block_size;
+    lane->next = data;
+    lane->full_blocks = full;
+    lane->tail_total = e->pad(e->arg, lane->tail, data + full * e->block_size,
+                              len % e->block_size, (uint64_t)len);
+    lane->tail_blocks = lane->tail_total;
+    lane->msg = msg;
+    lane->active = 1;
+    e->reset(e->arg, l);
+}
+
+static const unsigned char *hsh_batch_lane_next(const hsh_batch_engine *e, hsh_batch_lane *lane) {
+    const unsigned char *p;
+    if (lane->full_blocks > 0) {
+        p = lane->next;
+        lane->next += e->block_size;
+        lane->full_blocks--;
+    } else {
+        p = lane->tail + (lane->tail_total - lane->tail_blocks) * e->block_size;
+        lane->tail_blocks--;
+    }
+    return p;
+}
+
+/* Finish a lane's remaining blocks with the single-stream compressor */
+static void hsh_batch_lane_finish(const hsh_batch_engine *e, hsh_batch_lane *lane, size_t l,
+                                  unsigned char *digests) {
+    e->compress(e->arg, l, lane->next, lane->full_blocks);
+    e->compress(e->arg, l, lane->tail + (lane->tail_total - lane->tail_blocks) * e->block_size,
+                lane->tail_blocks);
+    e->store(e->arg, l, digests + lane->msg * e->digest_size);
+}
+
+void hsh_batch_run(const hsh_batch_engine *e, const unsigned char *const *data,
+                   const size_t *lens, size_t count, unsigned char *digests) {
+    hsh_batch_lane lanes[HSH_BATCH_MAX_LANES];
+    const unsigned char *blocks[HSH_BATCH_MAX_LANES];
+    size_t pending = 0, active = 0;
+    size_t l;
+
+    if (!e->kernel || count < 2) {
+        for (pending = 0; pending < count; pending++) {
+            hsh_batch_lane_load(e, &lanes[0], 0, data[pending], lens[pending], pending);
+            hsh_batch_lane_finish(e, &lanes[0], 0, digests);
+        }
+        return;
+    }
+
+    for (l = 0; l < e->lanes; l++) {
+        lanes[l].active = 0;
+        if (pending < count) {
+            hsh_batch_lane_load(e, &lanes[l], l, data[pending], lens[pending], pending);
+            pending++;
+            active++;
+        } else {
+            e->reset(e->arg, l);
+        }
+    }
+
+    /* Once a single lane is left with nothing to refill it, a single-stream
+     * finish is cheaper than running the kernel for it alone */
+    while (active > 1 || (active == 1 && pending < count)) {
+        for (l = 0; l < e->lanes; l++)
+            blocks[l] = lanes[l].active ? hsh_batch_lane_next(e, &lanes[l]) : hsh_batch_zero_block;
+
+        e->kernel(e->arg, blocks);
+
+        for (l = 0; l < e->lanes; l++) {
+            hsh_batch_lane *lane = &lanes[l];
+            if (!lane->active || lane->full_blocks > 0 || lane->tail_blocks > 0) continue;
+            e->store(e->arg, l, digests + lane->msg * e->digest_size);
+            lane->active = 0;
+            active--;
+            if (pending < count) {
+                hsh_batch_lane_load(e, lane, l, data[pending], lens[pending], pending);
+                pending++;
+                active++;
+            }
+        }
+    }
+
+    for (l = 0; l < e->lanes; l++) {
+        if (lanes[l].active) hsh_batch_lane_finish(e, &lanes[l], l, digests);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef HSH_BATCH_INTERNAL_H
+#define HSH_BATCH_INTERNAL_H
+
+/* Internal: the lane scheduler shared by the multi-buffer batch APIs. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HSH_BATCH_MAX_LANES 8
+#define HSH_BATCH_MAX_BLOCK 168   /* SHAKE128 rate; SHA-512 blocks are 128 */
+
+/*
+ * One multi-buffer engine. The callbacks all get arg, which holds the lane
+ * states in whatever layout the kernel wants; a lane is addressed by its
+ * index. Every message is fed as its whole blocks straight from the caller
+ * followed by the 1 or 2 padded blocks pad writes for its tail.
+ */
+typedef struct {
+    size_t lanes;        /* lanes per kernel call, at most HSH_BATCH_MAX_LANES */
+    size_t block_size;   /* at most HSH_BATCH_MAX_BLOCK */
+    size_t digest_size;
+    void *arg;
+
+    /* Write the padded final block(s) for a len-byte message ending in
+     * tail[0..tail_len) (tail_len < block_size); returns the block count */
+    size_t (*pad)(void *arg, unsigned char *out, const unsigned char *tail, size_t tail_len,
+                  uint64_t len);
+    /* One block per lane; NULL hashes every message on its own */
+    void (*kernel)(void *arg, const unsigned char *const *blocks);
+    /* Start a lane on a new message */
+    void (*reset)(void *arg, size_t lane);
+    /* Single-stream compression of nblocks consecutive blocks into a lane */
+    void (*compress)(void *arg, size_t lane, const unsigned char *data, size_t nblocks);
+    /* Write the digest of a lane whose message is complete */
+    void (*store)(void *arg, size_t lane, unsigned char *digest);
+} hsh_batch_engine;
+
+/* Hash data[i][0..lens[i]) into digests + i * digest_size for i < count.
+ * Each lane is refilled with the next pending message as soon as its own
+ * is finished, so messages of different lengths share the kernel calls. */
+void hsh_batch_run(const hsh_batch_engine *engine, const unsigned char *const *data,
+                   const size_t *lens, size_t count, unsigned char *digests);
+
+#endif /* HSH_BATCH_INTERNAL_H */
@@ -1,25 +1,26 @@
 #include "blake2.h"
+#include "blake2_internal.h"
 #include <string.h>
 
 /* ============================================
  * Private constants
  * ============================================ */
 
-static const uint64_t HSH_BLAKE2B_IV[8] = {
+const uint64_t HSH_BLAKE2B_IV[8] = {
     0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
     0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
     0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
     0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
 };
 
-static const uint32_t HSH_BLAKE2S_IV[8] = {
+const uint32_t HSH_BLAKE2S_IV[8] = {
     0x6A09E667UL, 0xBB67AE85UL,
     0x3C6EF372UL, 0xA54FF53AUL,
     0x510E527FUL, 0x9B05688CUL,
     0x1F83D9ABUL, 0x5BE0CD19UL
 };
 
-static const uint8_t HSH_BLAKE2_SIGMA[10][16] = {
+const uint8_t HSH_BLAKE2_SIGMA[10][16] = {
     {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15},
     {14,10,4,8,9,15,13,6,1,12,0,2,11,7,5,3},
     {11,8,12,0,5,2,15,13,10,14,3,6,7,1,9,4},
@@ -37,7 +38,6 @@ static const uint8_t HSH_BLAKE2_SIGMA[10][16] = {
  * ============================================ */
 
 #define ROTR64(x,n) (((x) >> (n)) | ((x) << (64 - (n))))
-#define ROTR32(x,n) (((x) >> (n)) | ((x) << (32 - (n))))
 
 /* ============================================
  * BLAKE2b (64-bit) Private Helper Functions
@@ -56,9 +56,9 @@ static void hsh_blake2b_G(uint64_t v[16], int a, int b, int c, int d,
     v[b] = ROTR64(v[b] ^ v[c], 63);
 }
 
-static void hsh_blake2b_compress(hsh_blake2b_ctx *ctx,
-                                 const uint8_t block[128],
-                                 int is_last)
+static void hsh_blake2b_compress_generic(hsh_blake2b_ctx *ctx,
+                                         const uint8_t block[128],
+                                         int flags)
 {
     uint64_t m[16];
     uint64_t v[16];
@@ -68,7 +68,8 @@ static void hsh_blake2b_compress(hsh_blake2b_ctx *ctx,
 
     v[12] ^= ctx->t_low;
     v[13] ^= ctx->t_high;
-    if (is_last) v[14] ^= 0xFFFFFFFFFFFFFFFFULL;
+    if (flags & HSH_BLAKE2_LAST_BLOCK) v[14] ^= 0xFFFFFFFFFFFFFFFFULL;
+    if (flags & HSH_BLAKE2_LAST_NODE) v[15] ^= 0xFFFFFFFFFFFFFFFFULL;
 
     for (int r = 0; r < 12; r++) {
         const uint8_t *s = HSH_BLAKE2_SIGMA[r % 10];
@@ -86,17 +87,65 @@ static void hsh_blake2b_compress(hsh_blake2b_ctx *ctx,
         ctx->h[i] ^= v[i] ^ v[i + 8];
 }
 
-int hsh_blake2b_init(hsh_blake2b_ctx *ctx, size_t digest_size,
-                     const uint8_t *key, size_t key_len,
-                     const uint8_t *personal, size_t pers_len)
+static void hsh_blake2b_compress(hsh_blake2b_ctx *ctx,
+                                 const uint8_t block[128],
+                                 int flags)
+{
+#if HSH_X86
+    if (hsh_cpu_features() & HSH_CPU_AVX2) {
+        hsh_blake2b_compress_avx2(ctx, block, flags);
+        return;
+    }
+#endif
+    hsh_blake2b_compress_generic(ctx, block, flags);
+}
+
+/* Compress nblocks whole, non-final blocks, advancing the counter per block */
+static void hsh_blake2b_process_blocks(hsh_blake2b_ctx *ctx, const uint8_t *data, size_t nblocks)
+{
+    if (nblocks == 0) return;
+#if HSH_X86
+    if (hsh_cpu_features() & HSH_CPU_AVX2) {
+        hsh_blake2b_blocks_avx2(ctx, data, nblocks);
+        return;
+    }
+#endif
+    for (; nblocks > 0; nblocks--, data += 128) {
+        /* Increment 128-bit counter */
+        ctx->t_low += 128;
+        if (ctx->t_low < 128)  /* overflow */
+            ctx->t_high++;
+        hsh_blake2b_compress_generic(ctx, data, 0);
+    }
+}
+
+/* Compress the full buffer as a non-final block */
+static void hsh_blake2b_compress_buffer(hsh_blake2b_ctx *ctx)
+{
+    if (ctx->key_pending) {
+        memcpy(ctx->h, ctx->key_h, sizeof(ctx->h));
+        ctx->t_low += 128;
+        ctx->key_pending = 0;
+    } else {
+        hsh_blake2b_process_blocks(ctx, ctx->buffer, 1);
+    }
+}
+
+int hsh_blake2b_init_tree(hsh_blake2b_ctx *ctx, size_t digest_size,
+                          const uint8_t *key, size_t key_len,
+                          const uint8_t *personal, size_t pers_len,
+                          const hsh_blake2_tree *tree)
 {
     if (digest_size == 0 || digest_size > 64) return -1;
     if (key_len > 64) return -1;
     if (pers_len > 16) return -1;
 
     memcpy(ctx->h, HSH_BLAKE2B_IV, sizeof(HSH_BLAKE2B_IV));
-    uint64_t param = 0x01010000UL ^ ((uint64_t)key_len << 8) ^ digest_size;
+    uint64_t param = ((uint64_t)tree->depth << 24) ^ ((uint64_t)tree->fanout << 16) ^
+                     ((uint64_t)key_len << 8) ^ digest_size;
     ctx->h[0] ^= param;
+    ctx->h[1] ^= tree->node_offset;
+    ctx->h[2] ^= ((uint64_t)tree->inner_length << 8) ^ tree->node_depth;
 
     if (personal && pers_len > 0) {
         uint8_t buf[16] = {0};
@@ -113,67 +162,113 @@ int hsh_blake2b_init(hsh_blake2b_ctx *ctx, size_t digest_size,
     ctx->buffer_len = 0;
     ctx->digest_size = digest_size;
 
+    ctx->key_pending = 0;
     if (key && key_len > 0) {
-        uint8_t block[128] = {0};
-        memcpy(block, key, key_len);
-        hsh_blake2b_update(ctx, block, 128);
+        uint64_t h0[8];
+        memset(ctx->buffer, 0, sizeof(ctx->buffer));
+        memcpy(ctx->buffer, key, key_len);
+        ctx->buffer_len = 128;
+
+        /* The key block stays buffered in case the message is empty (it is
+         * then the final block); its non-final compression is done now */
+        memcpy(h0, ctx->h, sizeof(h0));
+        hsh_blake2b_process_blocks(ctx, ctx->buffer, 1);
+        memcpy(ctx->key_h, ctx->h, sizeof(ctx->key_h));
+        memcpy(ctx->h, h0, sizeof(h0));
+        ctx->t_low = 0;
+        ctx->key_pending = 1;
     }
 
     return 0;
 }
 
+int hsh_blake2b_init(hsh_blake2b_ctx *ctx, size_t digest_size,
+                     const uint8_t *key, size_t key_len,
+                     const uint8_t *personal, size_t pers_len)
+{
+    static const hsh_blake2_tree sequential = {1, 1, 0, 0, 0};
+    return hsh_blake2b_init_tree(ctx, digest_size, key, key_len, personal, pers_len, &sequential);
+}
+
 void hsh_blake2b_update(hsh_blake2b_ctx *ctx, const uint8_t *data, size_t len)
 {
-    size_t offset = 0;
-    while (offset < len) {
-        size_t space = 128 - ctx->buffer_len;
-        size_t take = (len - offset > space) ? space : len - offset;
-        memcpy(ctx->buffer + ctx->buffer_len, data + offset, take);
-        ctx->buffer_len += take;
-        offset += take;
-
-        if (ctx->buffer_len == 128) {
-            /* Increment 128-bit counter */
-            ctx->t_low += 128;
-            if (ctx->t_low < 128)  /* overflow */
-                ctx->t_high++;
-            hsh_blake2b_compress(ctx, ctx->buffer, 0);
-            ctx->buffer_len = 0;
-        }
+    if (len == 0) return;
+
+    /* A full block is only compressed once more input follows, since
+     * finalize must compress the final block with the last-block flag */
+    size_t space = 128 - ctx->buffer_len;
+    if (len > space) {
+        memcpy(ctx->buffer + ctx->buffer_len, data, space);
+        hsh_blake2b_compress_buffer(ctx);
+        ctx->buffer_len = 0;
+        data += space;
+        len -= space;
+
+        /* Compress straight from the caller's memory, keeping the last
+         * (possibly full) block back in the buffer */
+        size_t nblocks = (len - 1) / 128;
+        hsh_blake2b_process_blocks(ctx, data, nblocks);
+        data += nblocks * 128;
+        len -= nblocks * 128;
     }
+
+    memcpy(ctx->buffer + ctx->buffer_len, data, len);
+    ctx->buffer_len += len;
 }
 
-void hsh_blake2b_finalize(hsh_blake2b_ctx *ctx, uint8_t *digest)
+void hsh_blake2b_finalize_node(hsh_blake2b_ctx *ctx, uint8_t *digest, int last_node)
 {
     ctx->t_low += ctx->buffer_len;
     if (ctx->t_low < ctx->buffer_len)
         ctx->t_high++;
     uint8_t block[128] = {0};
     memcpy(block, ctx->buffer, ctx->buffer_len);
-    hsh_blake2b_compress(ctx, block, 1);
+    hsh_blake2b_compress(ctx, block, HSH_BLAKE2_LAST_BLOCK | (last_node ? HSH_BLAKE2_LAST_NODE : 0));
     memcpy(digest, ctx->h, ctx->digest_size);
 }
 
-/* ============================================
- * BLAKE2s (32-bit)
- * ============================================ */
+void hsh_blake2b_finalize(hsh_blake2b_ctx *ctx, uint8_t *digest)
+{
+    hsh_blake2b_finalize_node(ctx, digest, 0);
+}
 
-static void hsh_blake2s_G(uint32_t v[16], int a, int b, int c, int d,
-                          uint32_t x, uint32_t y)
+/* One-shot: everything but the final block is compressed straight from data
+ * and the final block is zero-padded on the stack, so the context buffer is
+ * only used for the key block */
+int hsh_blake2b(const uint8_t *data, size_t len, uint8_t *digest, size_t digest_size,
+                const uint8_t *key, size_t key_len)
 {
-    v[a] = v[a] + v[b] + x;
-    v[d] = ROTR32(v[d] ^ v[a], 16);
-    v[c] = v[c] + v[d];
-    v[b] = ROTR32(v[b] ^ v[c], 12);
-    v[a] = v[a] + v[b] + y;
-    v[d] = ROTR32(v[d] ^ v[a], 8);
-    v[c] = v[c] + v[d];
-    v[b] = ROTR32(v[b] ^ v[c], 7);
+    hsh_blake2b_ctx ctx;
+    uint8_t last[128] = {0};
+
+    if (hsh_blake2b_init(&ctx, digest_size, key, key_len, NULL, 0) != 0) return -1;
+
+    if (len > 0) {
+        size_t nblocks = (len - 1) / 128;
+        if (ctx.buffer_len > 0)
+            hsh_blake2b_compress_buffer(&ctx);
+        hsh_blake2b_process_blocks(&ctx, data, nblocks);
+        ctx.buffer_len = len - nblocks * 128;
+        memcpy(last, data + nblocks * 128, ctx.buffer_len);
+    } else if (ctx.buffer_len > 0) {
+        memcpy(last, ctx.buffer, 128);
+    }
+
+    ctx.t_low += ctx.buffer_len;
+    if (ctx.t_low < ctx.buffer_len)
+        ctx.t_high++;
+    hsh_blake2b_compress(&ctx, last, HSH_BLAKE2_LAST_BLOCK);
+    memcpy(digest, ctx.h, digest_size);
+    return 0;
 }
 
-static void hsh_blake2s_compress(hsh_blake2s_ctx *ctx,
-                                 const uint8_t block[64],
-                                 int is_last)
+/* ============================================
+ * BLAKE2s (32-bit)
+ * ============================================ */
+
+static void hsh_blake2s_compress_generic(hsh_blake2s_ctx *ctx,
+                                         const uint8_t block[64],
+                                         int flags)
 {
     uint32_t m[16];
     uint32_t v[16];
@@ -183,7 +278,8 @@ static void hsh_blake2s_compress(hsh_blake2s_ctx *ctx,
 
     v[12] ^= (uint32_t)ctx->t;
     v[13] ^= (uint32_t)(ctx->t >> 32);
-    if (is_last) v[14] ^= 0xFFFFFFFFU;
+    if (flags & HSH_BLAKE2_LAST_BLOCK) v[14] ^= 0xFFFFFFFFU;
+    if (flags & HSH_BLAKE2_LAST_NODE) v[15] ^= 0xFFFFFFFFU;
 
     for (int r = 0; r < 10; r++) {
         const uint8_t *s = HSH_BLAKE2_SIGMA[r];
@@ -201,17 +297,61 @@ static void hsh_blake2s_compress(hsh_blake2s_ctx *ctx,
         ctx->h[i] ^= v[i] ^ v[i + 8];
 }
 
-int hsh_blake2s_init(hsh_blake2s_ctx *ctx, size_t digest_size,
-                     const uint8_t *key, size_t key_len,
-                     const uint8_t *personal, size_t pers_len)
+static void hsh_blake2s_compress(hsh_blake2s_ctx *ctx,
+                                 const uint8_t block[64],
+                                 int flags)
+{
+#if HSH_X86
+    if ((hsh_cpu_features() & (HSH_CPU_SSSE3 | HSH_CPU_SSE41)) == (HSH_CPU_SSSE3 | HSH_CPU_SSE41)) {
+        hsh_blake2s_compress_sse41(ctx, block, flags);
+        return;
+    }
+#endif
+    hsh_blake2s_compress_generic(ctx, block, flags);
+}
+
+static void hsh_blake2s_process_blocks(hsh_blake2s_ctx *ctx, const uint8_t *data, size_t nblocks)
+{
+    if (nblocks == 0) return;
+#if HSH_X86
+    if ((hsh_cpu_features() & (HSH_CPU_SSSE3 | HSH_CPU_SSE41)) == (HSH_CPU_SSSE3 | HSH_CPU_SSE41)) {
+        hsh_blake2s_blocks_sse41(ctx, data, nblocks);
+        return;
+    }
+#endif
+    for (; nblocks > 0; nblocks--, data += 64) {
+        ctx->t += 64;
+        hsh_blake2s_compress_generic(ctx, data, 0);
+    }
+}
+
+static void hsh_blake2s_compress_buffer(hsh_blake2s_ctx *ctx)
+{
+    if (ctx->key_pending) {
+        memcpy(ctx->h, ctx->key_h, sizeof(ctx->h));
+        ctx->t += 64;
+        ctx->key_pending = 0;
+    } else {
+        hsh_blake2s_process_blocks(ctx, ctx->buffer, 1);
+    }
+}
+
+int hsh_blake2s_init_tree(hsh_blake2s_ctx *ctx, size_t digest_size,
+                          const uint8_t *key, size_t key_len,
+                          const uint8_t *personal, size_t pers_len,
+                          const hsh_blake2_tree *tree)
 {
     if (digest_size == 0 || digest_size > 32) return -1;
     if (key_len > 32) return -1;
     if (pers_len > 8) return -1;
 
     memcpy(ctx->h, HSH_BLAKE2S_IV, sizeof(HSH_BLAKE2S_IV));
-    uint32_t param = 0x01010000U ^ ((uint32_t)key_len << 8) ^ digest_size;
+    uint32_t param = ((uint32_t)tree->depth << 24) ^ ((uint32_t)tree->fanout << 16) ^
+                     ((uint32_t)key_len << 8) ^ (uint32_t)digest_size;
     ctx->h[0] ^= param;
+    ctx->h[2] ^= (uint32_t)tree->node_offset;
+    ctx->h[3] ^= ((uint32_t)tree->inner_length << 24) ^ ((uint32_t)tree->node_depth << 16) ^
+                 ((uint32_t)(tree->node_offset >> 32) & 0xFFFFU);
 
     if (personal && pers_len > 0) {
         uint8_t buf[8] = {0};
@@ -227,39 +367,93 @@ int hsh_blake2s_init(hsh_blake2s_ctx *ctx, size_t digest_size,
     ctx->buffer_len = 0;
     ctx->digest_size = digest_size;
 
+    ctx->key_pending = 0;
     if (key && key_len > 0) {
-        uint8_t block[64] = {0};
-        memcpy(block, key, key_len);
-        hsh_blake2s_update(ctx, block, 64);
+        uint32_t h0[8];
+        memset(ctx->buffer, 0, sizeof(ctx->buffer));
+        memcpy(ctx->buffer, key, key_len);
+        ctx->buffer_len = 64;
+
+        /* The key block stays buffered in case the message is empty (it is
+         * then the final block); its non-final compression is done now */
+        memcpy(h0, ctx->h, sizeof(h0));
+        hsh_blake2s_process_blocks(ctx, ctx->buffer, 1);
+        memcpy(ctx->key_h, ctx->h, sizeof(ctx->key_h));
+        memcpy(ctx->h, h0, sizeof(h0));
+        ctx->t = 0;
+        ctx->key_pending = 1;
     }
 
     return 0;
 }
 
+int hsh_blake2s_init(hsh_blake2s_ctx *ctx, size_t digest_size,
+                     const uint8_t *key, size_t key_len,
+                     const uint8_t *personal, size_t pers_len)
+{
+    static const hsh_blake2_tree sequential = {1, 1, 0, 0, 0};
+    return hsh_blake2s_init_tree(ctx, digest_size, key, key_len, personal, pers_len, &sequential);
+}
+
 void hsh_blake2s_update(hsh_blake2s_ctx *ctx, const uint8_t *data, size_t len)
 {
-    size_t offset = 0;
-    while (offset < len) {
-        size_t space = 64 - ctx->buffer_len;
-        size_t take = (len - offset > space) ? space : len - offset;
-        memcpy(ctx->buffer + ctx->buffer_len, data + offset, take);
-        ctx->buffer_len += take;
-        offset += take;
-
-        if (ctx->buffer_len == 64) {
-            ctx->t += 64;
-            hsh_blake2s_compress(ctx, ctx->buffer, 0);
-            ctx->buffer_len = 0;
-        }
+    if (len == 0) return;
+
+    /* Hold back the last full block until more input arrives (see BLAKE2b) */
+    size_t space = 64 - ctx->buffer_len;
+    if (len > space) {
+        memcpy(ctx->buffer + ctx->buffer_len, data, space);
+        hsh_blake2s_compress_buffer(ctx);
+        ctx->buffer_len = 0;
+        data += space;
+        len -= space;
+
+        size_t nblocks = (len - 1) / 64;
+        hsh_blake2s_process_blocks(ctx, data, nblocks);
+        data += nblocks * 64;
+        len -= nblocks * 64;
     }
+
+    memcpy(ctx->buffer + ctx->buffer_len, data, len);
+    ctx->buffer_len += len;
 }
 
-void hsh_blake2s_finalize(hsh_blake2s_ctx *ctx, uint8_t *digest)
+void hsh_blake2s_finalize_node(hsh_blake2s_ctx *ctx, uint8_t *digest, int last_node)
 {
     ctx->t += ctx->buffer_len;
     uint8_t block[64] = {0};
     memcpy(block, ctx->buffer, ctx->buffer_len);
-    hsh_blake2s_compress(ctx, block, 1);
+    hsh_blake2s_compress(ctx, block, HSH_BLAKE2_LAST_BLOCK | (last_node ? HSH_BLAKE2_LAST_NODE : 0));
     memcpy(digest, ctx->h, ctx->digest_size);
 }
 
+void hsh_blake2s_finalize(hsh_blake2s_ctx *ctx, uint8_t *digest)
+{
+    hsh_blake2s_finalize_node(ctx, digest, 0);
+}
+
+int hsh_blake2s(const uint8_t *data, size_t len, uint8_t *digest, size_t digest_size,
+                const uint8_t *key, size_t key_len)
+{
+    hsh_blake2s_ctx ctx;
+    uint8_t last[64] = {0};
+
+    if (hsh_blake2s_init(&ctx, digest_size, key, key_len, NULL, 0) != 0) return -1;
+
+    if (len > 0) {
+        size_t nblocks = (len - 1) / 64;
+        if (ctx.buffer_len > 0)
+            hsh_blake2s_compress_buffer(&ctx);
+        hsh_blake2s_process_blocks(&ctx, data, nblocks);
+        ctx.buffer_len = len - nblocks * 64;
+        memcpy(last, data + nblocks * 64, ctx.buffer_len);
+    } else if (ctx.buffer_len > 0) {
+        memcpy(last, ctx.buffer, 64);
+    }
+
+    ctx.t += ctx.buffer_len;
+    hsh_blake2s_compress(&ctx, last, HSH_BLAKE2_LAST_BLOCK);
+    memcpy(digest, ctx.h, digest_size);
+    return 0;
+}
+
@@ -0,0 +1,72 @@
+#ifndef HSH_BLAKE2_INTERNAL_H
+#define HSH_BLAKE2_INTERNAL_H
+
+/* Internal: BLAKE2 compression backends. */
+
+#include "blake2.h"
+#include "cpu.h"
+
+extern const uint64_t HSH_BLAKE2B_IV[8];
+extern const uint32_t HSH_BLAKE2S_IV[8];
+extern const uint8_t HSH_BLAKE2_SIGMA[10][16];
+
+/* BLAKE2s mixing function; BLAKE3 uses the same G and rotation counts */
+#define HSH_BLAKE2S_ROTR(x,n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static inline void hsh_blake2s_G(uint32_t v[16], int a, int b, int c, int d,
+                                 uint32_t x, uint32_t y)
+{
+    v[a] = v[a] + v[b] + x;
+    v[d] = HSH_BLAKE2S_ROTR(v[d] ^ v[a], 16);
+    v[c] = v[c] + v[d];
+    v[b] = HSH_BLAKE2S_ROTR(v[b] ^ v[c], 12);
+    v[a] = v[a] + v[b] + y;
+    v[d] = HSH_BLAKE2S_ROTR(v[d] ^ v[a], 8);
+    v[c] = v[c] + v[d];
+    v[b] = HSH_BLAKE2S_ROTR(v[b] ^ v[c], 7);
+}
+
+/* Finalization flags passed to the compression functions (f0 and f1) */
+#define HSH_BLAKE2_LAST_BLOCK 1
+#define HSH_BLAKE2_LAST_NODE  2
+
+/* Tree fields of the parameter block; sequential hashing is {1, 1, 0, 0, 0} */
+typedef struct {
+    uint8_t fanout;
+    uint8_t depth;
+    uint64_t node_offset;   /* 48 bits for BLAKE2s */
+    uint8_t node_depth;
+    uint8_t inner_length;
+} hsh_blake2_tree;
+
+/* Init with explicit tree parameters. A NULL key with key_len > 0 only sets
+ * the key length in the parameter block (the BLAKE2bp/sp root node). */
+int hsh_blake2b_init_tree(hsh_blake2b_ctx *ctx, size_t digest_size,
+                          const uint8_t *key, size_t key_len,
+                          const uint8_t *personal, size_t pers_len,
+                          const hsh_blake2_tree *tree);
+int hsh_blake2s_init_tree(hsh_blake2s_ctx *ctx, size_t digest_size,
+                          const uint8_t *key, size_t key_len,
+                          const uint8_t *personal, size_t pers_len,
+                          const hsh_blake2_tree *tree);
+
+/* Finalize, setting the last-node flag for the rightmost node of a level */
+void hsh_blake2b_finalize_node(hsh_blake2b_ctx *ctx, uint8_t *digest, int last_node);
+void hsh_blake2s_finalize_node(hsh_blake2s_ctx *ctx, uint8_t *digest, int last_node);
+
+#if HSH_X86
+/* AVX2 drop-in for the scalar BLAKE2b compression of one 128-byte block */
+void hsh_blake2b_compress_avx2(hsh_blake2b_ctx *ctx, const uint8_t block[128], int flags);
+
+/* Compress nblocks consecutive non-final blocks, advancing the counter by 128
+ * before each one; the chaining value stays in registers across blocks */
+void hsh_blake2b_blocks_avx2(hsh_blake2b_ctx *ctx, const uint8_t *data, size_t nblocks);
+
+/* SSSE3/SSE4.1 drop-in for the scalar BLAKE2s compression of one 64-byte block */
+void hsh_blake2s_compress_sse41(hsh_blake2s_ctx *ctx, const uint8_t block[64], int flags);
+
+/* Multi-block counterpart of the above, counter advanced by 64 per block */
+void hsh_blake2s_blocks_sse41(hsh_blake2s_ctx *ctx, const uint8_t *data, size_t nblocks);
+#endif
+
+#endif /* HSH_BLAKE2_INTERNAL_H */
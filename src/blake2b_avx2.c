@@ -0,0 +1,145 @@
+#include "blake2_internal.h"
+
+#if HSH_X86
+#include <immintrin.h>
+
+/*
+ * Message schedule for all 12 rounds (SIGMA[r % 10] expanded), reordered so
+ * that each group of four indices fills one vector: column-step x words,
+ * column-step y words, diagonal-step x words, diagonal-step y words.
+ */
+static const uint8_t HSH_BLAKE2B_AVX2_SCHEDULE[12][16] = {
+    { 0,  2,  4,  6,  1,  3,  5,  7,  8, 10, 12, 14,  9, 11, 13, 15},
+    {14,  4,  9, 13, 10,  8, 15,  6,  1,  0, 11,  5, 12,  2,  7,  3},
+    {11, 12,  5, 15,  8,  0,  2, 13, 10,  3,  7,  9, 14,  6,  1,  4},
+    { 7,  3, 13, 11,  9,  1, 12, 14,  2,  5,  4, 15,  6, 10,  0,  8},
+    { 9,  5,  2, 10,  0,  7,  4, 15, 14, 11,  6,  3,  1, 12,  8, 13},
+    { 2,  6,  0,  8, 12, 10, 11,  3,  4,  7, 15,  1, 13,  5, 14,  9},
+    {12,  1, 14,  4,  5, 15, 13, 10,  0,  6,  9,  8,  7,  3,  2, 11},
+    {13,  7, 12,  3, 11, 14,  1,  9,  5, 15,  8,  2,  0,  4,  6, 10},
+    { 6, 14, 11,  0, 15,  9,  3,  8, 12, 13,  1, 10,  2,  7,  4,  5},
+    {10,  8,  7,  1,  2,  4,  6,  5, 15,  9,  3, 13, 11, 14, 12,  0},
+    { 0,  2,  4,  6,  1,  3,  5,  7,  8, 10, 12, 14,  9, 11, 13, 15},
+    {14,  4,  9, 13, 10,  8, 15,  6,  1,  0, 11,  5, 12,  2,  7,  3}
+};
+
+/*
+ * M[j] holds message words 2j and 2j+1 in both 128-bit halves. A pair of
+ * words (a, b) is one unpack, blend or alignr away, and two pairs are joined
+ * with a blend; all choices fold to constants since r and k are literals.
+ */
+#define HSH_B2B_PAIR(a, b) \
+    ((((a) & 1) == 0 && ((b) & 1) == 0) ? _mm256_unpacklo_epi64(M[(a) / 2], M[(b) / 2]) : \
+     (((a) & 1) == 1 && ((b) & 1) == 1) ? _mm256_unpackhi_epi64(M[(a) / 2], M[(b) / 2]) : \
+     (((a) & 1) == 0) ? _mm256_blend_epi32(M[(a) / 2], M[(b) / 2], 0xCC) : \
+                        _mm256_alignr_epi8(M[(b) / 2], M[(a) / 2], 8))
+
+#define HSH_B2B_LOAD(r, k) _mm256_blend_epi32( \
+    HSH_B2B_PAIR(HSH_BLAKE2B_AVX2_SCHEDULE[r][4*(k) + 0], HSH_BLAKE2B_AVX2_SCHEDULE[r][4*(k) + 1]), \
+    HSH_B2B_PAIR(HSH_BLAKE2B_AVX2_SCHEDULE[r][4*(k) + 2], HSH_BLAKE2B_AVX2_SCHEDULE[r][4*(k) + 3]), 0xF0)
+
+#define HSH_B2B_ROR32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define HSH_B2B_ROR24(x) _mm256_shuffle_epi8((x), ROT24)
+#define HSH_B2B_ROR16(x) _mm256_shuffle_epi8((x), ROT16)
+#define HSH_B2B_ROR63(x) _mm256_or_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x)))
+
+/* Four G functions at once, one per 64-bit lane */
+#define HSH_B2B_G(mx, my) do { \
+    row1 = _mm256_add_epi64(_mm256_add_epi64(row1, row2), mx); \
+    row4 = HSH_B2B_ROR32(_mm256_xor_si256(row4, row1)); \
+    row3 = _mm256_add_epi64(row3, row4); \
+    row2 = HSH_B2B_ROR24(_mm256_xor_si256(row2, row3)); \
+    row1 = _mm256_add_epi64(_mm256_add_epi64(row1, row2), my); \
+    row4 = HSH_B2B_ROR16(_mm256_xor_si256(row4, row1)); \
+    row3 = _mm256_add_epi64(row3, row4); \
+    row2 = HSH_B2B_ROR63(_mm256_xor_si256(row2, row3)); \
+} while (0)
+
+/* Rotate rows 2-4 so the diagonals line up as columns, and back */
+#define HSH_B2B_DIAGONALIZE() do { \
+    row2 = _mm256_permute4x64_epi64(row2, _MM_SHUFFLE(0, 3, 2, 1)); \
+    row3 = _mm256_permute4x64_epi64(row3, _MM_SHUFFLE(1, 0, 3, 2)); \
+    row4 = _mm256_permute4x64_epi64(row4, _MM_SHUFFLE(2, 1, 0, 3)); \
+} while (0)
+
+#define HSH_B2B_UNDIAGONALIZE() do { \
+    row2 = _mm256_permute4x64_epi64(row2, _MM_SHUFFLE(2, 1, 0, 3)); \
+    row3 = _mm256_permute4x64_epi64(row3, _MM_SHUFFLE(1, 0, 3, 2)); \
+    row4 = _mm256_permute4x64_epi64(row4, _MM_SHUFFLE(0, 3, 2, 1)); \
+} while (0)
+
+#define HSH_B2B_ROUND(r) do { \
+    HSH_B2B_G(HSH_B2B_LOAD(r, 0), HSH_B2B_LOAD(r, 1)); \
+    HSH_B2B_DIAGONALIZE(); \
+    HSH_B2B_G(HSH_B2B_LOAD(r, 2), HSH_B2B_LOAD(r, 3)); \
+    HSH_B2B_UNDIAGONALIZE(); \
+} while (0)
+
+/* One compression; h[0..1] hold the chaining value, tf is (t0, t1, f0, f1) */
+__attribute__((target("avx2")))
+static inline void hsh_blake2b_avx2_block(__m256i h[2], const uint8_t *block, __m256i tf) {
+    const __m256i ROT24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+                                           3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    const __m256i ROT16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                           2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    __m256i M[8];
+    for (int j = 0; j < 8; j++)
+        M[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(block + 16 * j)));
+
+    __m256i row1 = h[0];
+    __m256i row2 = h[1];
+    __m256i row3 = _mm256_loadu_si256((const __m256i *)&HSH_BLAKE2B_IV[0]);
+    __m256i row4 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&HSH_BLAKE2B_IV[4]), tf);
+
+    HSH_B2B_ROUND(0);
+    HSH_B2B_ROUND(1);
+    HSH_B2B_ROUND(2);
+    HSH_B2B_ROUND(3);
+    HSH_B2B_ROUND(4);
+    HSH_B2B_ROUND(5);
+    HSH_B2B_ROUND(6);
+    HSH_B2B_ROUND(7);
+    HSH_B2B_ROUND(8);
+    HSH_B2B_ROUND(9);
+    HSH_B2B_ROUND(10);
+    HSH_B2B_ROUND(11);
+
+    h[0] = _mm256_xor_si256(h[0], _mm256_xor_si256(row1, row3));
+    h[1] = _mm256_xor_si256(h[1], _mm256_xor_si256(row2, row4));
+}
+
+__attribute__((target("avx2")))
+void hsh_blake2b_compress_avx2(hsh_blake2b_ctx *ctx, const uint8_t block[128], int flags) {
+    __m256i h[2];
+    h[0] = _mm256_loadu_si256((const __m256i *)&ctx->h[0]);
+    h[1] = _mm256_loadu_si256((const __m256i *)&ctx->h[4]);
+
+    hsh_blake2b_avx2_block(h, block,
+                           _mm256_setr_epi64x((long long)ctx->t_low, (long long)ctx->t_high,
+                                              (flags & HSH_BLAKE2_LAST_BLOCK) ? -1LL : 0,
+                                              (flags & HSH_BLAKE2_LAST_NODE) ? -1LL : 0));
+
+    _mm256_storeu_si256((__m256i *)&ctx->h[0], h[0]);
+    _mm256_storeu_si256((__m256i *)&ctx->h[4], h[1]);
+}
+
+__attribute__((target("avx2")))
+void hsh_blake2b_blocks_avx2(hsh_blake2b_ctx *ctx, const uint8_t *data, size_t nblocks) {
+    uint64_t t_low = ctx->t_low, t_high = ctx->t_high;
+    __m256i h[2];
+    h[0] = _mm256_loadu_si256((const __m256i *)&ctx->h[0]);
+    h[1] = _mm256_loadu_si256((const __m256i *)&ctx->h[4]);
+
+    for (; nblocks > 0; nblocks--, data += 128) {
+        t_low += 128;
+        if (t_low < 128) t_high++;
+        hsh_blake2b_avx2_block(h, data, _mm256_setr_epi64x((long long)t_low, (long long)t_high, 0, 0));
+    }
+
+    _mm256_storeu_si256((__m256i *)&ctx->h[0], h[0]);
+    _mm256_storeu_si256((__m256i *)&ctx->h[4], h[1]);
+    ctx->t_low = t_low;
+    ctx->t_high = t_high;
+}
+
+#endif /* HSH_X86 */
@@ -0,0 +1,215 @@
+#include "blake2.h"
+#include "blake2_internal.h"
+#include "pool.h"
+#include <string.h>
+
+/*
+ * BLAKE2bp / BLAKE2sp (BLAKE2 specification, section 2.10): block i of the
+ * input goes to leaf i mod N, the leaves are hashed independently with
+ * fanout N and depth 2, and a root node hashes the concatenated leaf
+ * digests. Leaves always produce full-size digests; the requested digest
+ * size only appears in their parameter blocks.
+ *
+ * Each leaf is a plain BLAKE2 context, so it keeps holding back its own
+ * last block and the single-stream compression backends are reused as is.
+ * Updates with enough whole stripes hand one leaf to each pool thread.
+ */
+
+/* Below this many bytes of whole stripes, waking the pool costs more than it saves */
+#define HSH_BLAKE2P_PARALLEL_MIN (64 * 1024)
+
+/* ============================================
+ * BLAKE2bp
+ * ============================================ */
+
+#define HSH_B2BP_STRIPE (HSH_BLAKE2BP_LEAVES * 128)
+
+typedef struct {
+    hsh_blake2bp_ctx *ctx;
+    const uint8_t *data;
+    size_t stripes;
+} hsh_blake2bp_job;
+
+static void hsh_blake2bp_leaf(void *arg, size_t leaf)
+{
+    hsh_blake2bp_job *job = arg;
+    const uint8_t *p = job->data + leaf * 128;
+    for (size_t i = 0; i < job->stripes; i++, p += HSH_B2BP_STRIPE)
+        hsh_blake2b_update(&job->ctx->leaves[leaf], p, 128);
+}
+
+static void hsh_blake2bp_stripes(hsh_blake2bp_ctx *ctx, const uint8_t *data, size_t stripes)
+{
+    hsh_blake2bp_job job = {ctx, data, stripes};
+    if (stripes * HSH_B2BP_STRIPE >= HSH_BLAKE2P_PARALLEL_MIN) {
+        hsh_pool_run(hsh_blake2bp_leaf, &job, HSH_BLAKE2BP_LEAVES);
+        return;
+    }
+    for (size_t leaf = 0; leaf < HSH_BLAKE2BP_LEAVES; leaf++)
+        hsh_blake2bp_leaf(&job, leaf);
+}
+
+int hsh_blake2bp_init(hsh_blake2bp_ctx *ctx, size_t digest_size,
+                      const uint8_t *key, size_t key_len)
+{
+    hsh_blake2_tree tree = {HSH_BLAKE2BP_LEAVES, 2, 0, 1, 64};
+
+    if (hsh_blake2b_init_tree(&ctx->root, digest_size, NULL, key_len, NULL, 0, &tree) != 0)
+        return -1;
+
+    tree.node_depth = 0;
+    for (size_t i = 0; i < HSH_BLAKE2BP_LEAVES; i++) {
+        tree.node_offset = i;
+        hsh_blake2b_init_tree(&ctx->leaves[i], digest_size, key, key_len, NULL, 0, &tree);
+        ctx->leaves[i].digest_size = 64;
+    }
+
+    ctx->buffer_len = 0;
+    return 0;
+}
+
+void hsh_blake2bp_update(hsh_blake2bp_ctx *ctx, const uint8_t *data, size_t len)
+{
+    size_t fill = HSH_B2BP_STRIPE - ctx->buffer_len;
+
+    if (ctx->buffer_len > 0 && len >= fill) {
+        memcpy(ctx->buffer + ctx->buffer_len, data, fill);
+        hsh_blake2bp_stripes(ctx, ctx->buffer, 1);
+        ctx->buffer_len = 0;
+        data += fill;
+        len -= fill;
+    }
+
+    if (ctx->buffer_len == 0 && len >= HSH_B2BP_STRIPE) {
+        size_t stripes = len / HSH_B2BP_STRIPE;
+        hsh_blake2bp_stripes(ctx, data, stripes);
+        data += stripes * HSH_B2BP_STRIPE;
+        len -= stripes * HSH_B2BP_STRIPE;
+    }
+
+    memcpy(ctx->buffer + ctx->buffer_len, data, len);
+    ctx->buffer_len += len;
+}
+
+void hsh_blake2bp_finalize(hsh_blake2bp_ctx *ctx, uint8_t *digest)
+{
+    uint8_t leaf_digest[64];
+
+    for (size_t i = 0; i < HSH_BLAKE2BP_LEAVES; i++) {
+        if (ctx->buffer_len > i * 128) {
+            size_t left = ctx->buffer_len - i * 128;
+            hsh_blake2b_update(&ctx->leaves[i], ctx->buffer + i * 128, left > 128 ? 128 : left);
+        }
+        hsh_blake2b_finalize_node(&ctx->leaves[i], leaf_digest, i == HSH_BLAKE2BP_LEAVES - 1);
+        hsh_blake2b_update(&ctx->root, leaf_digest, 64);
+    }
+    hsh_blake2b_finalize_node(&ctx->root, digest, 1);
+}
+
+int hsh_blake2bp(const uint8_t *data, size_t len, uint8_t *digest, size_t digest_size,
+                 const uint8_t *key, size_t key_len)
+{
+    hsh_blake2bp_ctx ctx;
+    if (hsh_blake2bp_init(&ctx, digest_size, key, key_len) != 0) return -1;
+    hsh_blake2bp_update(&ctx, data, len);
+    hsh_blake2bp_finalize(&ctx, digest);
+    return 0;
+}
+
+/* ============================================
+ * BLAKE2sp
+ * ============================================ */
+
+#define HSH_B2SP_STRIPE (HSH_BLAKE2SP_LEAVES * 64)
+
+typedef struct {
+    hsh_blake2sp_ctx *ctx;
+    const uint8_t *data;
+    size_t stripes;
+} hsh_blake2sp_job;
+
+static void hsh_blake2sp_leaf(void *arg, size_t leaf)
+{
+    hsh_blake2sp_job *job = arg;
+    const uint8_t *p = job->data + leaf * 64;
+    for (size_t i = 0; i < job->stripes; i++, p += HSH_B2SP_STRIPE)
+        hsh_blake2s_update(&job->ctx->leaves[leaf], p, 64);
+}
+
+static void hsh_blake2sp_stripes(hsh_blake2sp_ctx *ctx, const uint8_t *data, size_t stripes)
+{
+    hsh_blake2sp_job job = {ctx, data, stripes};
+    if (stripes * HSH_B2SP_STRIPE >= HSH_BLAKE2P_PARALLEL_MIN) {
+        hsh_pool_run(hsh_blake2sp_leaf, &job, HSH_BLAKE2SP_LEAVES);
+        return;
+    }
+    for (size_t leaf = 0; leaf < HSH_BLAKE2SP_LEAVES; leaf++)
+        hsh_blake2sp_leaf(&job, leaf);
+}
+
+int hsh_blake2sp_init(hsh_blake2sp_ctx *ctx, size_t digest_size,
+                      const uint8_t *key, size_t key_len)
+{
+    hsh_blake2_tree tree = {HSH_BLAKE2SP_LEAVES, 2, 0, 1, 32};
+
+    if (hsh_blake2s_init_tree(&ctx->root, digest_size, NULL, key_len, NULL, 0, &tree) != 0)
+        return -1;
+
+    tree.node_depth = 0;
+    for (size_t i = 0; i < HSH_BLAKE2SP_LEAVES; i++) {
+        tree.node_offset = i;
+        hsh_blake2s_init_tree(&ctx->leaves[i], digest_size, key, key_len, NULL, 0, &tree);
+        ctx->leaves[i].digest_size = 32;
+    }
+
+    ctx->buffer_len = 0;
+    return 0;
+}
+
+void hsh_blake2sp_update(hsh_blake2sp_ctx *ctx, const uint8_t *data, size_t len)
+{
+    size_t fill = HSH_B2SP_STRIPE - ctx->buffer_len;
+
+    if (ctx->buffer_len > 0 && len >= fill) {
+        memcpy(ctx->buffer + ctx->buffer_len, data, fill);
+        hsh_blake2sp_stripes(ctx, ctx->buffer, 1);
+        ctx->buffer_len = 0;
+        data += fill;
+        len -= fill;
+    }
+
+    if (ctx->buffer_len == 0 && len >= HSH_B2SP_STRIPE) {
+        size_t stripes = len / HSH_B2SP_STRIPE;
+        hsh_blake2sp_stripes(ctx, data, stripes);
+        data += stripes * HSH_B2SP_STRIPE;
+        len -= stripes * HSH_B2SP_STRIPE;
+    }
+
+    memcpy(ctx->buffer + ctx->buffer_len, data, len);
+    ctx->buffer_len += len;
+}
+
+void hsh_blake2sp_finalize(hsh_blake2sp_ctx *ctx, uint8_t *digest)
+{
+    uint8_t leaf_digest[32];
+
+    for (size_t i = 0; i < HSH_BLAKE2SP_LEAVES; i++) {
+        if (ctx->buffer_len > i * 64) {
+            size_t left = ctx->buffer_len - i * 64;
+            hsh_blake2s_update(&ctx->leaves[i], ctx->buffer + i * 64, left > 64 ? 64 : left);
+        }
+        hsh_blake2s_finalize_node(&ctx->leaves[i], leaf_digest, i == HSH_BLAKE2SP_LEAVES - 1);
+        hsh_blake2s_update(&ctx->root, leaf_digest, 32);
+    }
+    hsh_blake2s_finalize_node(&ctx->root, digest, 1);
+}
+
+int hsh_blake2sp(const uint8_t *data, size_t len, uint8_t *digest, size_t digest_size,
+                 const uint8_t *key, size_t key_len)
+{
+    hsh_blake2sp_ctx ctx;
+    if (hsh_blake2sp_init(&ctx, digest_size, key, key_len) != 0) return -1;
+    hsh_blake2sp_update(&ctx, data, len);
+    hsh_blake2sp_finalize(&ctx, digest);
+    return 0;
+}
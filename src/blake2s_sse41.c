@@ -0,0 +1,93 @@
+#include "blake2_internal.h"
+
+#if HSH_X86
+#include <immintrin.h>
+
+/* Message words for round r: column-step x/y, then diagonal-step x/y */
+#define HSH_B2S_LOAD(s, i0, i1, i2, i3) \
+    _mm_setr_epi32((int)m[s[i0]], (int)m[s[i1]], (int)m[s[i2]], (int)m[s[i3]])
+
+#define HSH_B2S_ROR16(x) _mm_shuffle_epi8((x), ROT16)
+#define HSH_B2S_ROR12(x) _mm_or_si128(_mm_srli_epi32((x), 12), _mm_slli_epi32((x), 20))
+#define HSH_B2S_ROR8(x)  _mm_shuffle_epi8((x), ROT8)
+#define HSH_B2S_ROR7(x)  _mm_or_si128(_mm_srli_epi32((x), 7), _mm_slli_epi32((x), 25))
+
+/* Four G functions at once, one per 32-bit lane */
+#define HSH_B2S_G(mx, my) do { \
+    row1 = _mm_add_epi32(_mm_add_epi32(row1, row2), mx); \
+    row4 = HSH_B2S_ROR16(_mm_xor_si128(row4, row1)); \
+    row3 = _mm_add_epi32(row3, row4); \
+    row2 = HSH_B2S_ROR12(_mm_xor_si128(row2, row3)); \
+    row1 = _mm_add_epi32(_mm_add_epi32(row1, row2), my); \
+    row4 = HSH_B2S_ROR8(_mm_xor_si128(row4, row1)); \
+    row3 = _mm_add_epi32(row3, row4); \
+    row2 = HSH_B2S_ROR7(_mm_xor_si128(row2, row3)); \
+} while (0)
+
+/* One compression; h[0..1] hold the chaining value, tf is (t0, t1, f0, f1) */
+__attribute__((target("ssse3,sse4.1")))
+static inline void hsh_blake2s_sse41_block(__m128i h[2], const uint8_t *block, __m128i tf) {
+    const __m128i ROT16 = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m128i ROT8 = _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    uint32_t m[16];
+    int r;
+
+    for (r = 0; r < 16; r++) {
+        m[r] = (uint32_t)block[4*r] | ((uint32_t)block[4*r + 1] << 8) |
+               ((uint32_t)block[4*r + 2] << 16) | ((uint32_t)block[4*r + 3] << 24);
+    }
+
+    __m128i row1 = h[0];
+    __m128i row2 = h[1];
+    __m128i row3 = _mm_loadu_si128((const __m128i *)&HSH_BLAKE2S_IV[0]);
+    __m128i row4 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&HSH_BLAKE2S_IV[4]), tf);
+
+    for (r = 0; r < 10; r++) {
+        const uint8_t *s = HSH_BLAKE2_SIGMA[r];
+        HSH_B2S_G(HSH_B2S_LOAD(s, 0, 2, 4, 6), HSH_B2S_LOAD(s, 1, 3, 5, 7));
+        row2 = _mm_shuffle_epi32(row2, _MM_SHUFFLE(0, 3, 2, 1));
+        row3 = _mm_shuffle_epi32(row3, _MM_SHUFFLE(1, 0, 3, 2));
+        row4 = _mm_shuffle_epi32(row4, _MM_SHUFFLE(2, 1, 0, 3));
+        HSH_B2S_G(HSH_B2S_LOAD(s, 8, 10, 12, 14), HSH_B2S_LOAD(s, 9, 11, 13, 15));
+        row2 = _mm_shuffle_epi32(row2, _MM_SHUFFLE(2, 1, 0, 3));
+        row3 = _mm_shuffle_epi32(row3, _MM_SHUFFLE(1, 0, 3, 2));
+        row4 = _mm_shuffle_epi32(row4, _MM_SHUFFLE(0, 3, 2, 1));
+    }
+
+    h[0] = _mm_xor_si128(h[0], _mm_xor_si128(row1, row3));
+    h[1] = _mm_xor_si128(h[1], _mm_xor_si128(row2, row4));
+}
+
+__attribute__((target("ssse3,sse4.1")))
+void hsh_blake2s_compress_sse41(hsh_blake2s_ctx *ctx, const uint8_t block[64], int flags) {
+    __m128i h[2];
+    h[0] = _mm_loadu_si128((const __m128i *)&ctx->h[0]);
+    h[1] = _mm_loadu_si128((const __m128i *)&ctx->h[4]);
+
+    hsh_blake2s_sse41_block(h, block,
+                            _mm_setr_epi32((int)(uint32_t)ctx->t, (int)(uint32_t)(ctx->t >> 32),
+                                           (flags & HSH_BLAKE2_LAST_BLOCK) ? -1 : 0,
+                                           (flags & HSH_BLAKE2_LAST_NODE) ? -1 : 0));
+
+    _mm_storeu_si128((__m128i *)&ctx->h[0], h[0]);
+    _mm_storeu_si128((__m128i *)&ctx->h[4], h[1]);
+}
+
+__attribute__((target("ssse3,sse4.1")))
+void hsh_blake2s_blocks_sse41(hsh_blake2s_ctx *ctx, const uint8_t *data, size_t nblocks) {
+    uint64_t t = ctx->t;
+    __m128i h[2];
+    h[0] = _mm_loadu_si128((const __m128i *)&ctx->h[0]);
+    h[1] = _mm_loadu_si128((const __m128i *)&ctx->h[4]);
+
+    for (; nblocks > 0; nblocks--, data += 64) {
+        t += 64;
+        hsh_blake2s_sse41_block(h, data, _mm_setr_epi32((int)(uint32_t)t, (int)(uint32_t)(t >> 32), 0, 0));
+    }
+
+    _mm_storeu_si128((__m128i *)&ctx->h[0], h[0]);
+    _mm_storeu_si128((__m128i *)&ctx->h[4], h[1]);
+    ctx->t = t;
+}
+
+#endif /* HSH_X86 */
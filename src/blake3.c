@@ -0,0 +1,624 @@
+#include "blake3.h"
+#include "blake3_internal.h"
+#include "blake2_internal.h"
+#include "pool.h"
+#include <string.h>
+
+/*
+ * BLAKE3: the input is split into 1 KiB chunks, each chunk is hashed into a
+ * chaining value (CV) with the BLAKE2s-style compression function, and the
+ * CVs are combined in a binary tree whose left subtrees are always complete.
+ * Whole subtrees of the input are hashed several chunks at a time with the
+ * multi-input SIMD backends; only the CVs waiting for a right sibling are
+ * kept in the context.
+ */
+
+const uint8_t HSH_BLAKE3_MSG_SCHEDULE[7][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13},
+};
+
+/* Subtrees at least this large are split across the worker pool */
+#define HSH_BLAKE3_PARALLEL_MIN   (1u << 20)
+/* Smallest piece handed to one task */
+#define HSH_BLAKE3_PARALLEL_PIECE (64u * 1024)
+#define HSH_BLAKE3_MAX_PIECES     256
+
+/* ============================================
+ * Compression
+ * ============================================ */
+
+static uint32_t hsh_blake3_load32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void hsh_blake3_store32(uint8_t *p, uint32_t w)
+{
+    p[0] = (uint8_t)w;
+    p[1] = (uint8_t)(w >> 8);
+    p[2] = (uint8_t)(w >> 16);
+    p[3] = (uint8_t)(w >> 24);
+}
+
+/* Full 16-word output: words 0..7 are the next CV, 8..15 extend the XOF */
+static void hsh_blake3_compress(const uint32_t cv[8], const uint8_t block[64], uint8_t block_len,
+                                uint64_t counter, uint8_t flags, uint32_t out[16])
+{
+    uint32_t m[16];
+    uint32_t v[16];
+
+    for (int i = 0; i < 16; i++)
+        m[i] = hsh_blake3_load32(block + 4 * i);
+    memcpy(v, cv, 32);
+    memcpy(v + 8, HSH_BLAKE2S_IV, 16);
+    v[12] = (uint32_t)counter;
+    v[13] = (uint32_t)(counter >> 32);
+    v[14] = block_len;
+    v[15] = flags;
+
+    for (int r = 0; r < 7; r++) {
+        const uint8_t *s = HSH_BLAKE3_MSG_SCHEDULE[r];
+        hsh_blake2s_G(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        hsh_blake2s_G(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        hsh_blake2s_G(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        hsh_blake2s_G(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        hsh_blake2s_G(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        hsh_blake2s_G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        hsh_blake2s_G(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        hsh_blake2s_G(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        out[i] = v[i] ^ v[i + 8];
+        out[i + 8] = v[i + 8] ^ cv[i];
+    }
+}
+
+static void hsh_blake3_compress_in_place(uint32_t cv[8], const uint8_t block[64], uint8_t block_len,
+                                         uint64_t counter, uint8_t flags)
+{
+    uint32_t out[16];
+    hsh_blake3_compress(cv, block, block_len, counter, flags, out);
+    memcpy(cv, out, 32);
+}
+
+static void hsh_blake3_hash_one(const uint8_t *input, size_t blocks, const uint32_t key[8],
+                                uint64_t counter, uint8_t flags, uint8_t flags_start,
+                                uint8_t flags_end, uint8_t out[32])
+{
+    uint32_t cv[8];
+    uint8_t block_flags = flags | flags_start;
+
+    memcpy(cv, key, 32);
+    for (size_t b = 0; b < blocks; b++, input += 64) {
+        if (b + 1 == blocks) block_flags |= flags_end;
+        hsh_blake3_compress_in_place(cv, input, 64, counter, block_flags);
+        block_flags = flags;
+    }
+    for (int i = 0; i < 8; i++)
+        hsh_blake3_store32(out + 4 * i, cv[i]);
+}
+
+/* Inputs taken per call by the widest backend this CPU supports */
+static size_t hsh_blake3_simd_degree(void)
+{
+#if HSH_X86
+    unsigned features = hsh_cpu_features();
+    if (features & HSH_CPU_AVX2) return 8;
+    if ((features & (HSH_CPU_SSSE3 | HSH_CPU_SSE41)) == (HSH_CPU_SSSE3 | HSH_CPU_SSE41)) return 4;
+#endif
+    return 1;
+}
+
+static void hsh_blake3_hash_many(const uint8_t *const *inputs, size_t count, size_t blocks,
+                                 const uint32_t key[8], uint64_t counter, int increment_counter,
+                                 uint8_t flags, uint8_t flags_start, uint8_t flags_end, uint8_t *out)
+{
+#if HSH_X86
+    size_t degree = hsh_blake3_simd_degree();
+    while (degree >= 8 && count >= 8) {
+        hsh_blake3_hash8_avx2(inputs, blocks, key, counter, increment_counter,
+                              flags, flags_start, flags_end, out);
+        if (increment_counter) counter += 8;
+        inputs += 8;
+        count -= 8;
+        out += 8 * 32;
+    }
+    while (degree >= 4 && count >= 4) {
+        hsh_blake3_hash4_sse41(inputs, blocks, key, counter, increment_counter,
+                               flags, flags_start, flags_end, out);
+        if (increment_counter) counter += 4;
+        inputs += 4;
+        count -= 4;
+        out += 4 * 32;
+    }
+#endif
+    for (; count > 0; count--) {
+        hsh_blake3_hash_one(*inputs++, blocks, key, counter, flags, flags_start, flags_end, out);
+        if (increment_counter) counter++;
+        out += 32;
+    }
+}
+
+/* ============================================
+ * Chunk state and output
+ * ============================================ */
+
+/* Everything needed to produce a node's CV or, for the root, its XOF bytes */
+typedef struct {
+    uint32_t cv[8];
+    uint8_t block[64];
+    uint8_t block_len;
+    uint64_t counter;
+    uint8_t flags;
+} hsh_blake3_output;
+
+static void hsh_blake3_output_cv(const hsh_blake3_output *o, uint8_t cv[32])
+{
+    uint32_t words[8];
+    memcpy(words, o->cv, 32);
+    hsh_blake3_compress_in_place(words, o->block, o->block_len, o->counter, o->flags);
+    for (int i = 0; i < 8; i++)
+        hsh_blake3_store32(cv + 4 * i, words[i]);
+}
+
+static void hsh_blake3_output_root(const hsh_blake3_output *o, uint8_t *out, size_t out_len)
+{
+    uint64_t block_counter = 0;
+    uint32_t words[16];
+    uint8_t bytes[64];
+
+    while (out_len > 0) {
+        size_t take = out_len < 64 ? out_len : 64;
+        hsh_blake3_compress(o->cv, o->block, o->block_len, block_counter++,
+                            o->flags | HSH_BLAKE3_ROOT, words);
+        for (int i = 0; i < 16; i++)
+            hsh_blake3_store32(bytes + 4 * i, words[i]);
+        memcpy(out, bytes, take);
+        out += take;
+        out_len -= take;
+    }
+}
+
+static void hsh_blake3_parent_output(hsh_blake3_output *o, const uint8_t block[64],
+                                     const uint32_t key[8], uint8_t flags)
+{
+    memcpy(o->cv, key, 32);
+    memcpy(o->block, block, 64);
+    o->block_len = 64;
+    o->counter = 0;
+    o->flags = flags | HSH_BLAKE3_PARENT;
+}
+
+static void hsh_blake3_chunk_init(hsh_blake3_chunk_state *cs, const uint32_t key[8],
+                                  uint64_t chunk_counter, uint8_t flags)
+{
+    memcpy(cs->cv, key, 32);
+    cs->chunk_counter = chunk_counter;
+    memset(cs->buf, 0, sizeof(cs->buf));
+    cs->buf_len = 0;
+    cs->blocks_compressed = 0;
+    cs->flags = flags;
+}
+
+static size_t hsh_blake3_chunk_len(const hsh_blake3_chunk_state *cs)
+{
+    return (size_t)cs->blocks_compressed * 64 + cs->buf_len;
+}
+
+static uint8_t hsh_blake3_chunk_start_flag(const hsh_blake3_chunk_state *cs)
+{
+    return cs->blocks_compressed == 0 ? HSH_BLAKE3_CHUNK_START : 0;
+}
+
+/* Like the other hashes the last block is held back, since it must be
+ * compressed with CHUNK_END (and possibly ROOT) once the chunk is complete */
+static void hsh_blake3_chunk_update(hsh_blake3_chunk_state *cs, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        if (cs->buf_len == 64) {
+            hsh_blake3_compress_in_place(cs->cv, cs->buf, 64, cs->chunk_counter,
+                                         cs->flags | hsh_blake3_chunk_start_flag(cs));
+            cs->blocks_compressed++;
+            cs->buf_len = 0;
+            memset(cs->buf, 0, sizeof(cs->buf));
+        }
+
+        size_t take = 64 - cs->buf_len;
+        if (take > len) take = len;
+        memcpy(cs->buf + cs->buf_len, data, take);
+        cs->buf_len += (uint8_t)take;
+        data += take;
+        len -= take;
+    }
+}
+
+static void hsh_blake3_chunk_output(const hsh_blake3_chunk_state *cs, hsh_blake3_output *o)
+{
+    memcpy(o->cv, cs->cv, 32);
+    memcpy(o->block, cs->buf, 64);
+    o->block_len = cs->buf_len;
+    o->counter = cs->chunk_counter;
+    o->flags = cs->flags | hsh_blake3_chunk_start_flag(cs) | HSH_BLAKE3_CHUNK_END;
+}
+
+/* ============================================
+ * Subtrees
+ * ============================================ */
+
+static size_t hsh_blake3_round_down_pow2(uint64_t x)
+{
+    return (size_t)1 << (63 - __builtin_clzll(x | 1));
+}
+
+/* Bytes in the left subtree: the largest power-of-two number of chunks
+ * that still leaves at least one byte for the right */
+static size_t hsh_blake3_left_len(size_t len)
+{
+    size_t full_chunks = (len - 1) / HSH_BLAKE3_CHUNK_LEN;
+    return hsh_blake3_round_down_pow2(full_chunks) * HSH_BLAKE3_CHUNK_LEN;
+}
+
+/* CVs of up to simd_degree chunks, the last of which may be partial */
+static size_t hsh_blake3_compress_chunks(const uint8_t *data, size_t len, const uint32_t key[8],
+                                         uint64_t chunk_counter, uint8_t flags, uint8_t *out)
+{
+    const uint8_t *chunks[HSH_BLAKE3_MAX_SIMD_DEGREE];
+    size_t n = 0;
+
+    while (len - n * HSH_BLAKE3_CHUNK_LEN >= HSH_BLAKE3_CHUNK_LEN) {
+        chunks[n] = data + n * HSH_BLAKE3_CHUNK_LEN;
+        n++;
+    }
+    hsh_blake3_hash_many(chunks, n, HSH_BLAKE3_CHUNK_LEN / 64, key, chunk_counter, 1, flags,
+                         HSH_BLAKE3_CHUNK_START, HSH_BLAKE3_CHUNK_END, out);
+
+    if (len > n * HSH_BLAKE3_CHUNK_LEN) {
+        hsh_blake3_chunk_state cs;
+        hsh_blake3_output o;
+        hsh_blake3_chunk_init(&cs, key, chunk_counter + n, flags);
+        hsh_blake3_chunk_update(&cs, data + n * HSH_BLAKE3_CHUNK_LEN, len - n * HSH_BLAKE3_CHUNK_LEN);
+        hsh_blake3_chunk_output(&cs, &o);
+        hsh_blake3_output_cv(&o, out + n * 32);
+        return n + 1;
+    }
+    return n;
+}
+
+/* Pair up CVs into parent CVs; an odd CV out is passed through */
+static size_t hsh_blake3_compress_parents(const uint8_t *cvs, size_t count, const uint32_t key[8],
+                                          uint8_t flags, uint8_t *out)
+{
+    const uint8_t *parents[HSH_BLAKE3_MAX_SIMD_DEGREE];
+    size_t n = 0;
+
+    while (count - 2 * n >= 2) {
+        parents[n] = cvs + 2 * n * 32;
+        n++;
+    }
+    hsh_blake3_hash_many(parents, n, 1, key, 0, 0, flags | HSH_BLAKE3_PARENT, 0, 0, out);
+
+    if (count > 2 * n) {
+        memcpy(out + n * 32, cvs + 2 * n * 32, 32);
+        return n + 1;
+    }
+    return n;
+}
+
+/*
+ * Hash a subtree of more than one chunk down to at most 2 * simd_degree CVs
+ * (at least 2), recursing until each side fits in one multi-input call.
+ * Returns the number of CVs written.
+ */
+static size_t hsh_blake3_compress_subtree_wide(const uint8_t *data, size_t len, const uint32_t key[8],
+                                               uint64_t chunk_counter, uint8_t flags, uint8_t *out)
+{
+    size_t degree = hsh_blake3_simd_degree();
+    uint8_t cvs[2 * HSH_BLAKE3_MAX_SIMD_DEGREE * 32];
+
+    if (len <= degree * HSH_BLAKE3_CHUNK_LEN)
+        return hsh_blake3_compress_chunks(data, len, key, chunk_counter, flags, out);
+
+    size_t left_len = hsh_blake3_left_len(len);
+    uint64_t right_counter = chunk_counter + left_len / HSH_BLAKE3_CHUNK_LEN;
+
+    /* With one-at-a-time hashing each side must still return 2 CVs */
+    if (left_len > HSH_BLAKE3_CHUNK_LEN && degree == 1) degree = 2;
+
+    size_t left_n = hsh_blake3_compress_subtree_wide(data, left_len, key, chunk_counter, flags, cvs);
+    size_t right_n = hsh_blake3_compress_subtree_wide(data + left_len, len - left_len, key,
+                                                      right_counter, flags, cvs + degree * 32);
+
+    /* Only one chunk on the left: its CV and the right's are the result */
+    if (left_n == 1) {
+        memcpy(out, cvs, 64);
+        return 2;
+    }
+    return hsh_blake3_compress_parents(cvs, left_n + right_n, key, flags, out);
+}
+
+/* Reduce a subtree of more than one chunk to the two CVs under its root */
+static void hsh_blake3_compress_subtree_to_parent(const uint8_t *data, size_t len, const uint32_t key[8],
+                                                  uint64_t chunk_counter, uint8_t flags, uint8_t out[64])
+{
+    uint8_t cvs[2 * HSH_BLAKE3_MAX_SIMD_DEGREE * 32];
+    uint8_t next[HSH_BLAKE3_MAX_SIMD_DEGREE * 32];
+    size_t n = hsh_blake3_compress_subtree_wide(data, len, key, chunk_counter, flags, cvs);
+
+    while (n > 2) {
+        n = hsh_blake3_compress_parents(cvs, n, key, flags, next);
+        memcpy(cvs, next, n * 32);
+    }
+    memcpy(out, cvs, 64);
+}
+
+/* ===== Multi-threaded subtrees ===== */
+
+typedef struct {
+    const uint8_t *data;
+    size_t piece_len;
+    const uint32_t *key;
+    uint64_t chunk_counter;
+    uint8_t flags;
+    uint8_t *cvs;
+} hsh_blake3_job;
+
+/* One equal, power-of-two sized piece of the subtree down to its own CV */
+static void hsh_blake3_piece(void *arg, size_t i)
+{
+    const hsh_blake3_job *job = arg;
+    uint64_t chunks = job->piece_len / HSH_BLAKE3_CHUNK_LEN;
+    uint8_t pair[64];
+    hsh_blake3_output o;
+
+    hsh_blake3_compress_subtree_to_parent(job->data + i * job->piece_len, job->piece_len, job->key,
+                                          job->chunk_counter + i * chunks, job->flags, pair);
+    hsh_blake3_parent_output(&o, pair, job->key, job->flags);
+    hsh_blake3_output_cv(&o, job->cvs + i * 32);
+}
+
+/* Same contract as hsh_blake3_compress_subtree_to_parent for a power-of-two
+ * sized subtree, with its pieces hashed on the worker pool */
+static void hsh_blake3_compress_subtree_parallel(const uint8_t *data, size_t len, const uint32_t key[8],
+                                                 uint64_t chunk_counter, uint8_t flags, uint8_t out[64])
+{
+    uint8_t cvs[HSH_BLAKE3_MAX_PIECES * 32];
+    size_t pieces = 2;
+    size_t target = 4 * hsh_pool_threads();
+
+    while (pieces < target && pieces < HSH_BLAKE3_MAX_PIECES &&
+           len / (2 * pieces) >= HSH_BLAKE3_PARALLEL_PIECE)
+        pieces *= 2;
+
+    hsh_blake3_job job = {data, len / pieces, key, chunk_counter, flags, cvs};
+    hsh_pool_run(hsh_blake3_piece, &job, pieces);
+
+    /* Pieces are complete subtrees, so pairing them up rebuilds the tree */
+    while (pieces > 2) {
+        for (size_t i = 0; i < pieces / 2; i++) {
+            hsh_blake3_output o;
+            hsh_blake3_parent_output(&o, cvs + 64 * i, key, flags);
+            hsh_blake3_output_cv(&o, cvs + 32 * i);
+        }
+        pieces /= 2;
+    }
+    memcpy(out, cvs, 64);
+}
+
+/* ============================================
+ * CV stack
+ * ============================================ */
+
+/* Merge completed subtrees: after total_chunks chunks the stack holds one
+ * CV per set bit of the count. Merging lazily keeps the rightmost CV around
+ * until it is known not to be the root. */
+static void hsh_blake3_merge_cv_stack(hsh_blake3_ctx *ctx, uint64_t total_chunks)
+{
+    size_t post_merge_len = (size_t)__builtin_popcountll(total_chunks);
+
+    while (ctx->cv_stack_len > post_merge_len) {
+        uint8_t *parent = ctx->cv_stack + (ctx->cv_stack_len - 2) * 32;
+        hsh_blake3_output o;
+        hsh_blake3_parent_output(&o, parent, ctx->key, ctx->chunk.flags);
+        hsh_blake3_output_cv(&o, parent);
+        ctx->cv_stack_len--;
+    }
+}
+
+static void hsh_blake3_push_cv(hsh_blake3_ctx *ctx, const uint8_t cv[32], uint64_t chunk_counter)
+{
+    hsh_blake3_merge_cv_stack(ctx, chunk_counter);
+    memcpy(ctx->cv_stack + ctx->cv_stack_len * 32, cv, 32);
+    ctx->cv_stack_len++;
+}
+
+/* ============================================
+ * Public API
+ * ============================================ */
+
+static void hsh_blake3_init_key_words(hsh_blake3_ctx *ctx, const uint32_t key[8], uint8_t flags)
+{
+    memcpy(ctx->key, key, 32);
+    hsh_blake3_chunk_init(&ctx->chunk, key, 0, flags);
+    ctx->cv_stack_len = 0;
+}
+
+void hsh_blake3_init(hsh_blake3_ctx *ctx)
+{
+    hsh_blake3_init_key_words(ctx, HSH_BLAKE2S_IV, 0);
+}
+
+void hsh_blake3_init_keyed(hsh_blake3_ctx *ctx, const uint8_t key[HSH_BLAKE3_KEY_LEN])
+{
+    uint32_t words[8];
+    for (int i = 0; i < 8; i++)
+        words[i] = hsh_blake3_load32(key + 4 * i);
+    hsh_blake3_init_key_words(ctx, words, HSH_BLAKE3_KEYED_HASH);
+}
+
+void hsh_blake3_init_derive_key(hsh_blake3_ctx *ctx, const char *context)
+{
+    uint8_t context_key[HSH_BLAKE3_KEY_LEN];
+    uint32_t words[8];
+
+    hsh_blake3_init_key_words(ctx, HSH_BLAKE2S_IV, HSH_BLAKE3_DERIVE_KEY_CONTEXT);
+    hsh_blake3_update(ctx, (const uint8_t *)context, strlen(context));
+    hsh_blake3_finalize(ctx, context_key, sizeof(context_key));
+
+    for (int i = 0; i < 8; i++)
+        words[i] = hsh_blake3_load32(context_key + 4 * i);
+    hsh_blake3_init_key_words(ctx, words, HSH_BLAKE3_DERIVE_KEY_MATERIAL);
+}
+
+static void hsh_blake3_update_impl(hsh_blake3_ctx *ctx, const uint8_t *data, size_t len, int parallel)
+{
+    /* Finish a partly filled chunk first */
+    if (hsh_blake3_chunk_len(&ctx->chunk) > 0) {
+        size_t take = HSH_BLAKE3_CHUNK_LEN - hsh_blake3_chunk_len(&ctx->chunk);
+        if (take > len) take = len;
+        hsh_blake3_chunk_update(&ctx->chunk, data, take);
+        data += take;
+        len -= take;
+        if (len == 0) return;
+
+        uint8_t cv[32];
+        hsh_blake3_output o;
+        hsh_blake3_chunk_output(&ctx->chunk, &o);
+        hsh_blake3_output_cv(&o, cv);
+        hsh_blake3_push_cv(ctx, cv, ctx->chunk.chunk_counter);
+        hsh_blake3_chunk_init(&ctx->chunk, ctx->key, ctx->chunk.chunk_counter + 1, ctx->chunk.flags);
+    }
+
+    /* Whole subtrees, as large as the input and the tree alignment allow.
+     * Their CVs are only merged lazily, so finalize can still treat the
+     * last of them as the root's children. */
+    while (len > HSH_BLAKE3_CHUNK_LEN) {
+        size_t subtree_len = hsh_blake3_round_down_pow2(len);
+        uint64_t offset = ctx->chunk.chunk_counter * HSH_BLAKE3_CHUNK_LEN;
+        while (((uint64_t)(subtree_len - 1) & offset) != 0)
+            subtree_len /= 2;
+        uint64_t subtree_chunks = subtree_len / HSH_BLAKE3_CHUNK_LEN;
+
+        if (subtree_len <= HSH_BLAKE3_CHUNK_LEN) {
+            hsh_blake3_chunk_state cs;
+            hsh_blake3_output o;
+            uint8_t cv[32];
+            hsh_blake3_chunk_init(&cs, ctx->key, ctx->chunk.chunk_counter, ctx->chunk.flags);
+            hsh_blake3_chunk_update(&cs, data, subtree_len);
+            hsh_blake3_chunk_output(&cs, &o);
+            hsh_blake3_output_cv(&o, cv);
+            hsh_blake3_push_cv(ctx, cv, cs.chunk_counter);
+        } else {
+            uint8_t pair[64];
+            if (parallel && subtree_len >= HSH_BLAKE3_PARALLEL_MIN)
+                hsh_blake3_compress_subtree_parallel(data, subtree_len, ctx->key,
+                                                     ctx->chunk.chunk_counter, ctx->chunk.flags, pair);
+            else
+                hsh_blake3_compress_subtree_to_parent(data, subtree_len, ctx->key,
+                                                      ctx->chunk.chunk_counter, ctx->chunk.flags, pair);
+            hsh_blake3_push_cv(ctx, pair, ctx->chunk.chunk_counter);
+            hsh_blake3_push_cv(ctx, pair + 32, ctx->chunk.chunk_counter + subtree_chunks / 2);
+        }
+        ctx->chunk.chunk_counter += subtree_chunks;
+        data += subtree_len;
+        len -= subtree_len;
+    }
+
+    if (len > 0) {
+        hsh_blake3_chunk_update(&ctx->chunk, data, len);
+        hsh_blake3_merge_cv_stack(ctx, ctx->chunk.chunk_counter);
+    }
+}
+
+void hsh_blake3_update(hsh_blake3_ctx *ctx, const uint8_t *data, size_t len)
+{
+    hsh_blake3_update_impl(ctx, data, len, 0);
+}
+
+void hsh_blake3_update_parallel(hsh_blake3_ctx *ctx, const uint8_t *data, size_t len)
+{
+    hsh_blake3_update_impl(ctx, data, len, 1);
+}
+
+void hsh_blake3_finalize(const hsh_blake3_ctx *ctx, uint8_t *out, size_t out_len)
+{
+    hsh_blake3_output o;
+    size_t remaining;
+
+    /* Only one chunk so far: it is the root */
+    if (ctx->cv_stack_len == 0) {
+        hsh_blake3_chunk_output(&ctx->chunk, &o);
+        hsh_blake3_output_root(&o, out, out_len);
+        return;
+    }
+
+    /* Otherwise fold the current chunk (or, if it is empty, the top two
+     * stack entries) into every CV left on the stack, right to left */
+    if (hsh_blake3_chunk_len(&ctx->chunk) > 0) {
+        remaining = ctx->cv_stack_len;
+        hsh_blake3_chunk_output(&ctx->chunk, &o);
+    } else {
+        remaining = ctx->cv_stack_len - 2;
+        hsh_blake3_parent_output(&o, ctx->cv_stack + remaining * 32, ctx->key, ctx->chunk.flags);
+    }
+    while (remaining > 0) {
+        uint8_t block[64];
+        remaining--;
+        memcpy(block, ctx->cv_stack + remaining * 32, 32);
+        hsh_blake3_output_cv(&o, block + 32);
+        hsh_blake3_parent_output(&o, block, ctx->key, ctx->chunk.flags);
+    }
+    hsh_blake3_output_root(&o, out, out_len);
+}
+
+/* ===== One-shot ===== */
+
+/* A single-chunk input is its own root: compress it straight from data and
+ * skip the context and CV stack entirely */
+static void hsh_blake3_oneshot(const uint32_t key[8], uint8_t flags, const uint8_t *data,
+                               size_t len, uint8_t *out, size_t out_len)
+{
+    if (len <= HSH_BLAKE3_CHUNK_LEN) {
+        hsh_blake3_output o;
+        size_t blocks = len > 0 ? (len - 1) / 64 : 0;
+        uint8_t start = HSH_BLAKE3_CHUNK_START;
+
+        memcpy(o.cv, key, 32);
+        for (size_t i = 0; i < blocks; i++) {
+            hsh_blake3_compress_in_place(o.cv, data + 64 * i, 64, 0, flags | start);
+            start = 0;
+        }
+        o.block_len = (uint8_t)(len - 64 * blocks);
+        memset(o.block, 0, sizeof(o.block));
+        memcpy(o.block, data + 64 * blocks, o.block_len);
+        o.counter = 0;
+        o.flags = flags | start | HSH_BLAKE3_CHUNK_END;
+        hsh_blake3_output_root(&o, out, out_len);
+        return;
+    }
+
+    hsh_blake3_ctx ctx;
+    hsh_blake3_init_key_words(&ctx, key, flags);
+    hsh_blake3_update(&ctx, data, len);
+    hsh_blake3_finalize(&ctx, out, out_len);
+}
+
+void hsh_blake3(const uint8_t *data, size_t len, uint8_t *out, size_t out_len)
+{
+    hsh_blake3_oneshot(HSH_BLAKE2S_IV, 0, data, len, out, out_len);
+}
+
+void hsh_blake3_keyed(const uint8_t key[HSH_BLAKE3_KEY_LEN], const uint8_t *data, size_t len,
+                      uint8_t *out, size_t out_len)
+{
+    uint32_t words[8];
+    for (int i = 0; i < 8; i++)
+        words[i] = hsh_blake3_load32(key + 4 * i);
+    hsh_blake3_oneshot(words, HSH_BLAKE3_KEYED_HASH, data, len, out, out_len);
+}
@@ -0,0 +1,126 @@
+#include "blake3_internal.h"
+#include "blake2_internal.h"
+
+#if HSH_X86
+#include <immintrin.h>
+
+/*
+ * Eight BLAKE3 inputs at once: vector j holds state word j of every input,
+ * so each G works on eight independent compressions. Message blocks are
+ * transposed into the same word-major layout on load.
+ */
+
+#define HSH_B3_X8_ROR16(x) _mm256_shuffle_epi8((x), ROT16)
+#define HSH_B3_X8_ROR8(x)  _mm256_shuffle_epi8((x), ROT8)
+#define HSH_B3_X8_ROR12(x) _mm256_or_si256(_mm256_srli_epi32((x), 12), _mm256_slli_epi32((x), 20))
+#define HSH_B3_X8_ROR7(x)  _mm256_or_si256(_mm256_srli_epi32((x), 7), _mm256_slli_epi32((x), 25))
+
+#define HSH_B3_X8_G(a, b, c, d, x, y) do { \
+    a = _mm256_add_epi32(_mm256_add_epi32(a, b), x); \
+    d = HSH_B3_X8_ROR16(_mm256_xor_si256(d, a)); \
+    c = _mm256_add_epi32(c, d); \
+    b = HSH_B3_X8_ROR12(_mm256_xor_si256(b, c)); \
+    a = _mm256_add_epi32(_mm256_add_epi32(a, b), y); \
+    d = HSH_B3_X8_ROR8(_mm256_xor_si256(d, a)); \
+    c = _mm256_add_epi32(c, d); \
+    b = HSH_B3_X8_ROR7(_mm256_xor_si256(b, c)); \
+} while (0)
+
+/* 8x8 transpose of 32-bit words: row i becomes column i */
+__attribute__((target("avx2")))
+static inline void hsh_blake3_transpose8(__m256i r[8]) {
+    __m256i t[8], u[8];
+    int i;
+    for (i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for (i = 0; i < 8; i += 4) {
+        u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (i = 0; i < 4; i++) {
+        r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+__attribute__((target("avx2")))
+void hsh_blake3_hash8_avx2(const uint8_t *const inputs[8], size_t blocks, const uint32_t key[8],
+                           uint64_t counter, int increment_counter, uint8_t flags,
+                           uint8_t flags_start, uint8_t flags_end, uint8_t *out) {
+    const __m256i ROT16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                           2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i ROT8 = _mm256_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+                                          1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    uint32_t ctr_lo[8], ctr_hi[8];
+    __m256i h[8], m[16];
+    uint8_t block_flags = flags | flags_start;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        uint64_t c = counter + (increment_counter ? (uint64_t)i : 0);
+        ctr_lo[i] = (uint32_t)c;
+        ctr_hi[i] = (uint32_t)(c >> 32);
+        h[i] = _mm256_set1_epi32((int)key[i]);
+    }
+    const __m256i counter_lo = _mm256_loadu_si256((const __m256i *)ctr_lo);
+    const __m256i counter_hi = _mm256_loadu_si256((const __m256i *)ctr_hi);
+    const __m256i iv0 = _mm256_set1_epi32((int)HSH_BLAKE2S_IV[0]);
+    const __m256i iv1 = _mm256_set1_epi32((int)HSH_BLAKE2S_IV[1]);
+    const __m256i iv2 = _mm256_set1_epi32((int)HSH_BLAKE2S_IV[2]);
+    const __m256i iv3 = _mm256_set1_epi32((int)HSH_BLAKE2S_IV[3]);
+
+    for (size_t b = 0; b < blocks; b++) {
+        if (b + 1 == blocks) block_flags |= flags_end;
+
+        for (i = 0; i < 8; i++) {
+            m[i] = _mm256_loadu_si256((const __m256i *)(inputs[i] + 64 * b));
+            m[i + 8] = _mm256_loadu_si256((const __m256i *)(inputs[i] + 64 * b + 32));
+        }
+        hsh_blake3_transpose8(m);
+        hsh_blake3_transpose8(m + 8);
+
+        __m256i v0 = h[0], v1 = h[1], v2 = h[2], v3 = h[3];
+        __m256i v4 = h[4], v5 = h[5], v6 = h[6], v7 = h[7];
+        __m256i v8 = iv0;
+        __m256i v9 = iv1;
+        __m256i v10 = iv2;
+        __m256i v11 = iv3;
+        __m256i v12 = counter_lo;
+        __m256i v13 = counter_hi;
+        __m256i v14 = _mm256_set1_epi32(64);
+        __m256i v15 = _mm256_set1_epi32(block_flags);
+
+        for (int r = 0; r < 7; r++) {
+            const uint8_t *s = HSH_BLAKE3_MSG_SCHEDULE[r];
+            HSH_B3_X8_G(v0, v4, v8, v12, m[s[0]], m[s[1]]);
+            HSH_B3_X8_G(v1, v5, v9, v13, m[s[2]], m[s[3]]);
+            HSH_B3_X8_G(v2, v6, v10, v14, m[s[4]], m[s[5]]);
+            HSH_B3_X8_G(v3, v7, v11, v15, m[s[6]], m[s[7]]);
+            HSH_B3_X8_G(v0, v5, v10, v15, m[s[8]], m[s[9]]);
+            HSH_B3_X8_G(v1, v6, v11, v12, m[s[10]], m[s[11]]);
+            HSH_B3_X8_G(v2, v7, v8, v13, m[s[12]], m[s[13]]);
+            HSH_B3_X8_G(v3, v4, v9, v14, m[s[14]], m[s[15]]);
+        }
+
+        h[0] = _mm256_xor_si256(v0, v8);
+        h[1] = _mm256_xor_si256(v1, v9);
+        h[2] = _mm256_xor_si256(v2, v10);
+        h[3] = _mm256_xor_si256(v3, v11);
+        h[4] = _mm256_xor_si256(v4, v12);
+        h[5] = _mm256_xor_si256(v5, v13);
+        h[6] = _mm256_xor_si256(v6, v14);
+        h[7] = _mm256_xor_si256(v7, v15);
+        block_flags = flags;
+    }
+
+    /* Back to one 32-byte CV per input */
+    hsh_blake3_transpose8(h);
+    for (i = 0; i < 8; i++)
+        _mm256_storeu_si256((__m256i *)(out + 32 * i), h[i]);
+}
+
+#endif /* HSH_X86 */
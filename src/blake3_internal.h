@@ -0,0 +1,40 @@
+#ifndef HSH_BLAKE3_INTERNAL_H
+#define HSH_BLAKE3_INTERNAL_H
+
+/* Internal: BLAKE3 compression and multi-input backends. */
+
+#include "blake3.h"
+#include "cpu.h"
+
+/* Domain flags */
+#define HSH_BLAKE3_CHUNK_START         (1u << 0)
+#define HSH_BLAKE3_CHUNK_END           (1u << 1)
+#define HSH_BLAKE3_PARENT              (1u << 2)
+#define HSH_BLAKE3_ROOT                (1u << 3)
+#define HSH_BLAKE3_KEYED_HASH          (1u << 4)
+#define HSH_BLAKE3_DERIVE_KEY_CONTEXT  (1u << 5)
+#define HSH_BLAKE3_DERIVE_KEY_MATERIAL (1u << 6)
+
+/* Widest multi-input backend (AVX2, 8 inputs) */
+#define HSH_BLAKE3_MAX_SIMD_DEGREE 8
+
+/* Message word order for each of the 7 rounds */
+extern const uint8_t HSH_BLAKE3_MSG_SCHEDULE[7][16];
+
+/*
+ * Hash several equal-length inputs of `blocks` 64-byte blocks each, starting
+ * from `key`, and write one 32-byte chaining value per input to out. Input i
+ * uses counter + i when increment_counter is set (chunks), else counter
+ * (parent nodes). flags_start / flags_end are added on the first and last
+ * block of each input.
+ */
+#if HSH_X86
+void hsh_blake3_hash4_sse41(const uint8_t *const inputs[4], size_t blocks, const uint32_t key[8],
+                            uint64_t counter, int increment_counter, uint8_t flags,
+                            uint8_t flags_start, uint8_t flags_end, uint8_t *out);
+void hsh_blake3_hash8_avx2(const uint8_t *const inputs[8], size_t blocks, const uint32_t key[8],
+                           uint64_t counter, int increment_counter, uint8_t flags,
+                           uint8_t flags_start, uint8_t flags_end, uint8_t *out);
+#endif
+
+#endif /* HSH_BLAKE3_INTERNAL_H */
@@ -0,0 +1,115 @@
+#include "blake3_internal.h"
+#include "blake2_internal.h"
+
+#if HSH_X86
+#include <immintrin.h>
+
+/* Four BLAKE3 inputs at once; same word-major layout as the AVX2 backend */
+
+#define HSH_B3_X4_ROR16(x) _mm_shuffle_epi8((x), ROT16)
+#define HSH_B3_X4_ROR8(x)  _mm_shuffle_epi8((x), ROT8)
+#define HSH_B3_X4_ROR12(x) _mm_or_si128(_mm_srli_epi32((x), 12), _mm_slli_epi32((x), 20))
+#define HSH_B3_X4_ROR7(x)  _mm_or_si128(_mm_srli_epi32((x), 7), _mm_slli_epi32((x), 25))
+
+#define HSH_B3_X4_G(a, b, c, d, x, y) do { \
+    a = _mm_add_epi32(_mm_add_epi32(a, b), x); \
+    d = HSH_B3_X4_ROR16(_mm_xor_si128(d, a)); \
+    c = _mm_add_epi32(c, d); \
+    b = HSH_B3_X4_ROR12(_mm_xor_si128(b, c)); \
+    a = _mm_add_epi32(_mm_add_epi32(a, b), y); \
+    d = HSH_B3_X4_ROR8(_mm_xor_si128(d, a)); \
+    c = _mm_add_epi32(c, d); \
+    b = HSH_B3_X4_ROR7(_mm_xor_si128(b, c)); \
+} while (0)
+
+/* 4x4 transpose of 32-bit words: row i becomes column i */
+__attribute__((target("ssse3,sse4.1")))
+static inline void hsh_blake3_transpose4(__m128i r[4]) {
+    __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+    __m128i t1 = _mm_unpackhi_epi32(r[0], r[1]);
+    __m128i t2 = _mm_unpacklo_epi32(r[2], r[3]);
+    __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+    r[0] = _mm_unpacklo_epi64(t0, t2);
+    r[1] = _mm_unpackhi_epi64(t0, t2);
+    r[2] = _mm_unpacklo_epi64(t1, t3);
+    r[3] = _mm_unpackhi_epi64(t1, t3);
+}
+
+__attribute__((target("ssse3,sse4.1")))
+void hsh_blake3_hash4_sse41(const uint8_t *const inputs[4], size_t blocks, const uint32_t key[8],
+                            uint64_t counter, int increment_counter, uint8_t flags,
+                            uint8_t flags_start, uint8_t flags_end, uint8_t *out) {
+    const __m128i ROT16 = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m128i ROT8 = _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    uint32_t ctr_lo[4], ctr_hi[4];
+    __m128i h[8], m[16];
+    uint8_t block_flags = flags | flags_start;
+    int i, k;
+
+    for (i = 0; i < 4; i++) {
+        uint64_t c = counter + (increment_counter ? (uint64_t)i : 0);
+        ctr_lo[i] = (uint32_t)c;
+        ctr_hi[i] = (uint32_t)(c >> 32);
+    }
+    for (i = 0; i < 8; i++)
+        h[i] = _mm_set1_epi32((int)key[i]);
+    const __m128i counter_lo = _mm_loadu_si128((const __m128i *)ctr_lo);
+    const __m128i counter_hi = _mm_loadu_si128((const __m128i *)ctr_hi);
+    const __m128i iv0 = _mm_set1_epi32((int)HSH_BLAKE2S_IV[0]);
+    const __m128i iv1 = _mm_set1_epi32((int)HSH_BLAKE2S_IV[1]);
+    const __m128i iv2 = _mm_set1_epi32((int)HSH_BLAKE2S_IV[2]);
+    const __m128i iv3 = _mm_set1_epi32((int)HSH_BLAKE2S_IV[3]);
+
+    for (size_t b = 0; b < blocks; b++) {
+        if (b + 1 == blocks) block_flags |= flags_end;
+
+        for (k = 0; k < 4; k++) {
+            for (i = 0; i < 4; i++)
+                m[4*k + i] = _mm_loadu_si128((const __m128i *)(inputs[i] + 64 * b + 16 * k));
+            hsh_blake3_transpose4(m + 4*k);
+        }
+
+        __m128i v0 = h[0], v1 = h[1], v2 = h[2], v3 = h[3];
+        __m128i v4 = h[4], v5 = h[5], v6 = h[6], v7 = h[7];
+        __m128i v8 = iv0;
+        __m128i v9 = iv1;
+        __m128i v10 = iv2;
+        __m128i v11 = iv3;
+        __m128i v12 = counter_lo;
+        __m128i v13 = counter_hi;
+        __m128i v14 = _mm_set1_epi32(64);
+        __m128i v15 = _mm_set1_epi32(block_flags);
+
+        for (int r = 0; r < 7; r++) {
+            const uint8_t *s = HSH_BLAKE3_MSG_SCHEDULE[r];
+            HSH_B3_X4_G(v0, v4, v8, v12, m[s[0]], m[s[1]]);
+            HSH_B3_X4_G(v1, v5, v9, v13, m[s[2]], m[s[3]]);
+            HSH_B3_X4_G(v2, v6, v10, v14, m[s[4]], m[s[5]]);
+            HSH_B3_X4_G(v3, v7, v11, v15, m[s[6]], m[s[7]]);
+            HSH_B3_X4_G(v0, v5, v10, v15, m[s[8]], m[s[9]]);
+            HSH_B3_X4_G(v1, v6, v11, v12, m[s[10]], m[s[11]]);
+            HSH_B3_X4_G(v2, v7, v8, v13, m[s[12]], m[s[13]]);
+            HSH_B3_X4_G(v3, v4, v9, v14, m[s[14]], m[s[15]]);
+        }
+
+        h[0] = _mm_xor_si128(v0, v8);
+        h[1] = _mm_xor_si128(v1, v9);
+        h[2] = _mm_xor_si128(v2, v10);
+        h[3] = _mm_xor_si128(v3, v11);
+        h[4] = _mm_xor_si128(v4, v12);
+        h[5] = _mm_xor_si128(v5, v13);
+        h[6] = _mm_xor_si128(v6, v14);
+        h[7] = _mm_xor_si128(v7, v15);
+        block_flags = flags;
+    }
+
+    /* Words 0..3 and 4..7 of each input's CV */
+    hsh_blake3_transpose4(h);
+    hsh_blake3_transpose4(h + 4);
+    for (i = 0; i < 4; i++) {
+        _mm_storeu_si128((__m128i *)(out + 32 * i), h[i]);
+        _mm_storeu_si128((__m128i *)(out + 32 * i + 16), h[i + 4]);
+    }
+}
+
+#endif /* HSH_X86 */
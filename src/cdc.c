@@ -0,0 +1,222 @@
+#include "cdc.h"
+#include "blake2.h"
+#include "sha2.h"
+#include "pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Chunks cut before their digests are handed to the pool together */
+#define HSH_CDC_BATCH 64
+
+/* ==== Gear table ==== */
+
+/*
+ * 256 random 64-bit values, one per byte value. They are part of the
+ * chunking format: any change moves every cut point, so they come from a
+ * fixed-seed splitmix64 rather than anything run dependent.
+ */
+static uint64_t hsh_cdc_gear[256];
+static pthread_once_t hsh_cdc_gear_once = PTHREAD_ONCE_INIT;
+
+static void hsh_cdc_gear_init(void) {
+    uint64_t x = 0x6873682d63646331ULL;  /* "hsh-cdc1" */
+    for (int i = 0; i < 256; i++) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        hsh_cdc_gear[i] = z ^ (z >> 31);
+    }
+}
+
+/* ==== Cut points ==== */
+
+/*
+ * FastCDC with normalization level 2: no cut in the first min_size bytes,
+ * a mask with two extra bits up to avg_size and two fewer bits after it,
+ * and a forced cut at max_size. The masks test the top bits of the Gear
+ * hash, which depend on the last 64 bytes.
+ *
+ * Searches the chunk p[0..n) from *pos with hash *fp. Returns the chunk
+ * length at a cut, or 0 if more data is needed, saving the resume point.
+ */
+static size_t hsh_cdc_find(const hsh_cdc_ctx *ctx, const uint8_t *p, size_t n,
+                           size_t *pos, uint64_t *fp) {
+    size_t i = *pos < ctx->params.min_size ? ctx->params.min_size : *pos;
+    size_t end = n < ctx->params.max_size ? n : ctx->params.max_size;
+    size_t mid = ctx->params.avg_size < end ? ctx->params.avg_size : end;
+    uint64_t h = *fp;
+
+    for (; i < mid; i++) {
+        h = (h << 1) + hsh_cdc_gear[p[i]];
+        if (!(h & ctx->mask_s)) return i + 1;
+    }
+    for (; i < end; i++) {
+        h = (h << 1) + hsh_cdc_gear[p[i]];
+        if (!(h & ctx->mask_l)) return i + 1;
+    }
+    if (end == ctx->params.max_size) return end;
+
+    *pos = i;
+    *fp = h;
+    return 0;
+}
+
+/* ==== Digests ==== */
+
+static void hsh_cdc_hash(hsh_cdc_digest digest, const uint8_t *data, size_t len,
+                         uint8_t out[HSH_CDC_DIGEST_SIZE]) {
+    if (digest == HSH_CDC_SHA256)
+        hsh_sha2_256(data, len, out);
+    else
+        (void)hsh_blake2b(data, len, out, HSH_CDC_DIGEST_SIZE, NULL, 0);
+}
+
+typedef struct {
+    hsh_cdc_digest digest;
+    const uint8_t *base;
+    hsh_cdc_chunk *chunks;
+} hsh_cdc_job;
+
+static void hsh_cdc_hash_task(void *arg, size_t i) {
+    hsh_cdc_job *job = arg;
+    hsh_cdc_chunk *c = &job->chunks[i];
+    hsh_cdc_hash(job->digest, job->base + c->offset, c->length, c->digest);
+}
+
+/* Emits one chunk; data points at its first byte */
+static void hsh_cdc_emit_one(hsh_cdc_ctx *ctx, const uint8_t *data, size_t len) {
+    hsh_cdc_chunk c;
+
+    c.offset = ctx->offset;
+    c.length = len;
+    hsh_cdc_hash(ctx->params.digest, data, len, c.digest);
+    ctx->emit(ctx->arg, &c, data);
+    ctx->offset += len;
+}
+
+/* Hashes a batch on the pool, then emits it in order. The offsets are
+ * relative to data on entry. */
+static void hsh_cdc_emit_batch(hsh_cdc_ctx *ctx, const uint8_t *data, hsh_cdc_chunk *batch,
+                               size_t count) {
+    hsh_cdc_job job = { ctx->params.digest, data, batch };
+
+    hsh_pool_run(hsh_cdc_hash_task, &job, count);
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = data + batch[i].offset;
+        batch[i].offset = ctx->offset;
+        ctx->emit(ctx->arg, &batch[i], p);
+        ctx->offset += batch[i].length;
+    }
+}
+
+/*
+ * Cuts and emits every complete chunk of data[0..len), which starts at a
+ * chunk boundary, and returns the length of the unfinished tail. Single
+ * threaded, each chunk is hashed right after its cut is found; with
+ * workers, batches of chunks are hashed on the pool.
+ */
+static size_t hsh_cdc_direct(hsh_cdc_ctx *ctx, const uint8_t *data, size_t len,
+                             size_t *scan_pos, uint64_t *fp) {
+    hsh_cdc_chunk batch[HSH_CDC_BATCH];
+    int parallel = hsh_pool_threads() > 1;
+    size_t count = 0, pos = 0;
+
+    for (;;) {
+        size_t cut;
+
+        *scan_pos = 0;
+        *fp = 0;
+        cut = hsh_cdc_find(ctx, data + pos, len - pos, scan_pos, fp);
+        if (cut == 0) break;
+
+        if (!parallel) {
+            hsh_cdc_emit_one(ctx, data + pos, cut);
+            pos += cut;
+            continue;
+        }
+
+        batch[count].offset = pos;
+        batch[count].length = cut;
+        count++;
+        pos += cut;
+        if (count == HSH_CDC_BATCH) {
+            hsh_cdc_emit_batch(ctx, data, batch, count);
+            count = 0;
+        }
+    }
+
+    if (count > 0) hsh_cdc_emit_batch(ctx, data, batch, count);
+    return len - pos;
+}
+
+/* ==== Public API ==== */
+
+int hsh_cdc_init(hsh_cdc_ctx *ctx, const hsh_cdc_params *params, hsh_cdc_emit_fn emit, void *arg) {
+    size_t avg_bits = 0;
+
+    if (params->min_size < HSH_CDC_MIN_LIMIT || params->min_size > params->avg_size ||
+        params->avg_size > params->max_size || params->max_size > HSH_CDC_MAX_LIMIT ||
+        (params->digest != HSH_CDC_BLAKE2B_256 && params->digest != HSH_CDC_SHA256))
+        return -1;
+
+    pthread_once(&hsh_cdc_gear_once, hsh_cdc_gear_init);
+
+    /* Nearest power of two to avg_size (at least 64) */
+    while (((size_t)2 << avg_bits) <= params->avg_size)
+        avg_bits++;
+    if (params->avg_size - ((size_t)1 << avg_bits) > ((size_t)1 << avg_bits) / 2)
+        avg_bits++;
+
+    ctx->params = *params;
+    ctx->mask_s = ~0ULL << (64 - (avg_bits + 2));
+    ctx->mask_l = ~0ULL << (64 - (avg_bits - 2));
+    ctx->emit = emit;
+    ctx->arg = arg;
+    ctx->offset = 0;
+    ctx->pending_len = 0;
+    ctx->scan_pos = 0;
+    ctx->fp = 0;
+    ctx->pending = malloc(params->max_size);
+    return ctx->pending ? 0 : -1;
+}
+
+void hsh_cdc_update(hsh_cdc_ctx *ctx, const uint8_t *data, size_t len) {
+    /* Complete the buffered chunk first. Its cut always lies in the bytes
+     * just copied, so whatever follows the cut can be taken from data
+     * again instead of staying in the buffer. */
+    while (ctx->pending_len > 0 && len > 0) {
+        size_t take = ctx->params.max_size - ctx->pending_len;
+        size_t cut, rest;
+
+        if (take > len) take = len;
+        memcpy(ctx->pending + ctx->pending_len, data, take);
+        ctx->pending_len += take;
+        data += take;
+        len -= take;
+
+        cut = hsh_cdc_find(ctx, ctx->pending, ctx->pending_len, &ctx->scan_pos, &ctx->fp);
+        if (cut == 0) return;
+
+        hsh_cdc_emit_one(ctx, ctx->pending, cut);
+        rest = ctx->pending_len - cut;
+        data -= rest;
+        len += rest;
+        ctx->pending_len = 0;
+        ctx->scan_pos = 0;
+        ctx->fp = 0;
+    }
+    if (len == 0) return;
+
+    size_t tail = hsh_cdc_direct(ctx, data, len, &ctx->scan_pos, &ctx->fp);
+    memcpy(ctx->pending, data + len - tail, tail);
+    ctx->pending_len = tail;
+}
+
+void hsh_cdc_finalize(hsh_cdc_ctx *ctx) {
+    if (ctx->pending_len > 0)
+        hsh_cdc_emit_one(ctx, ctx->pending, ctx->pending_len);
+    free(ctx->pending);
+    ctx->pending = NULL;
+    ctx->pending_len = 0;
+}
@@ -0,0 +1,85 @@
+#include "cpu.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if HSH_X86
+#include <cpuid.h>
+#endif
+
+/* Bit 31 marks the cached value as valid */
+#define HSH_CPU_PROBED (1u << 31)
+
+static unsigned hsh_cpu_cached;
+
+#if HSH_X86
+static unsigned hsh_cpu_xgetbv(void) {
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+}
+
+static unsigned hsh_cpu_probe(void) {
+    unsigned eax, ebx, ecx, edx;
+    unsigned features = 0;
+    unsigned max_leaf = __get_cpuid_max(0, 0);
+
+    if (max_leaf < 1) return 0;
+    __cpuid(1, eax, ebx, ecx, edx);
+
+    if (edx & (1u << 26)) features |= HSH_CPU_SSE2;
+    if (ecx & (1u << 9))  features |= HSH_CPU_SSSE3;
+    if (ecx & (1u << 19)) features |= HSH_CPU_SSE41;
+
+    /* AVX needs both the CPU flag and OS support for saving YMM state */
+    int ymm_ok = 0;
+    if ((ecx & (1u << 27)) && (ecx & (1u << 28))) {
+        ymm_ok = (hsh_cpu_xgetbv() & 0x6) == 0x6;
+        if (ymm_ok) features |= HSH_CPU_AVX;
+    }
+
+    if (max_leaf >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if (ymm_ok && (ebx & (1u << 5))) features |= HSH_CPU_AVX2;
+        if (ebx & (1u << 29)) features |= HSH_CPU_SHA;
+    }
+
+    return features;
+}
+#else
+static unsigned hsh_cpu_probe(void) {
+    return 0;
+}
+#endif
+
+/* Features allowed by the HSH_CPU environment variable (all if unset) */
+static unsigned hsh_cpu_env_mask(void) {
+    static const struct { const char *name; unsigned flag; } names[] = {
+        {"sse2", HSH_CPU_SSE2}, {"ssse3", HSH_CPU_SSSE3}, {"sse41", HSH_CPU_SSE41},
+        {"avx", HSH_CPU_AVX}, {"avx2", HSH_CPU_AVX2}, {"sha", HSH_CPU_SHA},
+    };
+    const char *env = getenv("HSH_CPU");
+    unsigned mask = 0;
+
+    /* An empty HSH_CPU (e.g. HSH_CPU= in a script) counts as unset */
+    if (!env || !*env) return ~0u;
+    while (*env) {
+        size_t len = strcspn(env, ", ");
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (strlen(names[i].name) == len && strncmp(env, names[i].name, len) == 0)
+                mask |= names[i].flag;
+        }
+        env += len;
+        if (*env) env++;
+    }
+    return mask;
+}
+
+unsigned hsh_cpu_features(void) {
+    unsigned f = __atomic_load_n(&hsh_cpu_cached, __ATOMIC_RELAXED);
+    if (f & HSH_CPU_PROBED) return f & ~HSH_CPU_PROBED;
+
+    /* Probing is idempotent, so racing threads simply store the same value */
+    f = hsh_cpu_probe() & hsh_cpu_env_mask();
+    __atomic_store_n(&hsh_cpu_cached, f | HSH_CPU_PROBED, __ATOMIC_RELAXED);
+    return f;
+}
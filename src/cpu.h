@@ -0,0 +1,30 @@
+#ifndef HSH_CPU_H
+#define HSH_CPU_H
+
+/* Internal: runtime CPU feature detection used to pick compression backends. */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HSH_X86 1
+#else
+#define HSH_X86 0
+#endif
+
+#define HSH_CPU_SSE2   (1u << 0)
+#define HSH_CPU_SSSE3  (1u << 1)
+#define HSH_CPU_SSE41  (1u << 2)
+#define HSH_CPU_AVX    (1u << 3)
+#define HSH_CPU_AVX2   (1u << 4)
+#define HSH_CPU_SHA    (1u << 5)
+
+/* Everything the SHA-NI kernels execute: besides the SHA extensions they
+ * use pshufb (SSSE3) and pblendw (SSE4.1) */
+#define HSH_CPU_SHANI  (HSH_CPU_SHA | HSH_CPU_SSSE3 | HSH_CPU_SSE41)
+
+/* Bitmask of HSH_CPU_* flags usable on this machine (probed once, cached).
+ * For debugging, HSH_CPU="sse2,ssse3,..." limits it to the listed features
+ * (names as below, lower case); any other value, e.g. "none", selects the
+ * portable code everywhere. An empty HSH_CPU is the same as unset. Features
+ * the CPU lacks are never added. */
+unsigned hsh_cpu_features(void);
+
+#endif /* HSH_CPU_H */
@@ -0,0 +1,235 @@
+#include "hash.h"
+#include "cpu.h"
+#include <strings.h>
+
+/*
+ * Generic interface over the per-algorithm APIs. The adapters below only
+ * give every algorithm the same signatures; backend selection stays where
+ * it already is, at the dispatch point in each algorithm's compress
+ * function, which tests the CPU feature mask probed once by cpu.c.
+ */
+
+/* ==== Backend names (mirror the dispatch conditions of each algorithm) ==== */
+
+#define HSH_CPU_SSE41_BOTH (HSH_CPU_SSSE3 | HSH_CPU_SSE41)
+
+static const char *hsh_hash_backend_generic(void) {
+    return "generic";
+}
+
+static const char *hsh_hash_backend_shani(void) {
+    return (hsh_cpu_features() & HSH_CPU_SHANI) == HSH_CPU_SHANI ? "shani" : "generic";
+}
+
+static const char *hsh_hash_backend_avx2(void) {
+    return (hsh_cpu_features() & HSH_CPU_AVX2) ? "avx2" : "generic";
+}
+
+static const char *hsh_hash_backend_sse41(void) {
+    return (hsh_cpu_features() & HSH_CPU_SSE41_BOTH) == HSH_CPU_SSE41_BOTH ? "sse41" : "generic";
+}
+
+static const char *hsh_hash_backend_blake3(void) {
+    unsigned features = hsh_cpu_features();
+    if (features & HSH_CPU_AVX2) return "avx2";
+    if ((features & HSH_CPU_SSE41_BOTH) == HSH_CPU_SSE41_BOTH) return "sse41";
+    return "generic";
+}
+
+/* ==== Adapters ==== */
+
+/* Algorithms whose init / update / finalize / one-shot already have the
+ * generic shape, up to the context type */
+#define HSH_HASH_WRAP(NAME, FIELD, PREFIX)                                          \
+static void hsh_hash_##NAME##_init(void *ctx) {                                     \
+    PREFIX##_init(&((hsh_hash_ctx *)ctx)->u.FIELD);                                 \
+}                                                                                   \
+static void hsh_hash_##NAME##_update(void *ctx, const uint8_t *data, size_t len) {  \
+    PREFIX##_update(&((hsh_hash_ctx *)ctx)->u.FIELD, data, len);                    \
+}                                                                                   \
+static void hsh_hash_##NAME##_finalize(void *ctx, uint8_t *digest) {                \
+    PREFIX##_finalize(&((hsh_hash_ctx *)ctx)->u.FIELD, digest);                     \
+}                                                                                   \
+static void hsh_hash_##NAME##_oneshot(const uint8_t *data, size_t len, uint8_t *digest) { \
+    PREFIX(data, len, digest);                                                      \
+}
+
+HSH_HASH_WRAP(md5, md5, hsh_md5)
+HSH_HASH_WRAP(sha1, sha1, hsh_sha1)
+HSH_HASH_WRAP(sha224, sha256, hsh_sha2_224)
+HSH_HASH_WRAP(sha256, sha256, hsh_sha2_256)
+HSH_HASH_WRAP(sha384, sha512, hsh_sha2_384)
+HSH_HASH_WRAP(sha512, sha512, hsh_sha2_512)
+
+/* SHA-3: per-variant init and one-shot, shared update / finalize */
+#define HSH_HASH_WRAP_SHA3(NAME)                                                    \
+static void hsh_hash_##NAME##_init(void *ctx) {                                     \
+    hsh_##NAME##_init(&((hsh_hash_ctx *)ctx)->u.sha3);                              \
+}                                                                                   \
+static void hsh_hash_##NAME##_oneshot(const uint8_t *data, size_t len, uint8_t *digest) { \
+    hsh_##NAME(data, len, digest);                                                  \
+}
+
+HSH_HASH_WRAP_SHA3(sha3_224)
+HSH_HASH_WRAP_SHA3(sha3_256)
+HSH_HASH_WRAP_SHA3(sha3_384)
+HSH_HASH_WRAP_SHA3(sha3_512)
+
+static void hsh_hash_sha3_update(void *ctx, const uint8_t *data, size_t len) {
+    hsh_sha3_update(&((hsh_hash_ctx *)ctx)->u.sha3, data, len);
+}
+
+static void hsh_hash_sha3_finalize(void *ctx, uint8_t *digest) {
+    hsh_sha3_finalize(&((hsh_hash_ctx *)ctx)->u.sha3, digest);
+}
+
+/* SHAKE with a fixed output length of twice the security level */
+#define HSH_HASH_WRAP_SHAKE(NAME, OUT)                                              \
+static void hsh_hash_##NAME##_init(void *ctx) {                                     \
+    hsh_##NAME##_init(&((hsh_hash_ctx *)ctx)->u.sha3);                              \
+}                                                                                   \
+static void hsh_hash_##NAME##_finalize(void *ctx, uint8_t *digest) {                \
+    hsh_shake_squeeze(&((hsh_hash_ctx *)ctx)->u.sha3, digest, OUT);                 \
+}                                                                                   \
+static void hsh_hash_##NAME##_oneshot(const uint8_t *data, size_t len, uint8_t *digest) { \
+    hsh_##NAME(data, len, digest, OUT);                                             \
+}
+
+HSH_HASH_WRAP_SHAKE(shake128, 32)
+HSH_HASH_WRAP_SHAKE(shake256, 64)
+
+/* BLAKE2: unkeyed, full-length digest. init cannot fail with these
+ * parameters, so the status is dropped. */
+static void hsh_hash_blake2b_init(void *ctx) {
+    (void)hsh_blake2b_init(&((hsh_hash_ctx *)ctx)->u.blake2b, 64, NULL, 0, NULL, 0);
+}
+
+static void hsh_hash_blake2s_init(void *ctx) {
+    (void)hsh_blake2s_init(&((hsh_hash_ctx *)ctx)->u.blake2s, 32, NULL, 0, NULL, 0);
+}
+
+static void hsh_hash_blake2bp_init(void *ctx) {
+    (void)hsh_blake2bp_init(&((hsh_hash_ctx *)ctx)->u.blake2bp, 64, NULL, 0);
+}
+
+static void hsh_hash_blake2sp_init(void *ctx) {
+    (void)hsh_blake2sp_init(&((hsh_hash_ctx *)ctx)->u.blake2sp, 32, NULL, 0);
+}
+
+#define HSH_HASH_WRAP_BLAKE2(NAME, OUT)                                             \
+static void hsh_hash_##NAME##_update(void *ctx, const uint8_t *data, size_t len) {  \
+    hsh_##NAME##_update(&((hsh_hash_ctx *)ctx)->u.NAME, data, len);                 \
+}                                                                                   \
+static void hsh_hash_##NAME##_finalize(void *ctx, uint8_t *digest) {                \
+    hsh_##NAME##_finalize(&((hsh_hash_ctx *)ctx)->u.NAME, digest);                  \
+}                                                                                   \
+static void hsh_hash_##NAME##_oneshot(const uint8_t *data, size_t len, uint8_t *digest) { \
+    (void)hsh_##NAME(data, len, digest, OUT, NULL, 0);                              \
+}
+
+HSH_HASH_WRAP_BLAKE2(blake2b, 64)
+HSH_HASH_WRAP_BLAKE2(blake2s, 32)
+HSH_HASH_WRAP_BLAKE2(blake2bp, 64)
+HSH_HASH_WRAP_BLAKE2(blake2sp, 32)
+
+static void hsh_hash_blake3_init(void *ctx) {
+    hsh_blake3_init(&((hsh_hash_ctx *)ctx)->u.blake3);
+}
+
+static void hsh_hash_blake3_update(void *ctx, const uint8_t *data, size_t len) {
+    hsh_blake3_update(&((hsh_hash_ctx *)ctx)->u.blake3, data, len);
+}
+
+static void hsh_hash_blake3_finalize(void *ctx, uint8_t *digest) {
+    hsh_blake3_finalize(&((hsh_hash_ctx *)ctx)->u.blake3, digest, HSH_BLAKE3_OUT_LEN);
+}
+
+static void hsh_hash_blake3_oneshot(const uint8_t *data, size_t len, uint8_t *digest) {
+    hsh_blake3(data, len, digest, HSH_BLAKE3_OUT_LEN);
+}
+
+/* ==== Descriptors ==== */
+
+#define HSH_HASH_ALG(NAME, STR, BLOCK, DIGEST, UPDATE, FINALIZE, BACKEND)           \
+const hsh_hash_alg hsh_hash_##NAME = {                                              \
+    STR, BLOCK, DIGEST, hsh_hash_##NAME##_init, UPDATE, FINALIZE,                   \
+    hsh_hash_##NAME##_oneshot, BACKEND                                              \
+};
+
+#define HSH_HASH_ALG_STD(NAME, STR, BLOCK, DIGEST, BACKEND)                         \
+    HSH_HASH_ALG(NAME, STR, BLOCK, DIGEST, hsh_hash_##NAME##_update,                \
+                 hsh_hash_##NAME##_finalize, BACKEND)
+
+HSH_HASH_ALG_STD(md5, "md5", 64, 16, hsh_hash_backend_generic)
+HSH_HASH_ALG_STD(sha1, "sha1", 64, 20, hsh_hash_backend_shani)
+HSH_HASH_ALG_STD(sha224, "sha224", 64, 28, hsh_hash_backend_shani)
+HSH_HASH_ALG_STD(sha256, "sha256", 64, 32, hsh_hash_backend_shani)
+HSH_HASH_ALG_STD(sha384, "sha384", 128, 48, hsh_hash_backend_generic)
+HSH_HASH_ALG_STD(sha512, "sha512", 128, 64, hsh_hash_backend_generic)
+HSH_HASH_ALG(sha3_224, "sha3-224", 144, 28, hsh_hash_sha3_update, hsh_hash_sha3_finalize,
+             hsh_hash_backend_generic)
+HSH_HASH_ALG(sha3_256, "sha3-256", 136, 32, hsh_hash_sha3_update, hsh_hash_sha3_finalize,
+             hsh_hash_backend_generic)
+HSH_HASH_ALG(sha3_384, "sha3-384", 104, 48, hsh_hash_sha3_update, hsh_hash_sha3_finalize,
+             hsh_hash_backend_generic)
+HSH_HASH_ALG(sha3_512, "sha3-512", 72, 64, hsh_hash_sha3_update, hsh_hash_sha3_finalize,
+             hsh_hash_backend_generic)
+HSH_HASH_ALG(shake128, "shake128", 168, 32, hsh_hash_sha3_update, hsh_hash_shake128_finalize,
+             hsh_hash_backend_generic)
+HSH_HASH_ALG(shake256, "shake256", 136, 64, hsh_hash_sha3_update, hsh_hash_shake256_finalize,
+             hsh_hash_backend_generic)
+HSH_HASH_ALG_STD(blake2b, "blake2b", 128, 64, hsh_hash_backend_avx2)
+HSH_HASH_ALG_STD(blake2s, "blake2s", 64, 32, hsh_hash_backend_sse41)
+HSH_HASH_ALG_STD(blake2bp, "blake2bp", 128, 64, hsh_hash_backend_avx2)
+HSH_HASH_ALG_STD(blake2sp, "blake2sp", 64, 32, hsh_hash_backend_sse41)
+HSH_HASH_ALG_STD(blake3, "blake3", 64, 32, hsh_hash_backend_blake3)
+
+static const hsh_hash_alg *const hsh_hash_registry[] = {
+    &hsh_hash_md5, &hsh_hash_sha1,
+    &hsh_hash_sha224, &hsh_hash_sha256, &hsh_hash_sha384, &hsh_hash_sha512,
+    &hsh_hash_sha3_224, &hsh_hash_sha3_256, &hsh_hash_sha3_384, &hsh_hash_sha3_512,
+    &hsh_hash_shake128, &hsh_hash_shake256,
+    &hsh_hash_blake2b, &hsh_hash_blake2s, &hsh_hash_blake2bp, &hsh_hash_blake2sp,
+    &hsh_hash_blake3,
+};
+
+#define HSH_HASH_COUNT (sizeof(hsh_hash_registry) / sizeof(hsh_hash_registry[0]))
+
+/* ==== Public API ==== */
+
+const hsh_hash_alg *hsh_hash_find(const char *name) {
+    for (size_t i = 0; i < HSH_HASH_COUNT; i++) {
+        if (strcasecmp(hsh_hash_registry[i]->name, name) == 0)
+            return hsh_hash_registry[i];
+    }
+    return NULL;
+}
+
+size_t hsh_hash_count(void) {
+    return HSH_HASH_COUNT;
+}
+
+const hsh_hash_alg *hsh_hash_get(size_t index) {
+    return index < HSH_HASH_COUNT ? hsh_hash_registry[index] : NULL;
+}
+
+const char *hsh_hash_backend(const hsh_hash_alg *alg) {
+    return alg->backend();
+}
+
+void hsh_hash_init(hsh_hash_ctx *ctx, const hsh_hash_alg *alg) {
+    ctx->alg = alg;
+    alg->init(ctx);
+}
+
+void hsh_hash_update(hsh_hash_ctx *ctx, const uint8_t *data, size_t len) {
+    ctx->alg->update(ctx, data, len);
+}
+
+void hsh_hash_finalize(hsh_hash_ctx *ctx, uint8_t *digest) {
+    ctx->alg->finalize(ctx, digest);
+}
+
+void hsh_hash(const hsh_hash_alg *alg, const uint8_t *data, size_t len, uint8_t *digest) {
+    alg->oneshot(data, len, digest);
+}
@@ -0,0 +1,263 @@
+#include "hash.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Regular files below this size are read, mapping them costs more */
+#define HSH_HASH_FILE_MMAP_MIN  (64 * 1024)
+/* Buffer sizes: read() loop and each of the two pipeline buffers */
+#define HSH_HASH_FILE_READ_BUF  (64 * 1024)
+#define HSH_HASH_FILE_PIPE_BUF  (1024 * 1024)
+
+static double hsh_hash_file_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* read() that retries on EINTR; 0 at end of file */
+static ssize_t hsh_hash_file_read(int fd, uint8_t *buf, size_t len) {
+    ssize_t n;
+    do {
+        n = read(fd, buf, len);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+/* ==== mmap ==== */
+
+/* Returns 1 if the file could not be mapped, so the caller can fall back */
+static int hsh_hash_file_mmap(const hsh_hash_alg *alg, int fd, off_t offset, off_t size,
+                              uint8_t *digest, uint64_t *bytes) {
+    long page = sysconf(_SC_PAGESIZE);
+    off_t base = offset - offset % page;
+    size_t map_len = (size_t)(size - base);
+    uint8_t *map;
+
+    if ((off_t)map_len != size - base) return 1;
+    map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, base);
+    if (map == MAP_FAILED) return 1;
+    (void)madvise(map, map_len, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    (void)madvise(map, map_len, MADV_HUGEPAGE);
+#endif
+
+    /* BLAKE3 can split a mapped file into subtrees for the worker pool;
+     * the BLAKE2bp/sp leaves already go to the pool inside update() */
+    if (alg == &hsh_hash_blake3) {
+        hsh_blake3_ctx ctx;
+        hsh_blake3_init(&ctx);
+        hsh_blake3_update_parallel(&ctx, map + (offset - base), (size_t)(size - offset));
+        hsh_blake3_finalize(&ctx, digest, HSH_BLAKE3_OUT_LEN);
+    } else {
+        hsh_hash(alg, map + (offset - base), (size_t)(size - offset), digest);
+    }
+    munmap(map, map_len);
+
+    lseek(fd, size, SEEK_SET);
+    *bytes = (uint64_t)(size - offset);
+    return 0;
+}
+
+/* ==== read() loop ==== */
+
+/* Heap-allocated, so a read on a small thread stack cannot overflow it */
+typedef struct {
+    hsh_hash_ctx ctx;
+    uint8_t buf[HSH_HASH_FILE_READ_BUF];
+} hsh_hash_file_readbuf;
+
+static int hsh_hash_file_readloop(const hsh_hash_alg *alg, int fd, uint8_t *digest,
+                                  uint64_t *bytes) {
+    hsh_hash_file_readbuf *rb = malloc(sizeof(*rb));
+    ssize_t n;
+    int err;
+
+    if (!rb) return -1;
+    hsh_hash_init(&rb->ctx, alg);
+    while ((n = hsh_hash_file_read(fd, rb->buf, sizeof(rb->buf))) > 0) {
+        hsh_hash_update(&rb->ctx, rb->buf, (size_t)n);
+        *bytes += (uint64_t)n;
+    }
+    if (n < 0) {
+        err = errno;
+        free(rb);
+        errno = err;
+        return -1;
+    }
+    hsh_hash_finalize(&rb->ctx, digest);
+    free(rb);
+    return 0;
+}
+
+/* ==== Pipeline ==== */
+
+/*
+ * The reader thread fills buf[0], buf[1], buf[0], ... and hands each one
+ * over with full[i] set; the hashing thread gives it back by clearing the
+ * flag. last[i] marks the buffer that ended in EOF or a read error.
+ */
+typedef struct {
+    int fd;
+    uint8_t *buf[2];
+    size_t len[2];
+    int full[2];
+    int last[2];
+    int err;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} hsh_hash_file_pipe;
+
+static void *hsh_hash_file_reader(void *arg) {
+    hsh_hash_file_pipe *p = arg;
+    int idx = 0, last = 0;
+
+    while (!last) {
+        size_t len = 0;
+        int err = 0;
+
+        pthread_mutex_lock(&p->lock);
+        while (p->full[idx])
+            pthread_cond_wait(&p->cond, &p->lock);
+        pthread_mutex_unlock(&p->lock);
+
+        /* Fill the whole buffer: pipes deliver at most 64 KiB per read */
+        while (len < HSH_HASH_FILE_PIPE_BUF) {
+            ssize_t n = hsh_hash_file_read(p->fd, p->buf[idx] + len, HSH_HASH_FILE_PIPE_BUF - len);
+            if (n <= 0) {
+                if (n < 0) err = errno;
+                last = 1;
+                break;
+            }
+            len += (size_t)n;
+        }
+
+        pthread_mutex_lock(&p->lock);
+        p->len[idx] = len;
+        p->last[idx] = last;
+        p->full[idx] = 1;
+        if (err) p->err = err;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+        idx ^= 1;
+    }
+    return NULL;
+}
+
+static int hsh_hash_file_pipeline(const hsh_hash_alg *alg, int fd, uint8_t *digest,
+                                  uint64_t *bytes) {
+    hsh_hash_file_pipe p = { .fd = fd };
+    hsh_hash_ctx ctx;
+    pthread_t reader;
+    int idx = 0, last = 0, err;
+
+    p.buf[0] = malloc(2 * (size_t)HSH_HASH_FILE_PIPE_BUF);
+    if (!p.buf[0]) return -1;
+    p.buf[1] = p.buf[0] + HSH_HASH_FILE_PIPE_BUF;
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.cond, NULL);
+
+    err = pthread_create(&reader, NULL, hsh_hash_file_reader, &p);
+    if (err) {
+        pthread_cond_destroy(&p.cond);
+        pthread_mutex_destroy(&p.lock);
+        free(p.buf[0]);
+        errno = err;
+        return -1;
+    }
+
+    hsh_hash_init(&ctx, alg);
+    while (!last) {
+        pthread_mutex_lock(&p.lock);
+        while (!p.full[idx])
+            pthread_cond_wait(&p.cond, &p.lock);
+        pthread_mutex_unlock(&p.lock);
+
+        hsh_hash_update(&ctx, p.buf[idx], p.len[idx]);
+        *bytes += p.len[idx];
+        last = p.last[idx];
+
+        pthread_mutex_lock(&p.lock);
+        p.full[idx] = 0;
+        pthread_cond_broadcast(&p.cond);
+        pthread_mutex_unlock(&p.lock);
+        idx ^= 1;
+    }
+
+    pthread_join(reader, NULL);
+    err = p.err;
+    pthread_cond_destroy(&p.cond);
+    pthread_mutex_destroy(&p.lock);
+    free(p.buf[0]);
+
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    hsh_hash_finalize(&ctx, digest);
+    return 0;
+}
+
+/* ==== Public API ==== */
+
+int hsh_hash_fd(const hsh_hash_alg *alg, int fd, uint8_t *digest, hsh_hash_file_stats *stats) {
+    hsh_hash_file_strategy strategy = HSH_HASH_FILE_PIPELINE;
+    double start = hsh_hash_file_now();
+    uint64_t bytes = 0;
+    struct stat st;
+    int ret = -1;
+
+    if (fstat(fd, &st) != 0) return -1;
+
+    if (S_ISREG(st.st_mode)) {
+        off_t offset = lseek(fd, 0, SEEK_CUR);
+        if (offset >= 0 && st.st_size - offset >= HSH_HASH_FILE_MMAP_MIN) {
+            ret = hsh_hash_file_mmap(alg, fd, offset, st.st_size, digest, &bytes);
+            if (ret == 0) strategy = HSH_HASH_FILE_MMAP;
+        } else if (offset >= 0) {
+            ret = hsh_hash_file_readloop(alg, fd, digest, &bytes);
+            strategy = HSH_HASH_FILE_READ;
+            if (ret != 0) return -1;
+        }
+    }
+    if (ret != 0 && hsh_hash_file_pipeline(alg, fd, digest, &bytes) != 0)
+        return -1;
+
+    if (stats) {
+        stats->strategy = strategy;
+        stats->bytes = bytes;
+        stats->seconds = hsh_hash_file_now() - start;
+        stats->gbps = stats->seconds > 0 ? (double)bytes / stats->seconds * 1e-9 : 0.0;
+    }
+    return 0;
+}
+
+int hsh_hash_file(const hsh_hash_alg *alg, const char *path, uint8_t *digest,
+                  hsh_hash_file_stats *stats) {
+    int fd, ret, saved;
+
+    do {
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) return -1;
+
+    ret = hsh_hash_fd(alg, fd, digest, stats);
+    saved = errno;
+    close(fd);
+    errno = saved;
+    return ret;
+}
+
+const char *hsh_hash_file_strategy_name(hsh_hash_file_strategy strategy) {
+    switch (strategy) {
+    case HSH_HASH_FILE_MMAP: return "mmap";
+    case HSH_HASH_FILE_READ: return "read";
+    case HSH_HASH_FILE_PIPELINE: return "pipeline";
+    }
+    return "unknown";
+}
@@ -0,0 +1,58 @@
+#include "hash.h"
+#include "pool.h"
+
+/* Tile size when one thread runs every algorithm: the tile stays in L1
+ * between algorithms */
+#define HSH_HASH_MULTI_TILE      (16 * 1024)
+/* Tile per pool round when threaded: large enough to amortize waking the
+ * workers, small enough for the shared L2 / L3 */
+#define HSH_HASH_MULTI_PAR_TILE  (256 * 1024)
+
+typedef struct {
+    hsh_hash_multi_ctx *ctx;
+    const uint8_t *data;
+    size_t len;
+} hsh_hash_multi_job;
+
+static void hsh_hash_multi_task(void *arg, size_t index) {
+    hsh_hash_multi_job *job = arg;
+    hsh_hash_update(&job->ctx->ctx[index], job->data, job->len);
+}
+
+int hsh_hash_multi_init(hsh_hash_multi_ctx *ctx, const hsh_hash_alg *const *algs, size_t count,
+                        int threaded) {
+    if (count == 0 || count > HSH_HASH_MULTI_MAX) return -1;
+
+    ctx->count = count;
+    ctx->threaded = threaded;
+    for (size_t i = 0; i < count; i++)
+        hsh_hash_init(&ctx->ctx[i], algs[i]);
+    return 0;
+}
+
+void hsh_hash_multi_update(hsh_hash_multi_ctx *ctx, const uint8_t *data, size_t len) {
+    if (ctx->threaded && ctx->count > 1 && len >= HSH_HASH_MULTI_PAR_TILE &&
+        hsh_pool_threads() > 1) {
+        hsh_hash_multi_job job = { ctx, data, 0 };
+        while (len > 0) {
+            job.len = len < HSH_HASH_MULTI_PAR_TILE ? len : HSH_HASH_MULTI_PAR_TILE;
+            hsh_pool_run(hsh_hash_multi_task, &job, ctx->count);
+            job.data += job.len;
+            len -= job.len;
+        }
+        return;
+    }
+
+    while (len > 0) {
+        size_t n = len < HSH_HASH_MULTI_TILE ? len : HSH_HASH_MULTI_TILE;
+        for (size_t i = 0; i < ctx->count; i++)
+            hsh_hash_update(&ctx->ctx[i], data, n);
+        data += n;
+        len -= n;
+    }
+}
+
+void hsh_hash_multi_finalize(hsh_hash_multi_ctx *ctx, uint8_t *const *digests) {
+    for (size_t i = 0; i < ctx->count; i++)
+        hsh_hash_finalize(&ctx->ctx[i], digests[i]);
+}
@@ -0,0 +1,72 @@
+#include "hmac.h"
+#include <string.h>
+
+/*
+ * HMAC(K, m) = H((K ^ opad) || H((K ^ ipad) || m)). The ipad / opad blocks
+ * are absorbed once at init; update feeds the inner context directly and
+ * finalize runs the single outer compression over the inner digest.
+ */
+
+#define HSH_HMAC_IPAD 0x36
+#define HSH_HMAC_OPAD 0x5c
+
+/* Clear key-derived scratch; the volatile stores keep the compiler from
+ * dropping them as dead, which it may do with a plain memset */
+static void hsh_hmac_wipe(void *buf, size_t len) {
+    volatile uint8_t *p = buf;
+    while (len--) *p++ = 0;
+}
+
+#define HSH_HMAC_DEFINE(NAME, CTX, HASH, BLOCK, DIGEST)                                      \
+void hsh_hmac_##NAME##_init(CTX *ctx, const uint8_t *key, size_t key_len)                   \
+{                                                                                            \
+    uint8_t pad[BLOCK];                                                                      \
+    uint8_t key_digest[DIGEST];                                                              \
+                                                                                             \
+    if (key_len > BLOCK) {                                                                   \
+        HASH(key, key_len, key_digest);                                                      \
+        key = key_digest;                                                                    \
+        key_len = DIGEST;                                                                    \
+    }                                                                                        \
+                                                                                             \
+    memset(pad, HSH_HMAC_IPAD, BLOCK);                                                       \
+    for (size_t i = 0; i < key_len; i++)                                                     \
+        pad[i] ^= key[i];                                                                    \
+    HASH##_init(&ctx->inner);                                                                \
+    HASH##_update(&ctx->inner, pad, BLOCK);                                                  \
+                                                                                             \
+    for (size_t i = 0; i < BLOCK; i++)                                                       \
+        pad[i] ^= HSH_HMAC_IPAD ^ HSH_HMAC_OPAD;                                             \
+    HASH##_init(&ctx->outer);                                                                \
+    HASH##_update(&ctx->outer, pad, BLOCK);                                                  \
+    hsh_hmac_wipe(pad, sizeof(pad));                                                         \
+    hsh_hmac_wipe(key_digest, sizeof(key_digest));                                           \
+}                                                                                            \
+                                                                                             \
+void hsh_hmac_##NAME##_update(CTX *ctx, const uint8_t *data, size_t len)                    \
+{                                                                                            \
+    HASH##_update(&ctx->inner, data, len);                                                   \
+}                                                                                            \
+                                                                                             \
+void hsh_hmac_##NAME##_finalize(CTX *ctx, uint8_t mac[DIGEST])                              \
+{                                                                                            \
+    uint8_t inner[DIGEST];                                                                   \
+    HASH##_finalize(&ctx->inner, inner);                                                     \
+    HASH##_update(&ctx->outer, inner, DIGEST);                                               \
+    HASH##_finalize(&ctx->outer, mac);                                                       \
+    hsh_hmac_wipe(inner, sizeof(inner));                                                     \
+}                                                                                            \
+                                                                                             \
+void hsh_hmac_##NAME(const CTX *key, const uint8_t *data, size_t len, uint8_t mac[DIGEST])  \
+{                                                                                            \
+    CTX ctx = *key;                                                                          \
+    hsh_hmac_##NAME##_update(&ctx, data, len);                                               \
+    hsh_hmac_##NAME##_finalize(&ctx, mac);                                                   \
+    hsh_hmac_wipe(&ctx, sizeof(ctx));                                                        \
+}
+
+HSH_HMAC_DEFINE(sha1,   hsh_hmac_sha1_ctx,   hsh_sha1,     64,  20)
+HSH_HMAC_DEFINE(sha224, hsh_hmac_sha224_ctx, hsh_sha2_224, 64,  28)
+HSH_HMAC_DEFINE(sha256, hsh_hmac_sha256_ctx, hsh_sha2_256, 64,  32)
+HSH_HMAC_DEFINE(sha384, hsh_hmac_sha384_ctx, hsh_sha2_384, 128, 48)
+HSH_HMAC_DEFINE(sha512, hsh_hmac_sha512_ctx, hsh_sha2_512, 128, 64)
@@ -1,17 +1,11 @@
 /* hsh_md5.c */
 #include "md5.h"
+#include "md5_internal.h"
 #include <stdlib.h>
 #include <string.h>
 
-static const uint32_t hsh_S[64] = {
-    7,12,17,22, 7,12,17,22, 7,12,17,22, 7,12,17,22,
-    5,9,14,20, 5,9,14,20, 5,9,14,20, 5,9,14,20,
-    4,11,16,23, 4,11,16,23, 4,11,16,23, 4,11,16,23,
-    6,10,15,21, 6,10,15,21, 6,10,15,21, 6,10,15,21
-};
-
 /* Precomputed MD5 K constants (hexadecimal, little-endian order) */
-static const uint32_t hsh_K[64] = {
+const uint32_t hsh_md5_K[64] = {
     0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
     0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
     0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
@@ -30,47 +24,63 @@ static const uint32_t hsh_K[64] = {
     0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
 };
 
-static uint32_t hsh_left_rotate(uint32_t x, uint32_t c) {
+static inline uint32_t hsh_md5_rotl(uint32_t x, int c) {
     return (x << c) | (x >> (32 - c));
 }
 
-static void hsh_md5_process_chunk(hsh_md5_ctx *ctx, const unsigned char chunk[64]) {
-    uint32_t X[16];
-    for (int i = 0; i < 16; i++) {
-        X[i] = (uint32_t)chunk[i*4]
-             | ((uint32_t)chunk[i*4 + 1] << 8)
-             | ((uint32_t)chunk[i*4 + 2] << 16)
-             | ((uint32_t)chunk[i*4 + 3] << 24);
-    }
-
+/* Round functions; F and G in bit-select form, one operation shorter than
+ * the textbook and / or / not */
+#define HSH_MD5_FN_F(b, c, d) ((d) ^ ((b) & ((c) ^ (d))))
+#define HSH_MD5_FN_G(b, c, d) ((c) ^ ((d) & ((b) ^ (c))))
+#define HSH_MD5_FN_H(b, c, d) ((b) ^ (c) ^ (d))
+#define HSH_MD5_FN_I(b, c, d) ((c) ^ ((b) | ~(d)))
+
+/* Message word, constant and rotation are all literals after expansion */
+#define HSH_MD5_STEP(fn, a, b, c, d, x, t, s) do { \
+    a += HSH_MD5_FN_##fn(b, c, d) + X[x] + hsh_md5_K[t]; \
+    a = b + hsh_md5_rotl(a, s); \
+} while (0)
+
+/* Fully unrolled compression; the chaining value stays in registers
+ * across the blocks */
+void hsh_md5_blocks(hsh_md5_ctx *ctx, const unsigned char *data, size_t nblocks) {
     uint32_t A = ctx->A, B = ctx->B, C = ctx->C, D = ctx->D;
-    uint32_t f, g, temp;
-
-    for (int i = 0; i < 64; i++) {
-        if (i < 16) {
-            f = (B & C) | ((~B) & D);
-            g = i;
-        } else if (i < 32) {
-            f = (B & D) | (C & (~D));
-            g = (5 * i + 1) % 16;
-        } else if (i < 48) {
-            f = B ^ C ^ D;
-            g = (3 * i + 5) % 16;
-        } else {
-            f = C ^ (B | (~D));
-            g = (7 * i) % 16;
+
+    for (; nblocks > 0; nblocks--, data += 64) {
+        uint32_t X[16];
+        uint32_t a0 = A, b0 = B, c0 = C, d0 = D;
+
+        for (int i = 0; i < 16; i++) {
+            X[i] = (uint32_t)data[i*4]
+                 | ((uint32_t)data[i*4 + 1] << 8)
+                 | ((uint32_t)data[i*4 + 2] << 16)
+                 | ((uint32_t)data[i*4 + 3] << 24);
         }
-        temp = D;
-        D = C;
-        C = B;
-        B = (B + hsh_left_rotate(A + f + hsh_K[i] + X[g], hsh_S[i])) & 0xFFFFFFFF;
-        A = temp;
+
+        HSH_MD5_ROUNDS(HSH_MD5_STEP);
+
+        A += a0;
+        B += b0;
+        C += c0;
+        D += d0;
     }
 
-    ctx->A += A;
-    ctx->B += B;
-    ctx->C += C;
-    ctx->D += D;
+    ctx->A = A;
+    ctx->B = B;
+    ctx->C = C;
+    ctx->D = D;
+}
+
+size_t hsh_md5_pad(unsigned char out[128], const unsigned char *tail, size_t tail_len,
+                   uint64_t bit_len) {
+    size_t total = (tail_len < 56) ? 64 : 128;
+
+    memcpy(out, tail, tail_len);
+    out[tail_len] = 0x80;
+    memset(out + tail_len + 1, 0, total - tail_len - 1 - 8);
+    for (int i = 0; i < 8; i++)
+        out[total - 8 + i] = (unsigned char)((bit_len >> (8 * i)) & 0xFF);
+    return total / 64;
 }
 
 /* Public API */
@@ -96,15 +106,14 @@ void hsh_md5_update(hsh_md5_ctx *ctx, const unsigned char *data, size_t len) {
             return;
         } else {
             memcpy(ctx->buffer + ctx->buffer_len, data, fill);
-            hsh_md5_process_chunk(ctx, ctx->buffer);
+            hsh_md5_blocks(ctx, ctx->buffer, 1);
             ctx->buffer_len = 0;
             i += fill;
         }
     }
 
-    for (; i + 64 <= len; i += 64) {
-        hsh_md5_process_chunk(ctx, data + i);
-    }
+    hsh_md5_blocks(ctx, data + i, (len - i) / 64);
+    i += (len - i) / 64 * 64;
 
     if (i < len) {
         size_t rem = len - i;
@@ -113,21 +122,7 @@ void hsh_md5_update(hsh_md5_ctx *ctx, const unsigned char *data, size_t len) {
     }
 }
 
-void hsh_md5_finalize(hsh_md5_ctx *ctx, unsigned char digest[16]) {
-    unsigned char padding[64] = {0x80};
-    unsigned char length_encoded[8];
-    uint64_t bits = ctx->counter;
-
-    for (int i = 0; i < 8; i++)
-        length_encoded[i] = (unsigned char)((bits >> (8 * i)) & 0xFF);
-
-    size_t pad_len = (ctx->buffer_len < 56)
-        ? (56 - ctx->buffer_len)
-        : (120 - ctx->buffer_len);
-
-    hsh_md5_update(ctx, padding, pad_len);
-    hsh_md5_update(ctx, length_encoded, 8);
-
+void hsh_md5_store(const hsh_md5_ctx *ctx, unsigned char digest[16]) {
     uint32_t words[4] = {ctx->A, ctx->B, ctx->C, ctx->D};
     for (int i = 0; i < 4; i++) {
         digest[i*4 + 0] = (unsigned char)(words[i] & 0xFF);
@@ -136,3 +131,29 @@ void hsh_md5_finalize(hsh_md5_ctx *ctx, unsigned char digest[16]) {
         digest[i*4 + 3] = (unsigned char)((words[i] >> 24) & 0xFF);
     }
 }
+
+void hsh_md5_finalize(hsh_md5_ctx *ctx, unsigned char digest[16]) {
+    unsigned char last[128];
+    size_t nblocks = hsh_md5_pad(last, ctx->buffer, ctx->buffer_len, ctx->counter);
+
+    hsh_md5_blocks(ctx, last, nblocks);
+    ctx->buffer_len = 0;
+    hsh_md5_store(ctx, digest);
+}
+
+/* One-shot: only the chaining words of the context are used; whole blocks
+ * come straight from data and the padded tail is built on the stack */
+void hsh_md5(const unsigned char *data, size_t len, unsigned char digest[16]) {
+    hsh_md5_ctx st;
+    unsigned char last[128];
+    size_t full = len / 64;
+
+    st.A = 0x67452301;
+    st.B = 0xefcdab89;
+    st.C = 0x98badcfe;
+    st.D = 0x10325476;
+    hsh_md5_blocks(&st, data, full);
+    size_t nblocks = hsh_md5_pad(last, data + full * 64, len - full * 64, (uint64_t)len * 8);
+    hsh_md5_blocks(&st, last, nblocks);
+    hsh_md5_store(&st, digest);
+}
@@ -0,0 +1,84 @@
+#include "md5.h"
+#include "md5_internal.h"
+#include "batch_internal.h"
+
+/*
+ * Multi-buffer MD5: one message per SIMD lane (4 with SSE2, 8 with AVX2),
+ * fed by the shared lane scheduler in batch.c. state[j][lane] holds word
+ * j (A..D) of each lane's chaining value.
+ */
+
+typedef struct {
+    uint32_t state[4][HSH_MD5_MAX_LANES];
+    size_t lanes;
+} hsh_md5_lanes;
+
+static size_t hsh_md5_lanes_pad(void *arg, unsigned char *out, const unsigned char *tail,
+                                size_t tail_len, uint64_t len) {
+    (void)arg;
+    return hsh_md5_pad(out, tail, tail_len, len * 8);
+}
+
+#if HSH_X86
+static void hsh_md5_lanes_kernel(void *arg, const unsigned char *const *blocks) {
+    hsh_md5_lanes *s = arg;
+    if (s->lanes == 8)
+        hsh_md5_x8_avx2(s->state, blocks);
+    else
+        hsh_md5_x4_sse2(s->state, blocks);
+}
+#endif
+
+static void hsh_md5_lanes_reset(void *arg, size_t lane) {
+    hsh_md5_lanes *s = arg;
+    hsh_md5_ctx iv;
+    hsh_md5_init(&iv);
+    s->state[0][lane] = iv.A; s->state[1][lane] = iv.B;
+    s->state[2][lane] = iv.C; s->state[3][lane] = iv.D;
+}
+
+/* A context holding one lane's chaining value, for the scalar code */
+static void hsh_md5_lanes_get(const hsh_md5_lanes *s, size_t lane, hsh_md5_ctx *ctx) {
+    hsh_md5_init(ctx);
+    ctx->A = s->state[0][lane]; ctx->B = s->state[1][lane];
+    ctx->C = s->state[2][lane]; ctx->D = s->state[3][lane];
+}
+
+static void hsh_md5_lanes_compress(void *arg, size_t lane, const unsigned char *data,
+                                   size_t nblocks) {
+    hsh_md5_lanes *s = arg;
+    hsh_md5_ctx ctx;
+
+    if (nblocks == 0) return;
+    hsh_md5_lanes_get(s, lane, &ctx);
+    hsh_md5_blocks(&ctx, data, nblocks);
+    s->state[0][lane] = ctx.A; s->state[1][lane] = ctx.B;
+    s->state[2][lane] = ctx.C; s->state[3][lane] = ctx.D;
+}
+
+static void hsh_md5_lanes_store(void *arg, size_t lane, unsigned char *digest) {
+    hsh_md5_ctx ctx;
+    hsh_md5_lanes_get(arg, lane, &ctx);
+    hsh_md5_store(&ctx, digest);
+}
+
+void hsh_md5_batch(const unsigned char *const *data, const size_t *lens,
+                   size_t count, unsigned char *digests) {
+    hsh_md5_lanes s;
+    hsh_batch_engine engine = {
+        0, 64, 16, &s,
+        hsh_md5_lanes_pad, NULL, hsh_md5_lanes_reset,
+        hsh_md5_lanes_compress, hsh_md5_lanes_store,
+    };
+#if HSH_X86
+    unsigned features = hsh_cpu_features();
+    if (features & HSH_CPU_AVX2)
+        engine.lanes = 8;
+    else if (features & HSH_CPU_SSE2)
+        engine.lanes = 4;
+    if (engine.lanes)
+        engine.kernel = hsh_md5_lanes_kernel;
+#endif
+    s.lanes = engine.lanes;
+    hsh_batch_run(&engine, data, lens, count, digests);
+}
@@ -0,0 +1,69 @@
+#ifndef HSH_MD5_INTERNAL_H
+#define HSH_MD5_INTERNAL_H
+
+/* Internal: pieces of md5.c shared with the multi-buffer engine. */
+
+#include "md5.h"
+#include "cpu.h"
+
+#define HSH_MD5_MAX_LANES 8
+
+extern const uint32_t hsh_md5_K[64];
+
+/* Compress nblocks consecutive 64-byte blocks into ctx */
+void hsh_md5_blocks(hsh_md5_ctx *ctx, const unsigned char *data, size_t nblocks);
+
+/* Write the padded final block(s) for a message ending in tail[0..tail_len)
+ * (tail_len < 64) into out; returns the number of 64-byte blocks (1 or 2) */
+size_t hsh_md5_pad(unsigned char out[128], const unsigned char *tail, size_t tail_len,
+                   uint64_t bit_len);
+
+/* Write the little-endian digest of the chaining words A..D of ctx */
+void hsh_md5_store(const hsh_md5_ctx *ctx, unsigned char digest[16]);
+
+/*
+ * The 64 MD5 steps as STEP(fn, a, b, c, d, word, step, shift), computing
+ * a = b + rotl(a + fn(b, c, d) + X[word] + K[step], shift).
+ */
+#define HSH_MD5_ROUNDS(STEP) \
+    STEP(F, A, B, C, D,  0,  0,  7); STEP(F, D, A, B, C,  1,  1, 12); \
+    STEP(F, C, D, A, B,  2,  2, 17); STEP(F, B, C, D, A,  3,  3, 22); \
+    STEP(F, A, B, C, D,  4,  4,  7); STEP(F, D, A, B, C,  5,  5, 12); \
+    STEP(F, C, D, A, B,  6,  6, 17); STEP(F, B, C, D, A,  7,  7, 22); \
+    STEP(F, A, B, C, D,  8,  8,  7); STEP(F, D, A, B, C,  9,  9, 12); \
+    STEP(F, C, D, A, B, 10, 10, 17); STEP(F, B, C, D, A, 11, 11, 22); \
+    STEP(F, A, B, C, D, 12, 12,  7); STEP(F, D, A, B, C, 13, 13, 12); \
+    STEP(F, C, D, A, B, 14, 14, 17); STEP(F, B, C, D, A, 15, 15, 22); \
+    STEP(G, A, B, C, D,  1, 16,  5); STEP(G, D, A, B, C,  6, 17,  9); \
+    STEP(G, C, D, A, B, 11, 18, 14); STEP(G, B, C, D, A,  0, 19, 20); \
+    STEP(G, A, B, C, D,  5, 20,  5); STEP(G, D, A, B, C, 10, 21,  9); \
+    STEP(G, C, D, A, B, 15, 22, 14); STEP(G, B, C, D, A,  4, 23, 20); \
+    STEP(G, A, B, C, D,  9, 24,  5); STEP(G, D, A, B, C, 14, 25,  9); \
+    STEP(G, C, D, A, B,  3, 26, 14); STEP(G, B, C, D, A,  8, 27, 20); \
+    STEP(G, A, B, C, D, 13, 28,  5); STEP(G, D, A, B, C,  2, 29,  9); \
+    STEP(G, C, D, A, B,  7, 30, 14); STEP(G, B, C, D, A, 12, 31, 20); \
+    STEP(H, A, B, C, D,  5, 32,  4); STEP(H, D, A, B, C,  8, 33, 11); \
+    STEP(H, C, D, A, B, 11, 34, 16); STEP(H, B, C, D, A, 14, 35, 23); \
+    STEP(H, A, B, C, D,  1, 36,  4); STEP(H, D, A, B, C,  4, 37, 11); \
+    STEP(H, C, D, A, B,  7, 38, 16); STEP(H, B, C, D, A, 10, 39, 23); \
+    STEP(H, A, B, C, D, 13, 40,  4); STEP(H, D, A, B, C,  0, 41, 11); \
+    STEP(H, C, D, A, B,  3, 42, 16); STEP(H, B, C, D, A,  6, 43, 23); \
+    STEP(H, A, B, C, D,  9, 44,  4); STEP(H, D, A, B, C, 12, 45, 11); \
+    STEP(H, C, D, A, B, 15, 46, 16); STEP(H, B, C, D, A,  2, 47, 23); \
+    STEP(I, A, B, C, D,  0, 48,  6); STEP(I, D, A, B, C,  7, 49, 10); \
+    STEP(I, C, D, A, B, 14, 50, 15); STEP(I, B, C, D, A,  5, 51, 21); \
+    STEP(I, A, B, C, D, 12, 52,  6); STEP(I, D, A, B, C,  3, 53, 10); \
+    STEP(I, C, D, A, B, 10, 54, 15); STEP(I, B, C, D, A,  1, 55, 21); \
+    STEP(I, A, B, C, D,  8, 56,  6); STEP(I, D, A, B, C, 15, 57, 10); \
+    STEP(I, C, D, A, B,  6, 58, 15); STEP(I, B, C, D, A, 13, 59, 21); \
+    STEP(I, A, B, C, D,  4, 60,  6); STEP(I, D, A, B, C, 11, 61, 10); \
+    STEP(I, C, D, A, B,  2, 62, 15); STEP(I, B, C, D, A,  9, 63, 21)
+
+#if HSH_X86
+/* One block in each of 4 (SSE2) or 8 (AVX2) independent messages.
+ * state[j][lane] holds word j (A..D) of lane's chaining value. */
+void hsh_md5_x4_sse2(uint32_t state[4][HSH_MD5_MAX_LANES], const unsigned char *const blocks[4]);
+void hsh_md5_x8_avx2(uint32_t state[4][HSH_MD5_MAX_LANES], const unsigned char *const blocks[8]);
+#endif
+
+#endif /* HSH_MD5_INTERNAL_H */
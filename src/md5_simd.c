@@ -0,0 +1,110 @@
+#include "md5_internal.h"
+
+#if HSH_X86
+#include <immintrin.h>
+
+/* ===== SSE2: 4 lanes ===== */
+
+#define HSH_MD5_V4_F(b,c,d) _mm_xor_si128((d), _mm_and_si128((b), _mm_xor_si128((c), (d))))
+#define HSH_MD5_V4_G(b,c,d) _mm_xor_si128((c), _mm_and_si128((d), _mm_xor_si128((b), (c))))
+#define HSH_MD5_V4_H(b,c,d) _mm_xor_si128(_mm_xor_si128((b), (c)), (d))
+#define HSH_MD5_V4_I(b,c,d) _mm_xor_si128((c), _mm_or_si128((b), _mm_xor_si128((d), ONES)))
+
+#define HSH_MD5_V4_STEP(fn, a, b, c, d, x, t, s) do { \
+    __m128i sum = _mm_add_epi32(_mm_add_epi32(a, HSH_MD5_V4_##fn(b, c, d)), \
+                                _mm_add_epi32(X[x], _mm_set1_epi32((int)hsh_md5_K[t]))); \
+    a = _mm_add_epi32(b, _mm_or_si128(_mm_slli_epi32(sum, s), _mm_srli_epi32(sum, 32 - (s)))); \
+} while (0)
+
+__attribute__((target("sse2")))
+void hsh_md5_x4_sse2(uint32_t state[4][HSH_MD5_MAX_LANES], const unsigned char *const blocks[4]) {
+    const __m128i ONES = _mm_set1_epi32(-1);
+    __m128i X[16];
+    __m128i A, B, C, D;
+    int k;
+
+    /* Transpose so X[j] holds little-endian word j of every lane */
+    for (k = 0; k < 4; k++) {
+        __m128i r0 = _mm_loadu_si128((const __m128i *)(blocks[0] + 16 * k));
+        __m128i r1 = _mm_loadu_si128((const __m128i *)(blocks[1] + 16 * k));
+        __m128i r2 = _mm_loadu_si128((const __m128i *)(blocks[2] + 16 * k));
+        __m128i r3 = _mm_loadu_si128((const __m128i *)(blocks[3] + 16 * k));
+        __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+        __m128i t1 = _mm_unpackhi_epi32(r0, r1);
+        __m128i t2 = _mm_unpacklo_epi32(r2, r3);
+        __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+        X[4*k + 0] = _mm_unpacklo_epi64(t0, t2);
+        X[4*k + 1] = _mm_unpackhi_epi64(t0, t2);
+        X[4*k + 2] = _mm_unpacklo_epi64(t1, t3);
+        X[4*k + 3] = _mm_unpackhi_epi64(t1, t3);
+    }
+
+    A = _mm_loadu_si128((const __m128i *)state[0]);
+    B = _mm_loadu_si128((const __m128i *)state[1]);
+    C = _mm_loadu_si128((const __m128i *)state[2]);
+    D = _mm_loadu_si128((const __m128i *)state[3]);
+
+    HSH_MD5_ROUNDS(HSH_MD5_V4_STEP);
+
+    _mm_storeu_si128((__m128i *)state[0], _mm_add_epi32(A, _mm_loadu_si128((const __m128i *)state[0])));
+    _mm_storeu_si128((__m128i *)state[1], _mm_add_epi32(B, _mm_loadu_si128((const __m128i *)state[1])));
+    _mm_storeu_si128((__m128i *)state[2], _mm_add_epi32(C, _mm_loadu_si128((const __m128i *)state[2])));
+    _mm_storeu_si128((__m128i *)state[3], _mm_add_epi32(D, _mm_loadu_si128((const __m128i *)state[3])));
+}
+
+/* ===== AVX2: 8 lanes ===== */
+
+#define HSH_MD5_V8_F(b,c,d) _mm256_xor_si256((d), _mm256_and_si256((b), _mm256_xor_si256((c), (d))))
+#define HSH_MD5_V8_G(b,c,d) _mm256_xor_si256((c), _mm256_and_si256((d), _mm256_xor_si256((b), (c))))
+#define HSH_MD5_V8_H(b,c,d) _mm256_xor_si256(_mm256_xor_si256((b), (c)), (d))
+#define HSH_MD5_V8_I(b,c,d) _mm256_xor_si256((c), _mm256_or_si256((b), _mm256_xor_si256((d), ONES)))
+
+#define HSH_MD5_V8_STEP(fn, a, b, c, d, x, t, s) do { \
+    __m256i sum = _mm256_add_epi32(_mm256_add_epi32(a, HSH_MD5_V8_##fn(b, c, d)), \
+                                   _mm256_add_epi32(X[x], _mm256_set1_epi32((int)hsh_md5_K[t]))); \
+    a = _mm256_add_epi32(b, _mm256_or_si256(_mm256_slli_epi32(sum, s), _mm256_srli_epi32(sum, 32 - (s)))); \
+} while (0)
+
+__attribute__((target("avx2")))
+void hsh_md5_x8_avx2(uint32_t state[4][HSH_MD5_MAX_LANES], const unsigned char *const blocks[8]) {
+    const __m256i ONES = _mm256_set1_epi32(-1);
+    __m256i X[16];
+    __m256i A, B, C, D;
+    int k;
+
+    /* 8x8 transposes of the first and second 32 bytes of every lane */
+    for (k = 0; k < 2; k++) {
+        __m256i r[8], t[8], u[8];
+        int i;
+        for (i = 0; i < 8; i++)
+            r[i] = _mm256_loadu_si256((const __m256i *)(blocks[i] + 32 * k));
+        for (i = 0; i < 8; i += 2) {
+            t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+            t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+        }
+        for (i = 0; i < 8; i += 4) {
+            u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+            u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+            u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+            u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+        }
+        for (i = 0; i < 4; i++) {
+            X[8*k + i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+            X[8*k + i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+        }
+    }
+
+    A = _mm256_loadu_si256((const __m256i *)state[0]);
+    B = _mm256_loadu_si256((const __m256i *)state[1]);
+    C = _mm256_loadu_si256((const __m256i *)state[2]);
+    D = _mm256_loadu_si256((const __m256i *)state[3]);
+
+    HSH_MD5_ROUNDS(HSH_MD5_V8_STEP);
+
+    _mm256_storeu_si256((__m256i *)state[0], _mm256_add_epi32(A, _mm256_loadu_si256((const __m256i *)state[0])));
+    _mm256_storeu_si256((__m256i *)state[1], _mm256_add_epi32(B, _mm256_loadu_si256((const __m256i *)state[1])));
+    _mm256_storeu_si256((__m256i *)state[2], _mm256_add_epi32(C, _mm256_loadu_si256((const __m256i *)state[2])));
+    _mm256_storeu_si256((__m256i *)state[3], _mm256_add_epi32(D, _mm256_loadu_si256((const __m256i *)state[3])));
+}
+
+#endif /* HSH_X86 */
@@ -0,0 +1,340 @@
+#include "merkle.h"
+#include "sha2.h"
+#include "pool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Nodes hashed per pool task in a batch update */
+#define HSH_MERKLE_GROUP 64
+/* Levels with fewer dirty nodes than this are hashed on the calling thread */
+#define HSH_MERKLE_PARALLEL_MIN 256
+/* Interior nodes per hsh_sha2_256_batch call */
+#define HSH_MERKLE_LANES 8
+
+static const uint8_t hsh_merkle_magic[8] = { 'h', 's', 'h', 'm', 'r', 'k', 'l', 1 };
+
+/* ==== Hashing ==== */
+
+void hsh_merkle_leaf_hash(const uint8_t *data, size_t len, uint8_t digest[HSH_MERKLE_DIGEST_SIZE]) {
+    static const uint8_t prefix = 0x00;
+    hsh_sha2_256_ctx ctx;
+
+    hsh_sha2_256_init(&ctx);
+    hsh_sha2_256_update(&ctx, &prefix, 1);
+    hsh_sha2_256_update(&ctx, data, len);
+    hsh_sha2_256_finalize(&ctx, digest);
+}
+
+/* children is the left digest followed by the right one, which is how
+ * siblings lie in the node array */
+static void hsh_merkle_node_hash(const uint8_t children[2 * HSH_MERKLE_DIGEST_SIZE],
+                                 uint8_t out[HSH_MERKLE_DIGEST_SIZE]) {
+    uint8_t msg[1 + 2 * HSH_MERKLE_DIGEST_SIZE];
+
+    msg[0] = 0x01;
+    memcpy(msg + 1, children, 2 * HSH_MERKLE_DIGEST_SIZE);
+    hsh_sha2_256(msg, sizeof(msg), out);
+}
+
+/* Recompute nodes[ids[0..count)] from their children, several messages per
+ * hsh_sha2_256_batch call so multi-buffer SIMD can be used */
+static void hsh_merkle_rehash(hsh_merkle_tree *tree, const uint64_t *ids, size_t count) {
+    uint8_t msgs[HSH_MERKLE_LANES][1 + 2 * HSH_MERKLE_DIGEST_SIZE];
+    uint8_t digests[HSH_MERKLE_LANES * HSH_MERKLE_DIGEST_SIZE];
+    const unsigned char *ptrs[HSH_MERKLE_LANES];
+    size_t lens[HSH_MERKLE_LANES];
+
+    while (count > 0) {
+        size_t n = count < HSH_MERKLE_LANES ? count : HSH_MERKLE_LANES;
+
+        for (size_t i = 0; i < n; i++) {
+            msgs[i][0] = 0x01;
+            memcpy(msgs[i] + 1, tree->nodes[2 * ids[i]], 2 * HSH_MERKLE_DIGEST_SIZE);
+            ptrs[i] = msgs[i];
+            lens[i] = sizeof(msgs[i]);
+        }
+        hsh_sha2_256_batch(ptrs, lens, n, digests);
+        for (size_t i = 0; i < n; i++)
+            memcpy(tree->nodes[ids[i]], digests + i * HSH_MERKLE_DIGEST_SIZE, HSH_MERKLE_DIGEST_SIZE);
+        ids += n;
+        count -= n;
+    }
+}
+
+/* ==== Node store ==== */
+
+static void hsh_merkle_put64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t hsh_merkle_get64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+/* Capacity, depth and mapping size for a leaf count; -1 if out of range */
+static int hsh_merkle_shape(hsh_merkle_tree *tree, uint64_t leaves) {
+    if (leaves == 0 || leaves > ((uint64_t)1 << HSH_MERKLE_MAX_DEPTH)) return -1;
+
+    tree->leaves = leaves;
+    tree->capacity = 1;
+    tree->depth = 0;
+    while (tree->capacity < leaves) {
+        tree->capacity <<= 1;
+        tree->depth++;
+    }
+    tree->map_len = (size_t)(2 * tree->capacity * HSH_MERKLE_DIGEST_SIZE);
+    return 0;
+}
+
+/* Header plus the nodes of a tree whose leaves are all unset: every level
+ * holds copies of one digest */
+static void hsh_merkle_fill_empty(hsh_merkle_tree *tree) {
+    uint8_t level[2 * HSH_MERKLE_DIGEST_SIZE];
+    uint64_t first = tree->capacity;
+
+    memset(tree->nodes[0], 0, HSH_MERKLE_DIGEST_SIZE);
+    memcpy(tree->nodes[0], hsh_merkle_magic, sizeof(hsh_merkle_magic));
+    hsh_merkle_put64(tree->nodes[0] + 8, tree->leaves);
+
+    memset(level, 0, sizeof(level));
+    memset(tree->nodes[first], 0, (size_t)first * HSH_MERKLE_DIGEST_SIZE);
+    while (first > 1) {
+        hsh_merkle_node_hash(level, level);
+        memcpy(level + HSH_MERKLE_DIGEST_SIZE, level, HSH_MERKLE_DIGEST_SIZE);
+        first >>= 1;
+        for (uint64_t i = first; i < 2 * first; i++)
+            memcpy(tree->nodes[i], level, HSH_MERKLE_DIGEST_SIZE);
+    }
+}
+
+int hsh_merkle_init(hsh_merkle_tree *tree, uint64_t leaves) {
+    void *map;
+
+    if (hsh_merkle_shape(tree, leaves) != 0) return -1;
+    map = mmap(NULL, tree->map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) return -1;
+
+    tree->nodes = map;
+    tree->fd = -1;
+    hsh_merkle_fill_empty(tree);
+    return 0;
+}
+
+int hsh_merkle_open(hsh_merkle_tree *tree, const char *path, uint64_t leaves) {
+    uint8_t header[HSH_MERKLE_DIGEST_SIZE];
+    struct stat st;
+    int fd, fresh, saved;
+    void *map;
+
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) != 0) goto fail;
+
+    fresh = st.st_size == 0;
+    if (!fresh) {
+        if (pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            memcmp(header, hsh_merkle_magic, sizeof(hsh_merkle_magic)) != 0)
+            goto invalid;
+        if (leaves == 0) leaves = hsh_merkle_get64(header + 8);
+        if (hsh_merkle_get64(header + 8) != leaves) goto invalid;
+    }
+    if (hsh_merkle_shape(tree, leaves) != 0) goto invalid;
+    if (!fresh && (uint64_t)st.st_size != tree->map_len) goto invalid;
+    if (fresh && ftruncate(fd, (off_t)tree->map_len) != 0) goto fail;
+
+    map = mmap(NULL, tree->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) goto fail;
+
+    tree->nodes = map;
+    tree->fd = fd;
+    if (fresh) hsh_merkle_fill_empty(tree);
+    return 0;
+
+invalid:
+    errno = EINVAL;
+fail:
+    saved = errno;
+    close(fd);
+    errno = saved;
+    return -1;
+}
+
+int hsh_merkle_sync(hsh_merkle_tree *tree) {
+    if (tree->fd < 0) return 0;
+    return msync(tree->nodes, tree->map_len, MS_SYNC);
+}
+
+void hsh_merkle_close(hsh_merkle_tree *tree) {
+    munmap(tree->nodes, tree->map_len);
+    if (tree->fd >= 0) close(tree->fd);
+    tree->nodes = NULL;
+    tree->fd = -1;
+}
+
+/* ==== Updates ==== */
+
+int hsh_merkle_update(hsh_merkle_tree *tree, uint64_t index, const uint8_t *data, size_t len) {
+    uint64_t node;
+
+    if (index >= tree->leaves) return -1;
+
+    node = tree->capacity + index;
+    hsh_merkle_leaf_hash(data, len, tree->nodes[node]);
+    for (node >>= 1; node >= 1; node >>= 1)
+        hsh_merkle_node_hash(tree->nodes[2 * node], tree->nodes[node]);
+    return 0;
+}
+
+/* Dirty node with the batch entry that set it (leaf level only) */
+typedef struct {
+    uint64_t node;
+    size_t entry;
+} hsh_merkle_dirty;
+
+static int hsh_merkle_cmp_dirty(const void *a, const void *b) {
+    const hsh_merkle_dirty *x = a, *y = b;
+    if (x->node != y->node) return x->node < y->node ? -1 : 1;
+    return (x->entry > y->entry) - (x->entry < y->entry);
+}
+
+typedef struct {
+    hsh_merkle_tree *tree;
+    const hsh_merkle_leaf *leaves;
+    const hsh_merkle_dirty *dirty;
+    const uint64_t *ids;
+    size_t count;
+} hsh_merkle_job;
+
+static void hsh_merkle_leaf_task(void *arg, size_t group) {
+    const hsh_merkle_job *job = arg;
+    size_t end = (group + 1) * HSH_MERKLE_GROUP;
+
+    if (end > job->count) end = job->count;
+    for (size_t i = group * HSH_MERKLE_GROUP; i < end; i++) {
+        const hsh_merkle_leaf *leaf = &job->leaves[job->dirty[i].entry];
+        hsh_merkle_leaf_hash(leaf->data, leaf->len, job->tree->nodes[job->dirty[i].node]);
+    }
+}
+
+static void hsh_merkle_node_task(void *arg, size_t group) {
+    const hsh_merkle_job *job = arg;
+    size_t first = group * HSH_MERKLE_GROUP;
+    size_t n = job->count - first < HSH_MERKLE_GROUP ? job->count - first : HSH_MERKLE_GROUP;
+
+    hsh_merkle_rehash(job->tree, job->ids + first, n);
+}
+
+/* Runs fn over the job's groups, on the pool if there are enough nodes */
+static void hsh_merkle_run(hsh_pool_fn fn, hsh_merkle_job *job) {
+    size_t groups = (job->count + HSH_MERKLE_GROUP - 1) / HSH_MERKLE_GROUP;
+
+    if (job->count >= HSH_MERKLE_PARALLEL_MIN) {
+        hsh_pool_run(fn, job, groups);
+        return;
+    }
+    for (size_t g = 0; g < groups; g++)
+        fn(job, g);
+}
+
+int hsh_merkle_update_batch(hsh_merkle_tree *tree, const hsh_merkle_leaf *leaves, size_t count) {
+    hsh_merkle_job job = { tree, leaves, NULL, NULL, 0 };
+    hsh_merkle_dirty *dirty;
+    uint64_t *ids;
+    size_t n = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (leaves[i].index >= tree->leaves) return -1;
+    }
+    if (count == 0) return 0;
+
+    dirty = malloc(count * sizeof(*dirty));
+    ids = malloc(count * sizeof(*ids));
+    if (!dirty || !ids) {
+        free(dirty);
+        free(ids);
+        return -1;
+    }
+
+    /* Sort by node, keep the last entry for each */
+    for (size_t i = 0; i < count; i++) {
+        dirty[i].node = tree->capacity + leaves[i].index;
+        dirty[i].entry = i;
+    }
+    qsort(dirty, count, sizeof(*dirty), hsh_merkle_cmp_dirty);
+    for (size_t i = 0; i < count; i++) {
+        if (i + 1 < count && dirty[i + 1].node == dirty[i].node) continue;
+        dirty[n++] = dirty[i];
+    }
+
+    job.dirty = dirty;
+    job.count = n;
+    hsh_merkle_run(hsh_merkle_leaf_task, &job);
+
+    /* Parents of the sorted, distinct dirty nodes are sorted as well, so
+     * shared ancestors are adjacent and dropped with one comparison */
+    for (size_t i = 0; i < n; i++)
+        ids[i] = dirty[i].node;
+    while (ids[0] > 1) {
+        size_t m = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t parent = ids[i] >> 1;
+            if (m == 0 || ids[m - 1] != parent) ids[m++] = parent;
+        }
+        n = m;
+
+        job.ids = ids;
+        job.count = n;
+        hsh_merkle_run(hsh_merkle_node_task, &job);
+    }
+
+    free(ids);
+    free(dirty);
+    return 0;
+}
+
+/* ==== Roots and proofs ==== */
+
+void hsh_merkle_root(const hsh_merkle_tree *tree, uint8_t root[HSH_MERKLE_DIGEST_SIZE]) {
+    memcpy(root, tree->nodes[1], HSH_MERKLE_DIGEST_SIZE);
+}
+
+int hsh_merkle_proof(const hsh_merkle_tree *tree, uint64_t index,
+                     uint8_t proof[][HSH_MERKLE_DIGEST_SIZE]) {
+    size_t k = 0;
+
+    if (index >= tree->leaves) return -1;
+    for (uint64_t node = tree->capacity + index; node > 1; node >>= 1)
+        memcpy(proof[k++], tree->nodes[node ^ 1], HSH_MERKLE_DIGEST_SIZE);
+    return 0;
+}
+
+int hsh_merkle_verify(const uint8_t root[HSH_MERKLE_DIGEST_SIZE], uint64_t index,
+                      const uint8_t leaf_digest[HSH_MERKLE_DIGEST_SIZE],
+                      const uint8_t proof[][HSH_MERKLE_DIGEST_SIZE], size_t depth) {
+    uint8_t pair[2 * HSH_MERKLE_DIGEST_SIZE];
+    uint8_t h[HSH_MERKLE_DIGEST_SIZE];
+
+    if (depth > HSH_MERKLE_MAX_DEPTH || (depth < 64 && index >> depth != 0)) return 0;
+
+    memcpy(h, leaf_digest, HSH_MERKLE_DIGEST_SIZE);
+    for (size_t k = 0; k < depth; k++, index >>= 1) {
+        if (index & 1) {
+            memcpy(pair, proof[k], HSH_MERKLE_DIGEST_SIZE);
+            memcpy(pair + HSH_MERKLE_DIGEST_SIZE, h, HSH_MERKLE_DIGEST_SIZE);
+        } else {
+            memcpy(pair, h, HSH_MERKLE_DIGEST_SIZE);
+            memcpy(pair + HSH_MERKLE_DIGEST_SIZE, proof[k], HSH_MERKLE_DIGEST_SIZE);
+        }
+        hsh_merkle_node_hash(pair, h);
+    }
+    return memcmp(h, root, HSH_MERKLE_DIGEST_SIZE) == 0;
+}
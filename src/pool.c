@@ -0,0 +1,115 @@
+#include "pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define HSH_POOL_MAX_THREADS 64
+
+/*
+ * One job at a time: the owner publishes fn/arg/count and a number of helper
+ * slots, workers claim a slot each and then pull task indices from a shared
+ * atomic counter until none are left. Workers are created on first use and
+ * live for the rest of the process.
+ */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        /* slots became available */
+    pthread_cond_t idle;        /* running dropped to zero */
+    pthread_mutex_t busy;       /* held by the owner of the current job */
+    size_t workers;
+    hsh_pool_fn fn;
+    void *arg;
+    size_t count;
+    size_t next;                /* next unclaimed task index */
+    size_t slots;               /* helper slots not yet claimed */
+    size_t running;             /* helpers that have not finished */
+} hsh_pool = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    0, NULL, NULL, 0, 0, 0, 0
+};
+
+static pthread_once_t hsh_pool_once = PTHREAD_ONCE_INIT;
+
+static void hsh_pool_drain(void) {
+    size_t i;
+    while ((i = __atomic_fetch_add(&hsh_pool.next, 1, __ATOMIC_RELAXED)) < hsh_pool.count)
+        hsh_pool.fn(hsh_pool.arg, i);
+}
+
+static void *hsh_pool_worker(void *unused) {
+    (void)unused;
+    pthread_mutex_lock(&hsh_pool.lock);
+    for (;;) {
+        while (hsh_pool.slots == 0)
+            pthread_cond_wait(&hsh_pool.wake, &hsh_pool.lock);
+        hsh_pool.slots--;
+        pthread_mutex_unlock(&hsh_pool.lock);
+
+        hsh_pool_drain();
+
+        pthread_mutex_lock(&hsh_pool.lock);
+        if (--hsh_pool.running == 0)
+            pthread_cond_signal(&hsh_pool.idle);
+    }
+    return NULL;
+}
+
+static void hsh_pool_start(void) {
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *env = getenv("HSH_THREADS");
+    pthread_attr_t attr;
+    pthread_t tid;
+
+    if (env && *env) threads = strtol(env, NULL, 10);
+    if (threads < 1) threads = 1;
+    if (threads > HSH_POOL_MAX_THREADS) threads = HSH_POOL_MAX_THREADS;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    while (hsh_pool.workers + 1 < (size_t)threads &&
+           pthread_create(&tid, &attr, hsh_pool_worker, NULL) == 0)
+        hsh_pool.workers++;
+    pthread_attr_destroy(&attr);
+}
+
+size_t hsh_pool_threads(void) {
+    pthread_once(&hsh_pool_once, hsh_pool_start);
+    return hsh_pool.workers + 1;
+}
+
+void hsh_pool_run(hsh_pool_fn fn, void *arg, size_t count) {
+    size_t helpers, i;
+
+    pthread_once(&hsh_pool_once, hsh_pool_start);
+    helpers = count > 1 ? count - 1 : 0;
+    if (helpers > hsh_pool.workers) helpers = hsh_pool.workers;
+
+    if (helpers == 0 || pthread_mutex_trylock(&hsh_pool.busy) != 0) {
+        for (i = 0; i < count; i++)
+            fn(arg, i);
+        return;
+    }
+
+    pthread_mutex_lock(&hsh_pool.lock);
+    hsh_pool.fn = fn;
+    hsh_pool.arg = arg;
+    hsh_pool.count = count;
+    hsh_pool.next = 0;
+    hsh_pool.slots = helpers;
+    hsh_pool.running = helpers;
+    pthread_cond_broadcast(&hsh_pool.wake);
+    pthread_mutex_unlock(&hsh_pool.lock);
+
+    hsh_pool_drain();
+
+    /* Every task is claimed; slots nobody picked up no longer need a thread */
+    pthread_mutex_lock(&hsh_pool.lock);
+    hsh_pool.running -= hsh_pool.slots;
+    hsh_pool.slots = 0;
+    while (hsh_pool.running > 0)
+        pthread_cond_wait(&hsh_pool.idle, &hsh_pool.lock);
+    pthread_mutex_unlock(&hsh_pool.lock);
+
+    pthread_mutex_unlock(&hsh_pool.busy);
+}
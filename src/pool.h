@@ -0,0 +1,20 @@
+#ifndef HSH_POOL_H
+#define HSH_POOL_H
+
+/* Internal: process-wide worker pool for data-parallel hashing. */
+
+#include <stddef.h>
+
+typedef void (*hsh_pool_fn)(void *arg, size_t index);
+
+/* Threads hsh_pool_run can use, counting the caller (at least 1). Defaults
+ * to the number of online CPUs; HSH_THREADS in the environment overrides it. */
+size_t hsh_pool_threads(void);
+
+/* Run fn(arg, i) for every i in [0, count) and return once all have finished.
+ * The calling thread takes tasks too. If the pool is already busy (another
+ * thread's job, or a nested call from inside a task) the tasks simply run on
+ * the calling thread, so callers never have to care. */
+void hsh_pool_run(hsh_pool_fn fn, void *arg, size_t count);
+
+#endif /* HSH_POOL_H */
@@ -1,4 +1,5 @@
 #include "sha1.h"
+#include "sha1_internal.h"
 #include <string.h>
 
 static const uint32_t HSH_SHA1_INITIAL_STATE[5] = {
@@ -9,10 +10,6 @@ static const uint32_t HSH_SHA1_INITIAL_STATE[5] = {
     0xC3D2E1F0
 };
 
-static const uint32_t HSH_SHA1_K[4] = {
-    0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6
-};
-
 static inline uint32_t hsh_sha1_rotl(uint32_t x, uint32_t n) {
     return (x << n) | (x >> (32 - n));
 }
@@ -23,57 +20,76 @@ void hsh_sha1_init(hsh_sha1_ctx *ctx) {
     ctx->message_byte_length = 0;
 }
 
-static void hsh_sha1_process_chunk(hsh_sha1_ctx *ctx, const uint8_t *chunk) {
-    uint32_t w[80];
-    uint32_t a, b, c, d, e, f, k, temp;
-
-    /* Convert 64-byte chunk to 16 big-endian 32-bit words */
-    for (int i = 0; i < 16; i++) {
-        w[i]  = (uint32_t)chunk[i*4] << 24;
-        w[i] |= (uint32_t)chunk[i*4 + 1] << 16;
-        w[i] |= (uint32_t)chunk[i*4 + 2] << 8;
-        w[i] |= (uint32_t)chunk[i*4 + 3];
-    }
-
-    /* Extend the 16 words into 80 */
-    for (int i = 16; i < 80; i++) {
-        w[i] = hsh_sha1_rotl(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
-    }
-
-    a = ctx->h[0];
-    b = ctx->h[1];
-    c = ctx->h[2];
-    d = ctx->h[3];
-    e = ctx->h[4];
-
-    for (int i = 0; i < 80; i++) {
-        if (i < 20) {
-            f = (b & c) | ((~b) & d);
-            k = HSH_SHA1_K[0];
-        } else if (i < 40) {
-            f = b ^ c ^ d;
-            k = HSH_SHA1_K[1];
-        } else if (i < 60) {
-            f = (b & c) | (b & d) | (c & d);
-            k = HSH_SHA1_K[2];
-        } else {
-            f = b ^ c ^ d;
-            k = HSH_SHA1_K[3];
+/* Round functions: choose, parity and majority */
+#define HSH_SHA1_CH(b, c, d)  ((d) ^ ((b) & ((c) ^ (d))))
+#define HSH_SHA1_PAR(b, c, d) ((b) ^ (c) ^ (d))
+#define HSH_SHA1_MAJ(b, c, d) (((b) & (c)) | ((d) & ((b) | (c))))
+
+/* Message schedule in a rolling 16-word window: w[i & 15] is replaced by
+ * word i once word i - 16 has been used */
+#define HSH_SHA1_W(i) (w[(i) & 15] = hsh_sha1_rotl(w[((i) + 13) & 15] ^ w[((i) + 8) & 15] ^ \
+                                                    w[((i) + 2) & 15] ^ w[(i) & 15], 1))
+
+/* One round, with the variables renamed instead of shifted */
+#define HSH_SHA1_ROUND(a, b, c, d, e, fn, k, wi) do { \
+    e += hsh_sha1_rotl(a, 5) + fn(b, c, d) + (k) + (wi); \
+    b = hsh_sha1_rotl(b, 30); \
+} while (0)
+
+#define HSH_SHA1_R0(a, b, c, d, e, i) HSH_SHA1_ROUND(a, b, c, d, e, HSH_SHA1_CH, 0x5A827999, w[i])
+#define HSH_SHA1_R1(a, b, c, d, e, i) HSH_SHA1_ROUND(a, b, c, d, e, HSH_SHA1_CH, 0x5A827999, HSH_SHA1_W(i))
+#define HSH_SHA1_R2(a, b, c, d, e, i) HSH_SHA1_ROUND(a, b, c, d, e, HSH_SHA1_PAR, 0x6ED9EBA1, HSH_SHA1_W(i))
+#define HSH_SHA1_R3(a, b, c, d, e, i) HSH_SHA1_ROUND(a, b, c, d, e, HSH_SHA1_MAJ, 0x8F1BBCDC, HSH_SHA1_W(i))
+#define HSH_SHA1_R4(a, b, c, d, e, i) HSH_SHA1_ROUND(a, b, c, d, e, HSH_SHA1_PAR, 0xCA62C1D6, HSH_SHA1_W(i))
+
+/* Five rounds bring the variables back to their starting names */
+#define HSH_SHA1_5(R, i) \
+    R(a, b, c, d, e, (i));     R(e, a, b, c, d, (i) + 1); R(d, e, a, b, c, (i) + 2); \
+    R(c, d, e, a, b, (i) + 3); R(b, c, d, e, a, (i) + 4)
+
+/* Fully unrolled portable compression of nblocks 64-byte blocks */
+static void hsh_sha1_blocks_generic(uint32_t h[5], const uint8_t *data, size_t nblocks) {
+    for (; nblocks > 0; nblocks--, data += HSH_SHA1_BLOCK_SIZE) {
+        uint32_t w[16];
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+
+        /* 16 big-endian 32-bit words */
+        for (int i = 0; i < 16; i++) {
+            w[i]  = (uint32_t)data[i*4] << 24;
+            w[i] |= (uint32_t)data[i*4 + 1] << 16;
+            w[i] |= (uint32_t)data[i*4 + 2] << 8;
+            w[i] |= (uint32_t)data[i*4 + 3];
         }
 
-        temp = hsh_sha1_rotl(a, 5) + f + e + k + w[i];
-        e = d;
-        d = c;
-        c = hsh_sha1_rotl(b, 30);
-        b = a;
-        a = temp;
+        HSH_SHA1_5(HSH_SHA1_R0, 0);  HSH_SHA1_5(HSH_SHA1_R0, 5);
+        HSH_SHA1_5(HSH_SHA1_R0, 10);
+        HSH_SHA1_R0(a, b, c, d, e, 15);
+        HSH_SHA1_R1(e, a, b, c, d, 16); HSH_SHA1_R1(d, e, a, b, c, 17);
+        HSH_SHA1_R1(c, d, e, a, b, 18); HSH_SHA1_R1(b, c, d, e, a, 19);
+        HSH_SHA1_5(HSH_SHA1_R2, 20); HSH_SHA1_5(HSH_SHA1_R2, 25);
+        HSH_SHA1_5(HSH_SHA1_R2, 30); HSH_SHA1_5(HSH_SHA1_R2, 35);
+        HSH_SHA1_5(HSH_SHA1_R3, 40); HSH_SHA1_5(HSH_SHA1_R3, 45);
+        HSH_SHA1_5(HSH_SHA1_R3, 50); HSH_SHA1_5(HSH_SHA1_R3, 55);
+        HSH_SHA1_5(HSH_SHA1_R4, 60); HSH_SHA1_5(HSH_SHA1_R4, 65);
+        HSH_SHA1_5(HSH_SHA1_R4, 70); HSH_SHA1_5(HSH_SHA1_R4, 75);
+
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
     }
+}
 
-    ctx->h[0] = (ctx->h[0] + a) & 0xFFFFFFFF;
-    ctx->h[1] = (ctx->h[1] + b) & 0xFFFFFFFF;
-    ctx->h[2] = (ctx->h[2] + c) & 0xFFFFFFFF;
-    ctx->h[3] = (ctx->h[3] + d) & 0xFFFFFFFF;
-    ctx->h[4] = (ctx->h[4] + e) & 0xFFFFFFFF;
+/* Compress nblocks 64-byte blocks with the fastest backend this CPU supports */
+static void hsh_sha1_blocks(uint32_t h[5], const uint8_t *data, size_t nblocks) {
+#if HSH_X86
+    if ((hsh_cpu_features() & HSH_CPU_SHANI) == HSH_CPU_SHANI) {
+        hsh_sha1_blocks_shani(h, data, nblocks);
+        return;
+    }
+#endif
+    hsh_sha1_blocks_generic(h, data, nblocks);
 }
 
 void hsh_sha1_update(hsh_sha1_ctx *ctx, const uint8_t *data, size_t len) {
@@ -92,14 +108,14 @@ void hsh_sha1_update(hsh_sha1_ctx *ctx, const uint8_t *data, size_t len) {
     if (ctx->unprocessed_len > 0) {
         size_t fill = HSH_SHA1_BLOCK_SIZE - ctx->unprocessed_len;
         memcpy(ctx->unprocessed + ctx->unprocessed_len, data, fill);
-        hsh_sha1_process_chunk(ctx, ctx->unprocessed);
+        hsh_sha1_blocks(ctx->h, ctx->unprocessed, 1);
         offset += fill;
         ctx->unprocessed_len = 0;
     }
 
-    for (; offset + HSH_SHA1_BLOCK_SIZE <= len; offset += HSH_SHA1_BLOCK_SIZE) {
-        hsh_sha1_process_chunk(ctx, data + offset);
-    }
+    size_t nblocks = (len - offset) / HSH_SHA1_BLOCK_SIZE;
+    hsh_sha1_blocks(ctx->h, data + offset, nblocks);
+    offset += nblocks * HSH_SHA1_BLOCK_SIZE;
 
     if (offset < len) {
         ctx->unprocessed_len = len - offset;
@@ -107,25 +123,51 @@ void hsh_sha1_update(hsh_sha1_ctx *ctx, const uint8_t *data, size_t len) {
     }
 }
 
-void hsh_sha1_finalize(hsh_sha1_ctx *ctx, uint8_t digest[HSH_SHA1_DIGEST_SIZE]) {
-    uint64_t bit_len = ctx->message_byte_length * 8;
-    uint8_t pad[HSH_SHA1_BLOCK_SIZE] = {0x80};
-    size_t pad_len = (ctx->unprocessed_len < 56)
-        ? (56 - ctx->unprocessed_len)
-        : (120 - ctx->unprocessed_len);
-
-    hsh_sha1_update(ctx, pad, pad_len);
+/* Build the padded final block(s) from the < 64 trailing message bytes;
+ * returns the block count (1 or 2) */
+static size_t hsh_sha1_pad(uint8_t out[128], const uint8_t *tail, size_t tail_len,
+                           uint64_t bit_len) {
+    size_t total = (tail_len < 56) ? 64 : 128;
 
-    uint8_t length_bytes[8];
+    memcpy(out, tail, tail_len);
+    out[tail_len] = 0x80;
+    memset(out + tail_len + 1, 0, total - tail_len - 1 - 8);
     for (int i = 0; i < 8; i++) {
-        length_bytes[7 - i] = (uint8_t)((bit_len >> (i * 8)) & 0xFF);
+        out[total - 1 - i] = (uint8_t)((bit_len >> (i * 8)) & 0xFF);
     }
-    hsh_sha1_update(ctx, length_bytes, 8);
+    return total / HSH_SHA1_BLOCK_SIZE;
+}
 
+static void hsh_sha1_store(const uint32_t h[5], uint8_t digest[HSH_SHA1_DIGEST_SIZE]) {
     for (int i = 0; i < 5; i++) {
-        digest[i * 4]     = (ctx->h[i] >> 24) & 0xFF;
-        digest[i * 4 + 1] = (ctx->h[i] >> 16) & 0xFF;
-        digest[i * 4 + 2] = (ctx->h[i] >> 8) & 0xFF;
-        digest[i * 4 + 3] = (ctx->h[i]) & 0xFF;
+        digest[i * 4]     = (h[i] >> 24) & 0xFF;
+        digest[i * 4 + 1] = (h[i] >> 16) & 0xFF;
+        digest[i * 4 + 2] = (h[i] >> 8) & 0xFF;
+        digest[i * 4 + 3] = (h[i]) & 0xFF;
     }
 }
+
+void hsh_sha1_finalize(hsh_sha1_ctx *ctx, uint8_t digest[HSH_SHA1_DIGEST_SIZE]) {
+    uint8_t last[2 * HSH_SHA1_BLOCK_SIZE];
+    size_t nblocks = hsh_sha1_pad(last, ctx->unprocessed, ctx->unprocessed_len,
+                                  ctx->message_byte_length * 8);
+
+    hsh_sha1_blocks(ctx->h, last, nblocks);
+    ctx->unprocessed_len = 0;
+    hsh_sha1_store(ctx->h, digest);
+}
+
+/* One-shot: whole blocks straight from data, padded tail on the stack */
+void hsh_sha1(const uint8_t *data, size_t len, uint8_t digest[HSH_SHA1_DIGEST_SIZE]) {
+    uint32_t h[5];
+    uint8_t last[2 * HSH_SHA1_BLOCK_SIZE];
+    size_t full = len / HSH_SHA1_BLOCK_SIZE;
+
+    memcpy(h, HSH_SHA1_INITIAL_STATE, sizeof(h));
+    if (full > 0)
+        hsh_sha1_blocks(h, data, full);
+    size_t nblocks = hsh_sha1_pad(last, data + full * HSH_SHA1_BLOCK_SIZE,
+                                  len - full * HSH_SHA1_BLOCK_SIZE, (uint64_t)len * 8);
+    hsh_sha1_blocks(h, last, nblocks);
+    hsh_sha1_store(h, digest);
+}
@@ -0,0 +1,15 @@
+#ifndef HSH_SHA1_INTERNAL_H
+#define HSH_SHA1_INTERNAL_H
+
+/* Internal: SHA-1 compression backends. */
+
+#include "cpu.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#if HSH_X86
+/* SHA-NI compression of nblocks consecutive 64-byte blocks */
+void hsh_sha1_blocks_shani(uint32_t h[5], const uint8_t *data, size_t nblocks);
+#endif
+
+#endif /* HSH_SHA1_INTERNAL_H */
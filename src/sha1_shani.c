@@ -0,0 +1,103 @@
+#include "sha1_internal.h"
+
+#if HSH_X86
+#include <immintrin.h>
+
+/* Four rounds on message words M0 while scheduling M1..M3 (the next three
+ * quads); EC accumulates E for this quad and EO saves ABCD for the next. */
+#define HSH_SHA1_QUAD(EC, EO, M0, M1, M2, M3, F) do { \
+    EC = _mm_sha1nexte_epu32(EC, M0); \
+    EO = ABCD; \
+    M1 = _mm_sha1msg2_epu32(M1, M0); \
+    ABCD = _mm_sha1rnds4_epu32(ABCD, EC, F); \
+    M3 = _mm_sha1msg1_epu32(M3, M0); \
+    M2 = _mm_xor_si128(M2, M0); \
+} while (0)
+
+__attribute__((target("sha,sse4.1")))
+void hsh_sha1_blocks_shani(uint32_t h[5], const uint8_t *data, size_t nblocks) {
+    const __m128i BSWAP = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i ABCD, ABCD_SAVE, E0, E0_SAVE, E1;
+    __m128i MSG0, MSG1, MSG2, MSG3;
+
+    ABCD = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)h), 0x1B);
+    E0 = _mm_set_epi32((int)h[4], 0, 0, 0);
+
+    while (nblocks--) {
+        ABCD_SAVE = ABCD;
+        E0_SAVE = E0;
+
+        /* Rounds 0-15: load the block while the schedule warms up */
+        MSG0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), BSWAP);
+        E0 = _mm_add_epi32(E0, MSG0);
+        E1 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+
+        MSG1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), BSWAP);
+        E1 = _mm_sha1nexte_epu32(E1, MSG1);
+        E0 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 0);
+        MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+
+        MSG2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), BSWAP);
+        E0 = _mm_sha1nexte_epu32(E0, MSG2);
+        E1 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+        MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+        MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+        MSG3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), BSWAP);
+        E1 = _mm_sha1nexte_epu32(E1, MSG3);
+        E0 = ABCD;
+        MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 0);
+        MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+        MSG1 = _mm_xor_si128(MSG1, MSG3);
+
+        /* Rounds 16-63 */
+        HSH_SHA1_QUAD(E0, E1, MSG0, MSG1, MSG2, MSG3, 0);
+        HSH_SHA1_QUAD(E1, E0, MSG1, MSG2, MSG3, MSG0, 1);
+        HSH_SHA1_QUAD(E0, E1, MSG2, MSG3, MSG0, MSG1, 1);
+        HSH_SHA1_QUAD(E1, E0, MSG3, MSG0, MSG1, MSG2, 1);
+        HSH_SHA1_QUAD(E0, E1, MSG0, MSG1, MSG2, MSG3, 1);
+        HSH_SHA1_QUAD(E1, E0, MSG1, MSG2, MSG3, MSG0, 1);
+        HSH_SHA1_QUAD(E0, E1, MSG2, MSG3, MSG0, MSG1, 2);
+        HSH_SHA1_QUAD(E1, E0, MSG3, MSG0, MSG1, MSG2, 2);
+        HSH_SHA1_QUAD(E0, E1, MSG0, MSG1, MSG2, MSG3, 2);
+        HSH_SHA1_QUAD(E1, E0, MSG1, MSG2, MSG3, MSG0, 2);
+        HSH_SHA1_QUAD(E0, E1, MSG2, MSG3, MSG0, MSG1, 2);
+        HSH_SHA1_QUAD(E1, E0, MSG3, MSG0, MSG1, MSG2, 3);
+
+        /* Rounds 64-79: the schedule winds down */
+        E0 = _mm_sha1nexte_epu32(E0, MSG0);
+        E1 = ABCD;
+        MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+        MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+        MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+        E1 = _mm_sha1nexte_epu32(E1, MSG1);
+        E0 = ABCD;
+        MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+        MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+        E0 = _mm_sha1nexte_epu32(E0, MSG2);
+        E1 = ABCD;
+        MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+
+        E1 = _mm_sha1nexte_epu32(E1, MSG3);
+        E0 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+
+        E0 = _mm_sha1nexte_epu32(E0, E0_SAVE);
+        ABCD = _mm_add_epi32(ABCD, ABCD_SAVE);
+        data += 64;
+    }
+
+    _mm_storeu_si128((__m128i *)h, _mm_shuffle_epi32(ABCD, 0x1B));
+    h[4] = (uint32_t)_mm_extract_epi32(E0, 3);
+}
+
+#endif /* HSH_X86 */
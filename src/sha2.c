@@ -1,8 +1,9 @@
 #include "sha2.h"
+#include "sha2_internal.h"
 #include <string.h>
 
 /* SHA-256 constants */
-static const uint32_t hsh_sha2_K256[64] = {
+const uint32_t hsh_sha2_K256[64] = {
     0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
     0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
     0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
@@ -14,7 +15,7 @@ static const uint32_t hsh_sha2_K256[64] = {
 };
 
 /* SHA-512 constants */
-static const uint64_t hsh_sha2_K512[80] = {
+const uint64_t hsh_sha2_K512[80] = {
     0x428a2f98d728ae22ULL,0x7137449123ef65cdULL,0xb5c0fbcfec4d3b2fULL,0xe9b5dba58189dbbcULL,
     0x3956c25bf348b538ULL,0x59f111f1b605d019ULL,0x923f82a4af194f9bULL,0xab1c5ed5da6d8118ULL,
     0xd807aa98a3030242ULL,0x12835b0145706fbeULL,0x243185be4ee4b28cULL,0x550c7dc3d5ffb4e2ULL,
@@ -43,108 +44,222 @@ static const uint64_t hsh_sha2_K512[80] = {
 #define hsh_sha2_ch(x,y,z) (((x) & (y)) ^ (~(x) & (z)))
 #define hsh_sha2_maj(x,y,z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
 
-/* SHA-256/224: process 64-byte chunk */
-static void hsh_sha2_256_process_chunk(hsh_sha2_256_ctx *ctx, const unsigned char *chunk) {
+/* SHA-256/224: process 64-byte blocks (portable scalar code); the working
+ * state stays in locals from one block to the next */
+static void hsh_sha2_256_blocks_generic(uint32_t state[8], const unsigned char *chunk, size_t nblocks) {
     uint32_t w[64];
     uint32_t a,b,c,d,e,f,g,h;
+    uint32_t s0 = state[0], s1 = state[1], s2 = state[2], s3 = state[3];
+    uint32_t s4 = state[4], s5 = state[5], s6 = state[6], s7 = state[7];
     size_t i;
 
-    for (i = 0; i < 16; i++) {
-        w[i] = ((uint32_t)chunk[4*i] << 24) | ((uint32_t)chunk[4*i + 1] << 16) |
-               ((uint32_t)chunk[4*i + 2] << 8)  | (uint32_t)chunk[4*i + 3];
-    }
-    for (i = 16; i < 64; i++) {
-        uint32_t s0 = hsh_sha2_ror32(w[i-15], 7) ^ hsh_sha2_ror32(w[i-15], 18) ^ (w[i-15] >> 3);
-        uint32_t s1 = hsh_sha2_ror32(w[i-2], 17) ^ hsh_sha2_ror32(w[i-2], 19) ^ (w[i-2] >> 10);
-        w[i] = w[i-16] + s0 + w[i-7] + s1;
-    }
-    a = ctx->h[0]; b = ctx->h[1]; c = ctx->h[2]; d = ctx->h[3];
-    e = ctx->h[4]; f = ctx->h[5]; g = ctx->h[6]; h = ctx->h[7];
+    for (; nblocks > 0; nblocks--, chunk += 64) {
+        for (i = 0; i < 16; i++) {
+            w[i] = ((uint32_t)chunk[4*i] << 24) | ((uint32_t)chunk[4*i + 1] << 16) |
+                   ((uint32_t)chunk[4*i + 2] << 8)  | (uint32_t)chunk[4*i + 3];
+        }
+        for (i = 16; i < 64; i++) {
+            uint32_t x0 = hsh_sha2_ror32(w[i-15], 7) ^ hsh_sha2_ror32(w[i-15], 18) ^ (w[i-15] >> 3);
+            uint32_t x1 = hsh_sha2_ror32(w[i-2], 17) ^ hsh_sha2_ror32(w[i-2], 19) ^ (w[i-2] >> 10);
+            w[i] = w[i-16] + x0 + w[i-7] + x1;
+        }
+        a = s0; b = s1; c = s2; d = s3;
+        e = s4; f = s5; g = s6; h = s7;
+
+        for (i = 0; i < 64; i++) {
+            uint32_t S1 = hsh_sha2_ror32(e, 6) ^ hsh_sha2_ror32(e, 11) ^ hsh_sha2_ror32(e, 25);
+            uint32_t temp1 = h + S1 + hsh_sha2_ch(e, f, g) + hsh_sha2_K256[i] + w[i];
+            uint32_t S0 = hsh_sha2_ror32(a, 2) ^ hsh_sha2_ror32(a, 13) ^ hsh_sha2_ror32(a, 22);
+            uint32_t temp2 = S0 + hsh_sha2_maj(a, b, c);
 
-    for (i = 0; i < 64; i++) {
-        uint32_t S1 = hsh_sha2_ror32(e, 6) ^ hsh_sha2_ror32(e, 11) ^ hsh_sha2_ror32(e, 25);
-        uint32_t temp1 = h + S1 + hsh_sha2_ch(e, f, g) + hsh_sha2_K256[i] + w[i];
-        uint32_t S0 = hsh_sha2_ror32(a, 2) ^ hsh_sha2_ror32(a, 13) ^ hsh_sha2_ror32(a, 22);
-        uint32_t temp2 = S0 + hsh_sha2_maj(a, b, c);
+            h = g; g = f; f = e; e = d + temp1; d = c; c = b; b = a; a = temp1 + temp2;
+        }
 
-        h = g; g = f; f = e; e = d + temp1; d = c; c = b; b = a; a = temp1 + temp2;
+        s0 += a; s1 += b; s2 += c; s3 += d;
+        s4 += e; s5 += f; s6 += g; s7 += h;
     }
 
-    ctx->h[0] += a; ctx->h[1] += b; ctx->h[2] += c; ctx->h[3] += d;
-    ctx->h[4] += e; ctx->h[5] += f; ctx->h[6] += g; ctx->h[7] += h;
+    state[0] = s0; state[1] = s1; state[2] = s2; state[3] = s3;
+    state[4] = s4; state[5] = s5; state[6] = s6; state[7] = s7;
 }
 
-/* SHA-512/384: process 128-byte chunk */
-static void hsh_sha2_512_process_chunk(hsh_sha2_512_ctx *ctx, const unsigned char *chunk) {
+/* SHA-256/224: compress nblocks 64-byte blocks with the fastest backend this CPU supports */
+void hsh_sha2_256_blocks(uint32_t state[8], const unsigned char *data, size_t nblocks) {
+#if HSH_X86
+    if ((hsh_cpu_features() & HSH_CPU_SHANI) == HSH_CPU_SHANI) {
+        hsh_sha2_256_blocks_shani(state, data, nblocks);
+        return;
+    }
+#endif
+    hsh_sha2_256_blocks_generic(state, data, nblocks);
+}
+
+/* SHA-512/384: process 128-byte blocks (portable scalar code) */
+static void hsh_sha2_512_blocks_generic(uint64_t state[8], const unsigned char *chunk, size_t nblocks) {
     uint64_t w[80];
     uint64_t a,b,c,d,e,f,g,h;
+    uint64_t s0 = state[0], s1 = state[1], s2 = state[2], s3 = state[3];
+    uint64_t s4 = state[4], s5 = state[5], s6 = state[6], s7 = state[7];
     size_t i;
 
-    for (i = 0; i < 16; i++) {
-        w[i] = ((uint64_t)chunk[8*i] << 56) | ((uint64_t)chunk[8*i + 1] << 48) |
-               ((uint64_t)chunk[8*i + 2] << 40) | ((uint64_t)chunk[8*i + 3] << 32) |
-               ((uint64_t)chunk[8*i + 4] << 24) | ((uint64_t)chunk[8*i + 5] << 16) |
-               ((uint64_t)chunk[8*i + 6] << 8)  | (uint64_t)chunk[8*i + 7];
+    for (; nblocks > 0; nblocks--, chunk += 128) {
+        for (i = 0; i < 16; i++) {
+            w[i] = ((uint64_t)chunk[8*i] << 56) | ((uint64_t)chunk[8*i + 1] << 48) |
+                   ((uint64_t)chunk[8*i + 2] << 40) | ((uint64_t)chunk[8*i + 3] << 32) |
+                   ((uint64_t)chunk[8*i + 4] << 24) | ((uint64_t)chunk[8*i + 5] << 16) |
+                   ((uint64_t)chunk[8*i + 6] << 8)  | (uint64_t)chunk[8*i + 7];
+        }
+        for (i = 16; i < 80; i++) {
+            uint64_t x0 = hsh_sha2_ror64(w[i-15], 1) ^ hsh_sha2_ror64(w[i-15], 8) ^ (w[i-15] >> 7);
+            uint64_t x1 = hsh_sha2_ror64(w[i-2], 19) ^ hsh_sha2_ror64(w[i-2], 61) ^ (w[i-2] >> 6);
+            w[i] = w[i-16] + x0 + w[i-7] + x1;
+        }
+        a = s0; b = s1; c = s2; d = s3;
+        e = s4; f = s5; g = s6; h = s7;
+
+        for (i = 0; i < 80; i++) {
+            uint64_t S1 = hsh_sha2_ror64(e, 14) ^ hsh_sha2_ror64(e, 18) ^ hsh_sha2_ror64(e, 41);
+            uint64_t temp1 = h + S1 + hsh_sha2_ch(e, f, g) + hsh_sha2_K512[i] + w[i];
+            uint64_t S0 = hsh_sha2_ror64(a, 28) ^ hsh_sha2_ror64(a, 34) ^ hsh_sha2_ror64(a, 39);
+            uint64_t temp2 = S0 + hsh_sha2_maj(a, b, c);
+
+            h = g; g = f; f = e; e = d + temp1; d = c; c = b; b = a; a = temp1 + temp2;
+        }
+
+        s0 += a; s1 += b; s2 += c; s3 += d;
+        s4 += e; s5 += f; s6 += g; s7 += h;
     }
-    for (i = 16; i < 80; i++) {
-        uint64_t s0 = hsh_sha2_ror64(w[i-15], 1) ^ hsh_sha2_ror64(w[i-15], 8) ^ (w[i-15] >> 7);
-        uint64_t s1 = hsh_sha2_ror64(w[i-2], 19) ^ hsh_sha2_ror64(w[i-2], 61) ^ (w[i-2] >> 6);
-        w[i] = w[i-16] + s0 + w[i-7] + s1;
+
+    state[0] = s0; state[1] = s1; state[2] = s2; state[3] = s3;
+    state[4] = s4; state[5] = s5; state[6] = s6; state[7] = s7;
+}
+
+/* SHA-512/384: compress nblocks 128-byte blocks */
+void hsh_sha2_512_blocks(uint64_t state[8], const unsigned char *data, size_t nblocks) {
+    hsh_sha2_512_blocks_generic(state, data, nblocks);
+}
+
+/* SHA-256/224: build the padded final block(s) from the < 64 trailing message
+ * bytes and the total message length in bits; returns the block count (1 or 2) */
+size_t hsh_sha2_256_pad(unsigned char out[128], const unsigned char *tail, size_t tail_len,
+                        uint64_t bit_len) {
+    size_t i;
+    size_t total = (tail_len < 56) ? 64 : 128;
+
+    memcpy(out, tail, tail_len);
+    out[tail_len] = 0x80;
+    memset(out + tail_len + 1, 0, total - tail_len - 1 - 8);
+    for (i = 0; i < 8; i++) {
+        out[total - 1 - i] = (unsigned char)(bit_len >> (8 * i));
     }
-    a = ctx->h[0]; b = ctx->h[1]; c = ctx->h[2]; d = ctx->h[3];
-    e = ctx->h[4]; f = ctx->h[5]; g = ctx->h[6]; h = ctx->h[7];
+    return total / 64;
+}
 
-    for (i = 0; i < 80; i++) {
-        uint64_t S1 = hsh_sha2_ror64(e, 14) ^ hsh_sha2_ror64(e, 18) ^ hsh_sha2_ror64(e, 41);
-        uint64_t temp1 = h + S1 + hsh_sha2_ch(e, f, g) + hsh_sha2_K512[i] + w[i];
-        uint64_t S0 = hsh_sha2_ror64(a, 28) ^ hsh_sha2_ror64(a, 34) ^ hsh_sha2_ror64(a, 39);
-        uint64_t temp2 = S0 + hsh_sha2_maj(a, b, c);
+/* SHA-512/384: same as above for < 128 trailing bytes; the 128-bit length
+ * field carries bit_len in its low 64 bits. Returns 1 or 2 blocks. */
+size_t hsh_sha2_512_pad(unsigned char out[256], const unsigned char *tail, size_t tail_len,
+                        uint64_t bit_len) {
+    size_t i;
+    size_t total = (tail_len < 112) ? 128 : 256;
 
-        h = g; g = f; f = e; e = d + temp1; d = c; c = b; b = a; a = temp1 + temp2;
+    memcpy(out, tail, tail_len);
+    out[tail_len] = 0x80;
+    memset(out + tail_len + 1, 0, total - tail_len - 1 - 8);
+    for (i = 0; i < 8; i++) {
+        out[total - 1 - i] = (unsigned char)(bit_len >> (8 * i));
     }
+    return total / 128;
+}
+
+/* Initial hash values */
+static const uint32_t hsh_sha2_256_iv[8] = {
+    0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a,
+    0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19
+};
+
+static const uint32_t hsh_sha2_224_iv[8] = {
+    0xc1059ed8,0x367cd507,0x3070dd17,0xf70e5939,
+    0xffc00b31,0x68581511,0x64f98fa7,0xbefa4fa4
+};
+
+static const uint64_t hsh_sha2_512_iv[8] = {
+    0x6a09e667f3bcc908ULL,0xbb67ae8584caa73bULL,
+    0x3c6ef372fe94f82bULL,0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL,0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL,0x5be0cd19137e2179ULL
+};
 
-    ctx->h[0] += a; ctx->h[1] += b; ctx->h[2] += c; ctx->h[3] += d;
-    ctx->h[4] += e; ctx->h[5] += f; ctx->h[6] += g; ctx->h[7] += h;
+static const uint64_t hsh_sha2_384_iv[8] = {
+    0xcbbb9d5dc1059ed8ULL,0x629a292a367cd507ULL,
+    0x9159015a3070dd17ULL,0x152fecd8f70e5939ULL,
+    0x67332667ffc00b31ULL,0x8eb44a8768581511ULL,
+    0xdb0c2e0d64f98fa7ULL,0x47b5481dbefa4fa4ULL
+};
+
+void hsh_sha2_256_store(const uint32_t h[8], unsigned char *digest, size_t digest_len) {
+    size_t i;
+    for (i = 0; i < digest_len / 4; i++) {
+        digest[4*i] = (h[i] >> 24) & 0xff;
+        digest[4*i + 1] = (h[i] >> 16) & 0xff;
+        digest[4*i + 2] = (h[i] >> 8) & 0xff;
+        digest[4*i + 3] = h[i] & 0xff;
+    }
+}
+
+void hsh_sha2_512_store(const uint64_t h[8], unsigned char *digest, size_t digest_len) {
+    size_t i;
+    for (i = 0; i < digest_len / 8; i++) {
+        digest[8*i] = (h[i] >> 56) & 0xff;
+        digest[8*i + 1] = (h[i] >> 48) & 0xff;
+        digest[8*i + 2] = (h[i] >> 40) & 0xff;
+        digest[8*i + 3] = (h[i] >> 32) & 0xff;
+        digest[8*i + 4] = (h[i] >> 24) & 0xff;
+        digest[8*i + 5] = (h[i] >> 16) & 0xff;
+        digest[8*i + 6] = (h[i] >> 8) & 0xff;
+        digest[8*i + 7] = h[i] & 0xff;
+    }
 }
 
 /* === SHA-224/256 functions === */
 
 void hsh_sha2_256_init(hsh_sha2_256_ctx *ctx) {
-    static const uint32_t init[8] = {
-        0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a,
-        0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19
-    };
-    memcpy(ctx->h, init, sizeof(init));
+    memcpy(ctx->h, hsh_sha2_256_iv, sizeof(hsh_sha2_256_iv));
     ctx->buffer_size = 0;
     ctx->counter = 0;
 }
 
 void hsh_sha2_224_init(hsh_sha2_224_ctx *ctx) {
-    static const uint32_t init[8] = {
-        0xc1059ed8,0x367cd507,0x3070dd17,0xf70e5939,
-        0xffc00b31,0x68581511,0x64f98fa7,0xbefa4fa4
-    };
-    memcpy(ctx->h, init, sizeof(init));
+    memcpy(ctx->h, hsh_sha2_224_iv, sizeof(hsh_sha2_224_iv));
     ctx->buffer_size = 0;
     ctx->counter = 0;
 }
 
 void hsh_sha2_256_update(hsh_sha2_256_ctx *ctx, const unsigned char *data, size_t len) {
+    size_t nblocks;
+
     ctx->counter += len * 8;
 
-    while (len > 0) {
+    /* Complete a partly filled buffer first */
+    if (ctx->buffer_size > 0) {
         size_t copy = 64 - ctx->buffer_size;
         if (copy > len) copy = len;
         memcpy(ctx->buffer + ctx->buffer_size, data, copy);
         ctx->buffer_size += copy;
         data += copy;
         len -= copy;
-
-        if (ctx->buffer_size == 64) {
-            hsh_sha2_256_process_chunk(ctx, ctx->buffer);
-            ctx->buffer_size = 0;
-        }
+        if (ctx->buffer_size < 64) return;
+        hsh_sha2_256_blocks(ctx->h, ctx->buffer, 1);
+        ctx->buffer_size = 0;
     }
+
+    /* Whole blocks straight from the caller's buffer, then keep the tail */
+    nblocks = len / 64;
+    hsh_sha2_256_blocks(ctx->h, data, nblocks);
+    data += nblocks * 64;
+    len -= nblocks * 64;
+
+    memcpy(ctx->buffer, data, len);
+    ctx->buffer_size = len;
 }
 
 void hsh_sha2_224_update(hsh_sha2_224_ctx *ctx, const unsigned char *data, size_t len) {
@@ -152,28 +267,12 @@ void hsh_sha2_224_update(hsh_sha2_224_ctx *ctx, const unsigned char *data, size_
 }
 
 void hsh_sha2_256_finalize(hsh_sha2_256_ctx *ctx, unsigned char *digest) {
-    size_t i;
-    uint64_t bit_len = ctx->counter;
-
-    ctx->buffer[ctx->buffer_size++] = 0x80;
-    if (ctx->buffer_size > 56) {
-        while (ctx->buffer_size < 64) ctx->buffer[ctx->buffer_size++] = 0;
-        hsh_sha2_256_process_chunk(ctx, ctx->buffer);
-        ctx->buffer_size = 0;
-    }
-    while (ctx->buffer_size < 56) ctx->buffer[ctx->buffer_size++] = 0;
-
-    for (i = 0; i < 8; i++) {
-        ctx->buffer[63 - i] = (unsigned char)(bit_len >> (8 * i));
-    }
-    hsh_sha2_256_process_chunk(ctx, ctx->buffer);
+    unsigned char last[128];
+    size_t nblocks = hsh_sha2_256_pad(last, ctx->buffer, ctx->buffer_size, ctx->counter);
 
-    for (i = 0; i < 8; i++) {
-        digest[4*i] = (ctx->h[i] >> 24) & 0xff;
-        digest[4*i + 1] = (ctx->h[i] >> 16) & 0xff;
-        digest[4*i + 2] = (ctx->h[i] >> 8) & 0xff;
-        digest[4*i + 3] = ctx->h[i] & 0xff;
-    }
+    hsh_sha2_256_blocks(ctx->h, last, nblocks);
+    ctx->buffer_size = 0;
+    hsh_sha2_256_store(ctx->h, digest, 32);
 }
 
 void hsh_sha2_224_finalize(hsh_sha2_224_ctx *ctx, unsigned char *digest) {
@@ -185,45 +284,43 @@ void hsh_sha2_224_finalize(hsh_sha2_224_ctx *ctx, unsigned char *digest) {
 /* === SHA-384/512 functions === */
 
 void hsh_sha2_512_init(hsh_sha2_512_ctx *ctx) {
-    static const uint64_t init[8] = {
-        0x6a09e667f3bcc908ULL,0xbb67ae8584caa73bULL,
-        0x3c6ef372fe94f82bULL,0xa54ff53a5f1d36f1ULL,
-        0x510e527fade682d1ULL,0x9b05688c2b3e6c1fULL,
-        0x1f83d9abfb41bd6bULL,0x5be0cd19137e2179ULL
-    };
-    memcpy(ctx->h, init, sizeof(init));
+    memcpy(ctx->h, hsh_sha2_512_iv, sizeof(hsh_sha2_512_iv));
     ctx->buffer_size = 0;
     ctx->counter = 0;
 }
 
 void hsh_sha2_384_init(hsh_sha2_384_ctx *ctx) {
-    static const uint64_t init[8] = {
-        0xcbbb9d5dc1059ed8ULL,0x629a292a367cd507ULL,
-        0x9159015a3070dd17ULL,0x152fecd8f70e5939ULL,
-        0x67332667ffc00b31ULL,0x8eb44a8768581511ULL,
-        0xdb0c2e0d64f98fa7ULL,0x47b5481dbefa4fa4ULL
-    };
-    memcpy(ctx->h, init, sizeof(init));
+    memcpy(ctx->h, hsh_sha2_384_iv, sizeof(hsh_sha2_384_iv));
     ctx->buffer_size = 0;
     ctx->counter = 0;
 }
 
 void hsh_sha2_512_update(hsh_sha2_512_ctx *ctx, const unsigned char *data, size_t len) {
+    size_t nblocks;
+
     ctx->counter += len * 8;
 
-    while (len > 0) {
+    /* Complete a partly filled buffer first */
+    if (ctx->buffer_size > 0) {
         size_t copy = 128 - ctx->buffer_size;
         if (copy > len) copy = len;
         memcpy(ctx->buffer + ctx->buffer_size, data, copy);
         ctx->buffer_size += copy;
         data += copy;
         len -= copy;
-
-        if (ctx->buffer_size == 128) {
-            hsh_sha2_512_process_chunk(ctx, ctx->buffer);
-            ctx->buffer_size = 0;
-        }
+        if (ctx->buffer_size < 128) return;
+        hsh_sha2_512_blocks(ctx->h, ctx->buffer, 1);
+        ctx->buffer_size = 0;
     }
+
+    /* Whole blocks straight from the caller's buffer, then keep the tail */
+    nblocks = len / 128;
+    hsh_sha2_512_blocks(ctx->h, data, nblocks);
+    data += nblocks * 128;
+    len -= nblocks * 128;
+
+    memcpy(ctx->buffer, data, len);
+    ctx->buffer_size = len;
 }
 
 void hsh_sha2_384_update(hsh_sha2_384_ctx *ctx, const unsigned char *data, size_t len) {
@@ -231,33 +328,12 @@ void hsh_sha2_384_update(hsh_sha2_384_ctx *ctx, const unsigned char *data, size_
 }
 
 void hsh_sha2_512_finalize(hsh_sha2_512_ctx *ctx, unsigned char *digest) {
-    size_t i;
-    uint64_t bit_len = ctx->counter;
+    unsigned char last[256];
+    size_t nblocks = hsh_sha2_512_pad(last, ctx->buffer, ctx->buffer_size, ctx->counter);
 
-    ctx->buffer[ctx->buffer_size++] = 0x80;
-    if (ctx->buffer_size > 112) {
-        while (ctx->buffer_size < 128) ctx->buffer[ctx->buffer_size++] = 0;
-        hsh_sha2_512_process_chunk(ctx, ctx->buffer);
-        ctx->buffer_size = 0;
-    }
-    while (ctx->buffer_size < 112) ctx->buffer[ctx->buffer_size++] = 0;
-
-    memset(ctx->buffer + 112, 0, 8);
-    for (i = 0; i < 8; i++) {
-        ctx->buffer[127 - i] = (unsigned char)(bit_len >> (8 * i));
-    }
-    hsh_sha2_512_process_chunk(ctx, ctx->buffer);
-
-    for (i = 0; i < 8; i++) {
-        digest[8*i] = (ctx->h[i] >> 56) & 0xff;
-        digest[8*i + 1] = (ctx->h[i] >> 48) & 0xff;
-        digest[8*i + 2] = (ctx->h[i] >> 40) & 0xff;
-        digest[8*i + 3] = (ctx->h[i] >> 32) & 0xff;
-        digest[8*i + 4] = (ctx->h[i] >> 24) & 0xff;
-        digest[8*i + 5] = (ctx->h[i] >> 16) & 0xff;
-        digest[8*i + 6] = (ctx->h[i] >> 8) & 0xff;
-        digest[8*i + 7] = ctx->h[i] & 0xff;
-    }
+    hsh_sha2_512_blocks(ctx->h, last, nblocks);
+    ctx->buffer_size = 0;
+    hsh_sha2_512_store(ctx->h, digest, 64);
 }
 
 void hsh_sha2_384_finalize(hsh_sha2_384_ctx *ctx, unsigned char *digest) {
@@ -265,3 +341,51 @@ void hsh_sha2_384_finalize(hsh_sha2_384_ctx *ctx, unsigned char *digest) {
     hsh_sha2_512_finalize(ctx, full);
     memcpy(digest, full, 48);
 }
+
+/* === One-shot functions === */
+
+/* Whole blocks are compressed straight from data and the padded tail (one
+ * or two blocks) is built on the stack; no context is touched. */
+static void hsh_sha2_256_oneshot(const uint32_t iv[8], const unsigned char *data, size_t len,
+                                 unsigned char *digest, size_t digest_len) {
+    uint32_t h[8];
+    unsigned char last[128];
+    size_t full = len / 64, nblocks;
+
+    memcpy(h, iv, sizeof(h));
+    if (full > 0)
+        hsh_sha2_256_blocks(h, data, full);
+    nblocks = hsh_sha2_256_pad(last, data + full * 64, len - full * 64, (uint64_t)len * 8);
+    hsh_sha2_256_blocks(h, last, nblocks);
+    hsh_sha2_256_store(h, digest, digest_len);
+}
+
+static void hsh_sha2_512_oneshot(const uint64_t iv[8], const unsigned char *data, size_t len,
+                                 unsigned char *digest, size_t digest_len) {
+    uint64_t h[8];
+    unsigned char last[256];
+    size_t full = len / 128, nblocks;
+
+    memcpy(h, iv, sizeof(h));
+    if (full > 0)
+        hsh_sha2_512_blocks(h, data, full);
+    nblocks = hsh_sha2_512_pad(last, data + full * 128, len - full * 128, (uint64_t)len * 8);
+    hsh_sha2_512_blocks(h, last, nblocks);
+    hsh_sha2_512_store(h, digest, digest_len);
+}
+
+void hsh_sha2_256(const unsigned char *data, size_t len, unsigned char *digest) {
+    hsh_sha2_256_oneshot(hsh_sha2_256_iv, data, len, digest, 32);
+}
+
+void hsh_sha2_224(const unsigned char *data, size_t len, unsigned char *digest) {
+    hsh_sha2_256_oneshot(hsh_sha2_224_iv, data, len, digest, 28);
+}
+
+void hsh_sha2_512(const unsigned char *data, size_t len, unsigned char *digest) {
+    hsh_sha2_512_oneshot(hsh_sha2_512_iv, data, len, digest, 64);
+}
+
+void hsh_sha2_384(const unsigned char *data, size_t len, unsigned char *digest) {
+    hsh_sha2_512_oneshot(hsh_sha2_384_iv, data, len, digest, 48);
+}
@@ -0,0 +1,185 @@
+#include "sha2_internal.h"
+
+#if HSH_X86
+#include <immintrin.h>
+
+/* 32-bit lane helpers */
+#define HSH_V32_ROR(x,n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+#define HSH_V_CH(x,y,z)  _mm256_xor_si256(_mm256_and_si256((x), (y)), _mm256_andnot_si256((x), (z)))
+#define HSH_V_MAJ(x,y,z) _mm256_or_si256(_mm256_and_si256((x), (y)), _mm256_and_si256(_mm256_or_si256((x), (y)), (z)))
+
+/* Transpose an 8x8 matrix of 32-bit words held in r[0..7] */
+__attribute__((target("avx2")))
+static inline void hsh_sha2_transpose8x32(__m256i r[8]) {
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+__attribute__((target("avx2")))
+void hsh_sha2_256_x8_avx2(uint32_t state[8][8], const unsigned char *const blocks[8]) {
+    const __m256i BSWAP = _mm256_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL,
+                                            0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m256i w[16];
+    __m256i a, b, c, d, e, f, g, h;
+    int i;
+
+    /* Load each lane's block and transpose so w[j] holds word j of every lane */
+    for (i = 0; i < 8; i++) {
+        w[i] = _mm256_loadu_si256((const __m256i *)blocks[i]);
+        w[i + 8] = _mm256_loadu_si256((const __m256i *)(blocks[i] + 32));
+    }
+    hsh_sha2_transpose8x32(w);
+    hsh_sha2_transpose8x32(w + 8);
+    for (i = 0; i < 16; i++)
+        w[i] = _mm256_shuffle_epi8(w[i], BSWAP);
+
+    a = _mm256_loadu_si256((const __m256i *)state[0]);
+    b = _mm256_loadu_si256((const __m256i *)state[1]);
+    c = _mm256_loadu_si256((const __m256i *)state[2]);
+    d = _mm256_loadu_si256((const __m256i *)state[3]);
+    e = _mm256_loadu_si256((const __m256i *)state[4]);
+    f = _mm256_loadu_si256((const __m256i *)state[5]);
+    g = _mm256_loadu_si256((const __m256i *)state[6]);
+    h = _mm256_loadu_si256((const __m256i *)state[7]);
+
+    for (i = 0; i < 64; i++) {
+        __m256i wi;
+        if (i < 16) {
+            wi = w[i];
+        } else {
+            __m256i w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(HSH_V32_ROR(w15, 7), HSH_V32_ROR(w15, 18)),
+                                          _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(HSH_V32_ROR(w2, 17), HSH_V32_ROR(w2, 19)),
+                                          _mm256_srli_epi32(w2, 10));
+            wi = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0),
+                                  _mm256_add_epi32(w[(i - 7) & 15], s1));
+            w[i & 15] = wi;
+        }
+
+        __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(HSH_V32_ROR(e, 6), HSH_V32_ROR(e, 11)),
+                                      HSH_V32_ROR(e, 25));
+        __m256i temp1 = _mm256_add_epi32(_mm256_add_epi32(h, S1),
+                                         _mm256_add_epi32(HSH_V_CH(e, f, g),
+                                                          _mm256_add_epi32(wi, _mm256_set1_epi32((int)hsh_sha2_K256[i]))));
+        __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(HSH_V32_ROR(a, 2), HSH_V32_ROR(a, 13)),
+                                      HSH_V32_ROR(a, 22));
+        __m256i temp2 = _mm256_add_epi32(S0, HSH_V_MAJ(a, b, c));
+
+        h = g; g = f; f = e; e = _mm256_add_epi32(d, temp1);
+        d = c; c = b; b = a; a = _mm256_add_epi32(temp1, temp2);
+    }
+
+    _mm256_storeu_si256((__m256i *)state[0], _mm256_add_epi32(a, _mm256_loadu_si256((const __m256i *)state[0])));
+    _mm256_storeu_si256((__m256i *)state[1], _mm256_add_epi32(b, _mm256_loadu_si256((const __m256i *)state[1])));
+    _mm256_storeu_si256((__m256i *)state[2], _mm256_add_epi32(c, _mm256_loadu_si256((const __m256i *)state[2])));
+    _mm256_storeu_si256((__m256i *)state[3], _mm256_add_epi32(d, _mm256_loadu_si256((const __m256i *)state[3])));
+    _mm256_storeu_si256((__m256i *)state[4], _mm256_add_epi32(e, _mm256_loadu_si256((const __m256i *)state[4])));
+    _mm256_storeu_si256((__m256i *)state[5], _mm256_add_epi32(f, _mm256_loadu_si256((const __m256i *)state[5])));
+    _mm256_storeu_si256((__m256i *)state[6], _mm256_add_epi32(g, _mm256_loadu_si256((const __m256i *)state[6])));
+    _mm256_storeu_si256((__m256i *)state[7], _mm256_add_epi32(h, _mm256_loadu_si256((const __m256i *)state[7])));
+}
+
+/* 64-bit lane helpers */
+#define HSH_V64_ROR(x,n) _mm256_or_si256(_mm256_srli_epi64((x), (n)), _mm256_slli_epi64((x), 64 - (n)))
+
+/* Transpose a 4x4 matrix of 64-bit words held in r[0..3] */
+__attribute__((target("avx2")))
+static inline void hsh_sha2_transpose4x64(__m256i r[4]) {
+    __m256i t0 = _mm256_unpacklo_epi64(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi64(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi64(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi64(r[2], r[3]);
+    r[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+    r[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+    r[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+    r[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+__attribute__((target("avx2")))
+void hsh_sha2_512_x4_avx2(uint64_t state[8][4], const unsigned char *const blocks[4]) {
+    const __m256i BSWAP = _mm256_set_epi64x(0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL,
+                                            0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL);
+    __m256i w[16];
+    __m256i a, b, c, d, e, f, g, h;
+    int i, k;
+
+    /* w[4k..4k+3] come from bytes 32k..32k+31 of each lane's block */
+    for (k = 0; k < 4; k++) {
+        for (i = 0; i < 4; i++)
+            w[4*k + i] = _mm256_loadu_si256((const __m256i *)(blocks[i] + 32*k));
+        hsh_sha2_transpose4x64(w + 4*k);
+    }
+    for (i = 0; i < 16; i++)
+        w[i] = _mm256_shuffle_epi8(w[i], BSWAP);
+
+    a = _mm256_loadu_si256((const __m256i *)state[0]);
+    b = _mm256_loadu_si256((const __m256i *)state[1]);
+    c = _mm256_loadu_si256((const __m256i *)state[2]);
+    d = _mm256_loadu_si256((const __m256i *)state[3]);
+    e = _mm256_loadu_si256((const __m256i *)state[4]);
+    f = _mm256_loadu_si256((const __m256i *)state[5]);
+    g = _mm256_loadu_si256((const __m256i *)state[6]);
+    h = _mm256_loadu_si256((const __m256i *)state[7]);
+
+    for (i = 0; i < 80; i++) {
+        __m256i wi;
+        if (i < 16) {
+            wi = w[i];
+        } else {
+            __m256i w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(HSH_V64_ROR(w15, 1), HSH_V64_ROR(w15, 8)),
+                                          _mm256_srli_epi64(w15, 7));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(HSH_V64_ROR(w2, 19), HSH_V64_ROR(w2, 61)),
+                                          _mm256_srli_epi64(w2, 6));
+            wi = _mm256_add_epi64(_mm256_add_epi64(w[i & 15], s0),
+                                  _mm256_add_epi64(w[(i - 7) & 15], s1));
+            w[i & 15] = wi;
+        }
+
+        __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(HSH_V64_ROR(e, 14), HSH_V64_ROR(e, 18)),
+                                      HSH_V64_ROR(e, 41));
+        __m256i temp1 = _mm256_add_epi64(_mm256_add_epi64(h, S1),
+                                         _mm256_add_epi64(HSH_V_CH(e, f, g),
+                                                          _mm256_add_epi64(wi, _mm256_set1_epi64x((long long)hsh_sha2_K512[i]))));
+        __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(HSH_V64_ROR(a, 28), HSH_V64_ROR(a, 34)),
+                                      HSH_V64_ROR(a, 39));
+        __m256i temp2 = _mm256_add_epi64(S0, HSH_V_MAJ(a, b, c));
+
+        h = g; g = f; f = e; e = _mm256_add_epi64(d, temp1);
+        d = c; c = b; b = a; a = _mm256_add_epi64(temp1, temp2);
+    }
+
+    _mm256_storeu_si256((__m256i *)state[0], _mm256_add_epi64(a, _mm256_loadu_si256((const __m256i *)state[0])));
+    _mm256_storeu_si256((__m256i *)state[1], _mm256_add_epi64(b, _mm256_loadu_si256((const __m256i *)state[1])));
+    _mm256_storeu_si256((__m256i *)state[2], _mm256_add_epi64(c, _mm256_loadu_si256((const __m256i *)state[2])));
+    _mm256_storeu_si256((__m256i *)state[3], _mm256_add_epi64(d, _mm256_loadu_si256((const __m256i *)state[3])));
+    _mm256_storeu_si256((__m256i *)state[4], _mm256_add_epi64(e, _mm256_loadu_si256((const __m256i *)state[4])));
+    _mm256_storeu_si256((__m256i *)state[5], _mm256_add_epi64(f, _mm256_loadu_si256((const __m256i *)state[5])));
+    _mm256_storeu_si256((__m256i *)state[6], _mm256_add_epi64(g, _mm256_loadu_si256((const __m256i *)state[6])));
+    _mm256_storeu_si256((__m256i *)state[7], _mm256_add_epi64(h, _mm256_loadu_si256((const __m256i *)state[7])));
+}
+
+#endif /* HSH_X86 */
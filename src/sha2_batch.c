@@ -0,0 +1,168 @@
+#include "sha2.h"
+#include "sha2_internal.h"
+#include "batch_internal.h"
+
+/*
+ * Multi-buffer SHA-2: each SIMD lane carries an independent message, fed
+ * by the shared lane scheduler in batch.c. The lane states are kept
+ * transposed, state[j][lane], the layout the AVX2 kernels work on.
+ */
+
+#define HSH_SHA2_256_LANES 8
+#define HSH_SHA2_512_LANES 4
+
+/* === SHA-224/256 === */
+
+typedef struct {
+    uint32_t state[8][HSH_SHA2_256_LANES];
+    const uint32_t *iv;
+    size_t digest_len;
+} hsh_sha2_256_lanes;
+
+static size_t hsh_sha2_256_lanes_pad(void *arg, unsigned char *out, const unsigned char *tail,
+                                     size_t tail_len, uint64_t len) {
+    (void)arg;
+    return hsh_sha2_256_pad(out, tail, tail_len, len * 8);
+}
+
+#if HSH_X86
+static void hsh_sha2_256_lanes_kernel(void *arg, const unsigned char *const *blocks) {
+    hsh_sha2_256_lanes *s = arg;
+    hsh_sha2_256_x8_avx2(s->state, blocks);
+}
+#endif
+
+static void hsh_sha2_256_lanes_reset(void *arg, size_t lane) {
+    hsh_sha2_256_lanes *s = arg;
+    for (size_t j = 0; j < 8; j++) s->state[j][lane] = s->iv[j];
+}
+
+static void hsh_sha2_256_lanes_compress(void *arg, size_t lane, const unsigned char *data,
+                                        size_t nblocks) {
+    hsh_sha2_256_lanes *s = arg;
+    uint32_t h[8];
+    size_t j;
+
+    if (nblocks == 0) return;
+    for (j = 0; j < 8; j++) h[j] = s->state[j][lane];
+    hsh_sha2_256_blocks(h, data, nblocks);
+    for (j = 0; j < 8; j++) s->state[j][lane] = h[j];
+}
+
+static void hsh_sha2_256_lanes_store(void *arg, size_t lane, unsigned char *digest) {
+    hsh_sha2_256_lanes *s = arg;
+    uint32_t h[8];
+    for (size_t j = 0; j < 8; j++) h[j] = s->state[j][lane];
+    hsh_sha2_256_store(h, digest, s->digest_len);
+}
+
+static void hsh_sha2_256_batch_iv(const uint32_t iv[8], const unsigned char *const *data,
+                                  const size_t *lens, size_t count,
+                                  unsigned char *digests, size_t digest_len) {
+    hsh_sha2_256_lanes s;
+    hsh_batch_engine engine = {
+        HSH_SHA2_256_LANES, 64, digest_len, &s,
+        hsh_sha2_256_lanes_pad, NULL, hsh_sha2_256_lanes_reset,
+        hsh_sha2_256_lanes_compress, hsh_sha2_256_lanes_store,
+    };
+#if HSH_X86
+    /* SHA-NI on one stream outruns 8 AVX2 lanes, so lanes are only used without it */
+    unsigned features = hsh_cpu_features();
+    if ((features & HSH_CPU_AVX2) && (features & HSH_CPU_SHANI) != HSH_CPU_SHANI)
+        engine.kernel = hsh_sha2_256_lanes_kernel;
+#endif
+    s.iv = iv;
+    s.digest_len = digest_len;
+    hsh_batch_run(&engine, data, lens, count, digests);
+}
+
+void hsh_sha2_256_batch(const unsigned char *const *data, const size_t *lens,
+                        size_t count, unsigned char *digests) {
+    hsh_sha2_256_ctx ctx;
+    hsh_sha2_256_init(&ctx);
+    hsh_sha2_256_batch_iv(ctx.h, data, lens, count, digests, 32);
+}
+
+void hsh_sha2_224_batch(const unsigned char *const *data, const size_t *lens,
+                        size_t count, unsigned char *digests) {
+    hsh_sha2_224_ctx ctx;
+    hsh_sha2_224_init(&ctx);
+    hsh_sha2_256_batch_iv(ctx.h, data, lens, count, digests, 28);
+}
+
+/* === SHA-384/512 === */
+
+typedef struct {
+    uint64_t state[8][HSH_SHA2_512_LANES];
+    const uint64_t *iv;
+    size_t digest_len;
+} hsh_sha2_512_lanes;
+
+static size_t hsh_sha2_512_lanes_pad(void *arg, unsigned char *out, const unsigned char *tail,
+                                     size_t tail_len, uint64_t len) {
+    (void)arg;
+    return hsh_sha2_512_pad(out, tail, tail_len, len * 8);
+}
+
+#if HSH_X86
+static void hsh_sha2_512_lanes_kernel(void *arg, const unsigned char *const *blocks) {
+    hsh_sha2_512_lanes *s = arg;
+    hsh_sha2_512_x4_avx2(s->state, blocks);
+}
+#endif
+
+static void hsh_sha2_512_lanes_reset(void *arg, size_t lane) {
+    hsh_sha2_512_lanes *s = arg;
+    for (size_t j = 0; j < 8; j++) s->state[j][lane] = s->iv[j];
+}
+
+static void hsh_sha2_512_lanes_compress(void *arg, size_t lane, const unsigned char *data,
+                                        size_t nblocks) {
+    hsh_sha2_512_lanes *s = arg;
+    uint64_t h[8];
+    size_t j;
+
+    if (nblocks == 0) return;
+    for (j = 0; j < 8; j++) h[j] = s->state[j][lane];
+    hsh_sha2_512_blocks(h, data, nblocks);
+    for (j = 0; j < 8; j++) s->state[j][lane] = h[j];
+}
+
+static void hsh_sha2_512_lanes_store(void *arg, size_t lane, unsigned char *digest) {
+    hsh_sha2_512_lanes *s = arg;
+    uint64_t h[8];
+    for (size_t j = 0; j < 8; j++) h[j] = s->state[j][lane];
+    hsh_sha2_512_store(h, digest, s->digest_len);
+}
+
+static void hsh_sha2_512_batch_iv(const uint64_t iv[8], const unsigned char *const *data,
+                                  const size_t *lens, size_t count,
+                                  unsigned char *digests, size_t digest_len) {
+    hsh_sha2_512_lanes s;
+    hsh_batch_engine engine = {
+        HSH_SHA2_512_LANES, 128, digest_len, &s,
+        hsh_sha2_512_lanes_pad, NULL, hsh_sha2_512_lanes_reset,
+        hsh_sha2_512_lanes_compress, hsh_sha2_512_lanes_store,
+    };
+#if HSH_X86
+    if (hsh_cpu_features() & HSH_CPU_AVX2)
+        engine.kernel = hsh_sha2_512_lanes_kernel;
+#endif
+    s.iv = iv;
+    s.digest_len = digest_len;
+    hsh_batch_run(&engine, data, lens, count, digests);
+}
+
+void hsh_sha2_512_batch(const unsigned char *const *data, const size_t *lens,
+                        size_t count, unsigned char *digests) {
+    hsh_sha2_512_ctx ctx;
+    hsh_sha2_512_init(&ctx);
+    hsh_sha2_512_batch_iv(ctx.h, data, lens, count, digests, 64);
+}
+
+void hsh_sha2_384_batch(const unsigned char *const *data, const size_t *lens,
+                        size_t count, unsigned char *digests) {
+    hsh_sha2_384_ctx ctx;
+    hsh_sha2_384_init(&ctx);
+    hsh_sha2_512_batch_iv(ctx.h, data, lens, count, digests, 48);
+}
@@ -0,0 +1,42 @@
+#ifndef HSH_SHA2_INTERNAL_H
+#define HSH_SHA2_INTERNAL_H
+
+/* Internal: pieces of sha2.c shared with the SIMD backends. */
+
+#include "cpu.h"
+#include <stdint.h>
+#include <stddef.h>
+
+extern const uint32_t hsh_sha2_K256[64];
+extern const uint64_t hsh_sha2_K512[80];
+
+/* Compress nblocks 64-byte blocks using the best available backend */
+void hsh_sha2_256_blocks(uint32_t state[8], const unsigned char *data, size_t nblocks);
+
+/* Write the padded final block(s) for a message ending in tail[0..tail_len)
+ * (tail_len < 64) into out; returns the number of 64-byte blocks (1 or 2) */
+size_t hsh_sha2_256_pad(unsigned char out[128], const unsigned char *tail, size_t tail_len,
+                        uint64_t bit_len);
+
+/* SHA-512/384 counterparts of the above, on 128-byte blocks */
+void hsh_sha2_512_blocks(uint64_t state[8], const unsigned char *data, size_t nblocks);
+size_t hsh_sha2_512_pad(unsigned char out[256], const unsigned char *tail, size_t tail_len,
+                        uint64_t bit_len);
+
+/* Write the first digest_len bytes of the big-endian digest of state h */
+void hsh_sha2_256_store(const uint32_t h[8], unsigned char *digest, size_t digest_len);
+void hsh_sha2_512_store(const uint64_t h[8], unsigned char *digest, size_t digest_len);
+
+#if HSH_X86
+/* SHA-NI compression of nblocks consecutive 64-byte blocks */
+void hsh_sha2_256_blocks_shani(uint32_t h[8], const unsigned char *data, size_t nblocks);
+
+/* AVX2 compression of one block in each of 8 independent messages.
+ * state[j][lane] holds word j of lane's chaining value. */
+void hsh_sha2_256_x8_avx2(uint32_t state[8][8], const unsigned char *const blocks[8]);
+
+/* AVX2 compression of one 128-byte block in each of 4 independent messages */
+void hsh_sha2_512_x4_avx2(uint64_t state[8][4], const unsigned char *const blocks[4]);
+#endif
+
+#endif /* HSH_SHA2_INTERNAL_H */
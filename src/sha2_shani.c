@@ -0,0 +1,76 @@
+#include "sha2_internal.h"
+
+#if HSH_X86
+#include <immintrin.h>
+
+/* One quad-round: 4 rounds consuming the message words in W */
+#define HSH_SHA2_QROUND(W, i) do { \
+    MSG = _mm_add_epi32((W), _mm_loadu_si128((const __m128i *)&hsh_sha2_K256[4 * (i)])); \
+    STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, MSG); \
+    MSG = _mm_shuffle_epi32(MSG, 0x0E); \
+    STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, MSG); \
+} while (0)
+
+/* Message schedule: W0 (words t-16..t-13) becomes words t..t+3 */
+#define HSH_SHA2_SCHED(W0, W1, W2, W3) do { \
+    W0 = _mm_sha256msg1_epu32(W0, W1); \
+    W0 = _mm_add_epi32(W0, _mm_alignr_epi8(W3, W2, 4)); \
+    W0 = _mm_sha256msg2_epu32(W0, W3); \
+} while (0)
+
+__attribute__((target("sha,sse4.1")))
+void hsh_sha2_256_blocks_shani(uint32_t h[8], const unsigned char *data, size_t nblocks) {
+    const __m128i BSWAP = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i STATE0, STATE1, MSG, TMP;
+    __m128i W0, W1, W2, W3;
+    __m128i ABEF_SAVE, CDGH_SAVE;
+
+    /* Rearrange h[] into the ABEF/CDGH layout the SHA instructions expect */
+    TMP = _mm_loadu_si128((const __m128i *)&h[0]);
+    STATE1 = _mm_loadu_si128((const __m128i *)&h[4]);
+    TMP = _mm_shuffle_epi32(TMP, 0xB1);
+    STATE1 = _mm_shuffle_epi32(STATE1, 0x1B);
+    STATE0 = _mm_alignr_epi8(TMP, STATE1, 8);
+    STATE1 = _mm_blend_epi16(STATE1, TMP, 0xF0);
+
+    while (nblocks--) {
+        ABEF_SAVE = STATE0;
+        CDGH_SAVE = STATE1;
+
+        W0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), BSWAP);
+        W1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), BSWAP);
+        W2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), BSWAP);
+        W3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), BSWAP);
+
+        HSH_SHA2_QROUND(W0, 0);
+        HSH_SHA2_QROUND(W1, 1);
+        HSH_SHA2_QROUND(W2, 2);
+        HSH_SHA2_QROUND(W3, 3);
+        HSH_SHA2_SCHED(W0, W1, W2, W3); HSH_SHA2_QROUND(W0, 4);
+        HSH_SHA2_SCHED(W1, W2, W3, W0); HSH_SHA2_QROUND(W1, 5);
+        HSH_SHA2_SCHED(W2, W3, W0, W1); HSH_SHA2_QROUND(W2, 6);
+        HSH_SHA2_SCHED(W3, W0, W1, W2); HSH_SHA2_QROUND(W3, 7);
+        HSH_SHA2_SCHED(W0, W1, W2, W3); HSH_SHA2_QROUND(W0, 8);
+        HSH_SHA2_SCHED(W1, W2, W3, W0); HSH_SHA2_QROUND(W1, 9);
+        HSH_SHA2_SCHED(W2, W3, W0, W1); HSH_SHA2_QROUND(W2, 10);
+        HSH_SHA2_SCHED(W3, W0, W1, W2); HSH_SHA2_QROUND(W3, 11);
+        HSH_SHA2_SCHED(W0, W1, W2, W3); HSH_SHA2_QROUND(W0, 12);
+        HSH_SHA2_SCHED(W1, W2, W3, W0); HSH_SHA2_QROUND(W1, 13);
+        HSH_SHA2_SCHED(W2, W3, W0, W1); HSH_SHA2_QROUND(W2, 14);
+        HSH_SHA2_SCHED(W3, W0, W1, W2); HSH_SHA2_QROUND(W3, 15);
+
+        STATE0 = _mm_add_epi32(STATE0, ABEF_SAVE);
+        STATE1 = _mm_add_epi32(STATE1, CDGH_SAVE);
+        data += 64;
+    }
+
+    /* Back to h[0..7] order */
+    TMP = _mm_shuffle_epi32(STATE0, 0x1B);
+    STATE1 = _mm_shuffle_epi32(STATE1, 0xB1);
+    STATE0 = _mm_blend_epi16(TMP, STATE1, 0xF0);
+    STATE1 = _mm_alignr_epi8(STATE1, TMP, 8);
+    _mm_storeu_si128((__m128i *)&h[0], STATE0);
+    _mm_storeu_si128((__m128i *)&h[4], STATE1);
+}
+
+#endif /* HSH_X86 */
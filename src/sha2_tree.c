@@ -0,0 +1,170 @@
+#include "sha2.h"
+#include "pool.h"
+#include <string.h>
+
+/*
+ * SHA-256 tree hash. Pairing digests level by level with the odd one moving
+ * up gives the same tree as folding a stack of complete power-of-two
+ * subtrees, so the streaming context only keeps one digest per set bit of
+ * the leaf count. Runs of whole leaves inside an update are hashed straight
+ * from the caller's buffer, several at once.
+ */
+
+/* Leaves per pool task; hsh_sha2_256_batch spreads them over SIMD lanes */
+#define HSH_SHA2_TREE_GROUP 8
+/* Most leaves hashed in one parallel round (their digests live on the stack) */
+#define HSH_SHA2_TREE_ROUND_MAX 256
+/* Rounds smaller than this are not worth waking the pool for */
+#define HSH_SHA2_TREE_PARALLEL_MIN (256 * 1024)
+
+typedef struct {
+    const unsigned char *data;
+    size_t leaf_size;
+    size_t count;
+    unsigned char *digests;
+} hsh_sha2_tree_job;
+
+static void hsh_sha2_tree_group(void *arg, size_t group)
+{
+    const hsh_sha2_tree_job *job = arg;
+    const unsigned char *ptrs[HSH_SHA2_TREE_GROUP];
+    size_t lens[HSH_SHA2_TREE_GROUP];
+    size_t first = group * HSH_SHA2_TREE_GROUP;
+    size_t n = job->count - first;
+    size_t i;
+
+    if (n > HSH_SHA2_TREE_GROUP) n = HSH_SHA2_TREE_GROUP;
+    for (i = 0; i < n; i++) {
+        ptrs[i] = job->data + (first + i) * job->leaf_size;
+        lens[i] = job->leaf_size;
+    }
+    hsh_sha2_256_batch(ptrs, lens, n, job->digests + first * 32);
+}
+
+static void hsh_sha2_tree_parent(const unsigned char left[32], const unsigned char right[32],
+                                 unsigned char out[32])
+{
+    hsh_sha2_256_ctx ctx;
+    hsh_sha2_256_init(&ctx);
+    hsh_sha2_256_update(&ctx, left, 32);
+    hsh_sha2_256_update(&ctx, right, 32);
+    hsh_sha2_256_finalize(&ctx, out);
+}
+
+/* Add the next leaf digest, merging equal-sized subtrees as they complete */
+static void hsh_sha2_tree_push(hsh_sha2_256_tree_ctx *ctx, const unsigned char digest[32])
+{
+    memcpy(ctx->stack[ctx->stack_len++], digest, 32);
+    ctx->leaves++;
+
+    while (ctx->stack_len > (size_t)__builtin_popcountll(ctx->leaves)) {
+        ctx->stack_len--;
+        hsh_sha2_tree_parent(ctx->stack[ctx->stack_len - 1], ctx->stack[ctx->stack_len],
+                             ctx->stack[ctx->stack_len - 1]);
+    }
+}
+
+/* Hash count whole leaves from data and push their digests in order */
+static void hsh_sha2_tree_leaves(hsh_sha2_256_tree_ctx *ctx, const unsigned char *data, size_t count)
+{
+    unsigned char digests[HSH_SHA2_TREE_ROUND_MAX * 32];
+    size_t round_max = HSH_SHA2_TREE_GROUP * 4 * hsh_pool_threads();
+    size_t i;
+
+    if (round_max > HSH_SHA2_TREE_ROUND_MAX) round_max = HSH_SHA2_TREE_ROUND_MAX;
+
+    while (count > 0) {
+        hsh_sha2_tree_job job;
+        size_t groups;
+
+        job.data = data;
+        job.leaf_size = ctx->leaf_size;
+        job.count = count < round_max ? count : round_max;
+        job.digests = digests;
+        groups = (job.count + HSH_SHA2_TREE_GROUP - 1) / HSH_SHA2_TREE_GROUP;
+
+        if (job.count * ctx->leaf_size >= HSH_SHA2_TREE_PARALLEL_MIN) {
+            hsh_pool_run(hsh_sha2_tree_group, &job, groups);
+        } else {
+            for (i = 0; i < groups; i++)
+                hsh_sha2_tree_group(&job, i);
+        }
+
+        for (i = 0; i < job.count; i++)
+            hsh_sha2_tree_push(ctx, digests + 32 * i);
+        data += job.count * ctx->leaf_size;
+        count -= job.count;
+    }
+}
+
+int hsh_sha2_256_tree_init(hsh_sha2_256_tree_ctx *ctx, size_t leaf_size)
+{
+    if (leaf_size == 0) return -1;
+
+    hsh_sha2_256_init(&ctx->leaf);
+    ctx->leaf_size = leaf_size;
+    ctx->leaf_fill = 0;
+    ctx->leaves = 0;
+    ctx->stack_len = 0;
+    return 0;
+}
+
+void hsh_sha2_256_tree_update(hsh_sha2_256_tree_ctx *ctx, const unsigned char *data, size_t len)
+{
+    unsigned char digest[32];
+
+    /* Top up a partly filled leaf */
+    if (ctx->leaf_fill > 0) {
+        size_t take = ctx->leaf_size - ctx->leaf_fill;
+        if (take > len) take = len;
+        hsh_sha2_256_update(&ctx->leaf, data, take);
+        ctx->leaf_fill += take;
+        data += take;
+        len -= take;
+        if (ctx->leaf_fill < ctx->leaf_size) return;
+
+        hsh_sha2_256_finalize(&ctx->leaf, digest);
+        hsh_sha2_tree_push(ctx, digest);
+        hsh_sha2_256_init(&ctx->leaf);
+        ctx->leaf_fill = 0;
+    }
+
+    if (len >= ctx->leaf_size) {
+        size_t count = len / ctx->leaf_size;
+        hsh_sha2_tree_leaves(ctx, data, count);
+        data += count * ctx->leaf_size;
+        len -= count * ctx->leaf_size;
+    }
+
+    if (len > 0) {
+        hsh_sha2_256_update(&ctx->leaf, data, len);
+        ctx->leaf_fill = len;
+    }
+}
+
+void hsh_sha2_256_tree_finalize(hsh_sha2_256_tree_ctx *ctx, unsigned char *digest)
+{
+    unsigned char leaf[32];
+    size_t i;
+
+    /* A trailing short leaf, or the single empty leaf of an empty input */
+    if (ctx->leaf_fill > 0 || ctx->leaves == 0) {
+        hsh_sha2_256_finalize(&ctx->leaf, leaf);
+        hsh_sha2_tree_push(ctx, leaf);
+    }
+
+    /* Fold the remaining subtrees right to left */
+    memcpy(digest, ctx->stack[ctx->stack_len - 1], 32);
+    for (i = ctx->stack_len - 1; i > 0; i--)
+        hsh_sha2_tree_parent(ctx->stack[i - 1], digest, digest);
+}
+
+int hsh_sha2_256_tree(const unsigned char *data, size_t len, size_t leaf_size, unsigned char *digest)
+{
+    hsh_sha2_256_tree_ctx ctx;
+
+    if (hsh_sha2_256_tree_init(&ctx, leaf_size) != 0) return -1;
+    hsh_sha2_256_tree_update(&ctx, data, len);
+    hsh_sha2_256_tree_finalize(&ctx, digest);
+    return 0;
+}
@@ -1,9 +1,10 @@
 #include "sha3.h"
+#include "sha3_internal.h"
 #include <string.h>
 #include <stdint.h>
 
-// ===== Round constants and rotation offsets =====
-static const uint64_t HSH_SHA3_RC[HSH_SHA3_NR] = {
+// ===== Round constants =====
+const uint64_t HSH_SHA3_RC[HSH_SHA3_NR] = {
     0x0000000000000001ULL, 0x0000000000008082ULL,
     0x800000000000808aULL, 0x8000000080008000ULL,
     0x000000000000808bULL, 0x0000000080000001ULL,
@@ -18,120 +19,195 @@ static const uint64_t HSH_SHA3_RC[HSH_SHA3_NR] = {
     0x0000000080000001ULL, 0x8000000080008008ULL
 };
 
-static const int HSH_SHA3_R[5][5] = {
-    {0, 36, 3, 41, 18},
-    {1, 44, 10, 45, 2},
-    {62, 6, 43, 15, 61},
-    {28, 55, 25, 21, 56},
-    {27, 20, 39, 8, 14}
-};
-
-static inline uint64_t hsh_sha3_rotl64(uint64_t x, int n) {
-    return (x << n) | (x >> (64 - n));
-}
-
 // ===== Keccak-f permutation =====
+// The state lives in locals for all 24 rounds; rounds alternate between
+// the a* and e* lane sets so nothing is copied between rounds.
 static void hsh_sha3_f(hsh_sha3_ctx *ctx) {
-    uint64_t *A = ctx->state;
-    for (int rnd = 0; rnd < HSH_SHA3_NR; rnd++) {
-        uint64_t C[5], D[5], B[25], newA[25];
-
-        for (int x = 0; x < 5; x++)
-            C[x] = A[x] ^ A[x + 5] ^ A[x + 10] ^ A[x + 15] ^ A[x + 20];
-
-        for (int x = 0; x < 5; x++)
-            D[x] = C[(x + 4) % 5] ^ hsh_sha3_rotl64(C[(x + 1) % 5], 1);
-
-        for (int x = 0; x < 5; x++)
-            for (int y = 0; y < 5; y++)
-                A[x + 5 * y] ^= D[x];
-
-        for (int x = 0; x < 5; x++)
-            for (int y = 0; y < 5; y++)
-                B[y % 5 + 5 * ((2 * x + 3 * y) % 5)] =
-                    hsh_sha3_rotl64(A[x + 5 * y], HSH_SHA3_R[x][y]);
+    uint64_t *st = ctx->state;
+    uint64_t HSH_SHA3_LANES(a), HSH_SHA3_LANES(e);
+    uint64_t B0, B1, B2, B3, B4, C0, C1, C2, C3, C4, D0, D1, D2, D3, D4;
 
-        for (int y = 0; y < 5; y++)
-            for (int x = 0; x < 5; x++)
-                newA[x + 5 * y] =
-                    B[x + 5 * y] ^ ((~B[(x + 1) % 5 + 5 * y]) &
-                                    B[(x + 2) % 5 + 5 * y]);
+    a0 = st[0];   a1 = st[1];   a2 = st[2];   a3 = st[3];   a4 = st[4];
+    a5 = st[5];   a6 = st[6];   a7 = st[7];   a8 = st[8];   a9 = st[9];
+    a10 = st[10]; a11 = st[11]; a12 = st[12]; a13 = st[13]; a14 = st[14];
+    a15 = st[15]; a16 = st[16]; a17 = st[17]; a18 = st[18]; a19 = st[19];
+    a20 = st[20]; a21 = st[21]; a22 = st[22]; a23 = st[23]; a24 = st[24];
+    HSH_SHA3_COMPLEMENTED(a);
 
-        memcpy(A, newA, sizeof(newA));
-        A[0] ^= HSH_SHA3_RC[rnd];
+    for (int rnd = 0; rnd < HSH_SHA3_NR; rnd += 2) {
+        HSH_SHA3_ROUND(a, e, HSH_SHA3_RC[rnd]);
+        HSH_SHA3_ROUND(e, a, HSH_SHA3_RC[rnd + 1]);
     }
+
+    HSH_SHA3_COMPLEMENTED(a);
+    st[0] = a0;   st[1] = a1;   st[2] = a2;   st[3] = a3;   st[4] = a4;
+    st[5] = a5;   st[6] = a6;   st[7] = a7;   st[8] = a8;   st[9] = a9;
+    st[10] = a10; st[11] = a11; st[12] = a12; st[13] = a13; st[14] = a14;
+    st[15] = a15; st[16] = a16; st[17] = a17; st[18] = a18; st[19] = a19;
+    st[20] = a20; st[21] = a21; st[22] = a22; st[23] = a23; st[24] = a24;
 }
 
 // ===== Padding (stack local only) =====
-static void hsh_sha3_pad(uint8_t *buf, size_t msg_len, size_t rate_bytes, size_t *pad_len_out) {
+void hsh_sha3_pad(uint8_t *buf, size_t msg_len, size_t rate_bytes, uint8_t domain,
+                  size_t *pad_len_out) {
     size_t pad_len = rate_bytes - (msg_len % rate_bytes);
     *pad_len_out = pad_len;
 
-    buf[msg_len] = 0x06;
-    memset(buf + msg_len + 1, 0, pad_len - 2);
+    buf[msg_len] = domain;
+    memset(buf + msg_len + 1, 0, pad_len - 1);
     buf[msg_len + pad_len - 1] |= 0x80;
 }
 
-// ===== Absorb Block =====
-static void hsh_sha3_absorb(hsh_sha3_ctx *ctx, const uint8_t *block) {
-    for (size_t i = 0; i < ctx->rate_bytes; i += 8) {
-        uint64_t val = 0;
-        memcpy(&val, block + i, 8);
-        ctx->state[i / 8] ^= val;
+// ===== Absorb Blocks =====
+// XOR lane i of the block at p into a##i; the complemented lanes need no
+// fix-up since ~x ^ m == ~(x ^ m)
+#define HSH_SHA3_XOR_LANE(i) do { \
+    uint64_t m_; \
+    memcpy(&m_, p + 8 * (i), 8); \
+    a##i ^= m_; \
+} while (0)
+
+// Absorb nblocks whole rate blocks straight from data. The state is loaded
+// into locals once and written back once, not per block.
+void hsh_sha3_absorb_blocks(hsh_sha3_ctx *ctx, const uint8_t *data, size_t nblocks) {
+    uint64_t *st = ctx->state;
+    uint64_t HSH_SHA3_LANES(a), HSH_SHA3_LANES(e);
+    uint64_t B0, B1, B2, B3, B4, C0, C1, C2, C3, C4, D0, D1, D2, D3, D4;
+    const size_t lanes = ctx->rate_bytes / 8;
+    const uint8_t *p = data;
+
+    if (nblocks == 0) return;
+
+    a0 = st[0];   a1 = st[1];   a2 = st[2];   a3 = st[3];   a4 = st[4];
+    a5 = st[5];   a6 = st[6];   a7 = st[7];   a8 = st[8];   a9 = st[9];
+    a10 = st[10]; a11 = st[11]; a12 = st[12]; a13 = st[13]; a14 = st[14];
+    a15 = st[15]; a16 = st[16]; a17 = st[17]; a18 = st[18]; a19 = st[19];
+    a20 = st[20]; a21 = st[21]; a22 = st[22]; a23 = st[23]; a24 = st[24];
+    HSH_SHA3_COMPLEMENTED(a);
+
+    for (; nblocks > 0; nblocks--, p += ctx->rate_bytes) {
+        // Every rate covers at least 9 lanes (SHA3-512) and at most 21 (SHAKE128)
+        HSH_SHA3_XOR_LANE(0); HSH_SHA3_XOR_LANE(1); HSH_SHA3_XOR_LANE(2);
+        HSH_SHA3_XOR_LANE(3); HSH_SHA3_XOR_LANE(4); HSH_SHA3_XOR_LANE(5);
+        HSH_SHA3_XOR_LANE(6); HSH_SHA3_XOR_LANE(7); HSH_SHA3_XOR_LANE(8);
+        if (lanes > 9) {
+            HSH_SHA3_XOR_LANE(9);  HSH_SHA3_XOR_LANE(10); HSH_SHA3_XOR_LANE(11);
+            HSH_SHA3_XOR_LANE(12);
+        }
+        if (lanes > 13) {
+            HSH_SHA3_XOR_LANE(13); HSH_SHA3_XOR_LANE(14); HSH_SHA3_XOR_LANE(15);
+            HSH_SHA3_XOR_LANE(16);
+        }
+        if (lanes > 17) HSH_SHA3_XOR_LANE(17);
+        if (lanes > 18) {
+            HSH_SHA3_XOR_LANE(18); HSH_SHA3_XOR_LANE(19); HSH_SHA3_XOR_LANE(20);
+        }
+
+        for (int rnd = 0; rnd < HSH_SHA3_NR; rnd += 2) {
+            HSH_SHA3_ROUND(a, e, HSH_SHA3_RC[rnd]);
+            HSH_SHA3_ROUND(e, a, HSH_SHA3_RC[rnd + 1]);
+        }
     }
-    hsh_sha3_f(ctx);
+
+    HSH_SHA3_COMPLEMENTED(a);
+    st[0] = a0;   st[1] = a1;   st[2] = a2;   st[3] = a3;   st[4] = a4;
+    st[5] = a5;   st[6] = a6;   st[7] = a7;   st[8] = a8;   st[9] = a9;
+    st[10] = a10; st[11] = a11; st[12] = a12; st[13] = a13; st[14] = a14;
+    st[15] = a15; st[16] = a16; st[17] = a17; st[18] = a18; st[19] = a19;
+    st[20] = a20; st[21] = a21; st[22] = a22; st[23] = a23; st[24] = a24;
 }
 
+#undef HSH_SHA3_XOR_LANE
+
 // ===== Update =====
+// Only a partial rate block is ever copied into buf; whole blocks are
+// absorbed directly from the caller's data
 void hsh_sha3_update(hsh_sha3_ctx *ctx, const uint8_t *data, size_t len) {
     if (ctx->finalized || len == 0) return;
 
-    size_t offset = 0;
-    while (offset < len) {
+    if (ctx->buf_len > 0) {
         size_t to_copy = ctx->rate_bytes - ctx->buf_len;
-        if (to_copy > len - offset)
-            to_copy = len - offset;
-
-        memcpy(ctx->buf + ctx->buf_len, data + offset, to_copy);
-        ctx->buf_len += to_copy;
-        offset += to_copy;
-
-        if (ctx->buf_len == ctx->rate_bytes) {
-            hsh_sha3_absorb(ctx, ctx->buf);
-            ctx->buf_len = 0;
+        if (to_copy > len) {
+            memcpy(ctx->buf + ctx->buf_len, data, len);
+            ctx->buf_len += len;
+            return;
         }
+        memcpy(ctx->buf + ctx->buf_len, data, to_copy);
+        hsh_sha3_absorb_blocks(ctx, ctx->buf, 1);
+        ctx->buf_len = 0;
+        data += to_copy;
+        len -= to_copy;
     }
-}
 
-// ===== Finalize =====
-void hsh_sha3_finalize(hsh_sha3_ctx *ctx, uint8_t *out) {
-    if (ctx->finalized) return;
+    size_t nblocks = len / ctx->rate_bytes;
+    hsh_sha3_absorb_blocks(ctx, data, nblocks);
+    data += nblocks * ctx->rate_bytes;
+    len -= nblocks * ctx->rate_bytes;
 
+    memcpy(ctx->buf, data, len);
+    ctx->buf_len = len;
+}
+
+// ===== Squeeze =====
+// Pad and absorb the buffered tail. From here on buf_len is the squeeze
+// cursor: bytes of the current output block (the first rate_bytes of the
+// state) that have already been handed out.
+static void hsh_sha3_absorb_final(hsh_sha3_ctx *ctx, uint8_t domain) {
     size_t pad_len = 0;
-    hsh_sha3_pad(ctx->buf, ctx->buf_len, ctx->rate_bytes, &pad_len);
+    hsh_sha3_pad(ctx->buf, ctx->buf_len, ctx->rate_bytes, domain, &pad_len);
     size_t total = ctx->buf_len + pad_len;
 
-    for (size_t i = 0; i < total; i += ctx->rate_bytes)
-        hsh_sha3_absorb(ctx, ctx->buf + i);
+    hsh_sha3_absorb_blocks(ctx, ctx->buf, total / ctx->rate_bytes);
 
     ctx->finalized = 1;
-    size_t out_len = ctx->output_bits / 8;
-    size_t generated = 0;
-
-    while (generated < out_len) {
-        for (size_t i = 0; i < ctx->rate_bytes / 8 && generated < out_len; i++) {
-            uint64_t val = ctx->state[i];
-            size_t to_copy = (out_len - generated < 8)
-                                 ? out_len - generated
-                                 : 8;
-            memcpy(out + generated, &val, to_copy);
-            generated += to_copy;
-        }
-        if (generated < out_len)
-            hsh_sha3_f(ctx);
+    ctx->buf_len = 0;
+}
+
+// Lanes are stored little-endian, so an output block is the state's bytes
+static void hsh_sha3_squeeze(hsh_sha3_ctx *ctx, uint8_t *out, size_t len) {
+    const uint8_t *block = (const uint8_t *)ctx->state;
+    size_t rate = ctx->rate_bytes;
+
+    // Rest of the current block
+    if (ctx->buf_len < rate) {
+        size_t n = rate - ctx->buf_len;
+        if (n > len) n = len;
+        memcpy(out, block + ctx->buf_len, n);
+        ctx->buf_len += n;
+        out += n;
+        len -= n;
+    }
+
+    // Whole blocks go straight into the caller's buffer
+    while (len >= rate) {
+        hsh_sha3_f(ctx);
+        memcpy(out, block, rate);
+        out += rate;
+        len -= rate;
+    }
+
+    if (len > 0) {
+        hsh_sha3_f(ctx);
+        memcpy(out, block, len);
+        ctx->buf_len = len;
     }
 }
 
+// ===== Finalize =====
+void hsh_sha3_finalize(hsh_sha3_ctx *ctx, uint8_t *out) {
+    if (ctx->finalized) return;
+
+    hsh_sha3_absorb_final(ctx, HSH_SHA3_DOMAIN);
+    hsh_sha3_squeeze(ctx, out, ctx->output_bits / 8);
+}
+
+void hsh_shake_squeeze(hsh_shake_ctx *ctx, uint8_t *out, size_t len) {
+    if (!ctx->finalized)
+        hsh_sha3_absorb_final(ctx, HSH_SHAKE_DOMAIN);
+    if (len > 0)
+        hsh_sha3_squeeze(ctx, out, len);
+}
+
 // ===== Initialization =====
 static void hsh_sha3_init(hsh_sha3_ctx *ctx, int capacity_bits, int output_bits) {
     memset(ctx, 0, sizeof(*ctx));
@@ -145,3 +221,52 @@ void hsh_sha3_256_init(hsh_sha3_ctx *ctx) { hsh_sha3_init(ctx, 512, 256); }
 void hsh_sha3_384_init(hsh_sha3_ctx *ctx) { hsh_sha3_init(ctx, 768, 384); }
 void hsh_sha3_512_init(hsh_sha3_ctx *ctx) { hsh_sha3_init(ctx, 1024, 512); }
 
+// SHAKE has no fixed digest; output_bits == 0 marks an XOF context
+void hsh_shake128_init(hsh_shake_ctx *ctx) { hsh_sha3_init(ctx, 256, 0); }
+void hsh_shake256_init(hsh_shake_ctx *ctx) { hsh_sha3_init(ctx, 512, 0); }
+
+void hsh_shake_update(hsh_shake_ctx *ctx, const uint8_t *data, size_t len) {
+    hsh_sha3_update(ctx, data, len);
+}
+
+// ===== One-shot =====
+// Whole rate blocks are absorbed straight from data and the padded tail
+// block is built on the stack. Only the state and rate of the context are
+// set up, so the 200-byte buffer is never cleared or copied through.
+static void hsh_sha3_oneshot(size_t rate_bytes, uint8_t domain, const uint8_t *data,
+                             size_t len, uint8_t *out, size_t out_len) {
+    hsh_sha3_ctx ctx;
+    uint8_t last[HSH_SHA3_MAX_RATE];
+    size_t full = len / rate_bytes, tail = len % rate_bytes, pad_len;
+
+    memset(ctx.state, 0, sizeof(ctx.state));
+    ctx.rate_bytes = rate_bytes;
+    hsh_sha3_absorb_blocks(&ctx, data, full);
+
+    memcpy(last, data + full * rate_bytes, tail);
+    hsh_sha3_pad(last, tail, rate_bytes, domain, &pad_len);
+    hsh_sha3_absorb_blocks(&ctx, last, 1);
+
+    ctx.buf_len = 0;
+    hsh_sha3_squeeze(&ctx, out, out_len);
+}
+
+void hsh_sha3_224(const uint8_t *data, size_t len, uint8_t *out) {
+    hsh_sha3_oneshot(144, HSH_SHA3_DOMAIN, data, len, out, 28);
+}
+void hsh_sha3_256(const uint8_t *data, size_t len, uint8_t *out) {
+    hsh_sha3_oneshot(136, HSH_SHA3_DOMAIN, data, len, out, 32);
+}
+void hsh_sha3_384(const uint8_t *data, size_t len, uint8_t *out) {
+    hsh_sha3_oneshot(104, HSH_SHA3_DOMAIN, data, len, out, 48);
+}
+void hsh_sha3_512(const uint8_t *data, size_t len, uint8_t *out) {
+    hsh_sha3_oneshot(72, HSH_SHA3_DOMAIN, data, len, out, 64);
+}
+
+void hsh_shake128(const uint8_t *data, size_t len, uint8_t *out, size_t out_len) {
+    hsh_sha3_oneshot(168, HSH_SHAKE_DOMAIN, data, len, out, out_len);
+}
+void hsh_shake256(const uint8_t *data, size_t len, uint8_t *out, size_t out_len) {
+    hsh_sha3_oneshot(136, HSH_SHAKE_DOMAIN, data, len, out, out_len);
+}
@@ -0,0 +1,35 @@
+#include "sha3_internal.h"
+
+#if HSH_X86
+
+// Four 64-bit lanes, one per Keccak state; GCC lowers the round macro's
+// plain C operators on this type to AVX2 instructions
+typedef uint64_t hsh_sha3_v4 __attribute__((vector_size(32), aligned(8)));
+
+__attribute__((target("avx2")))
+void hsh_sha3_f_x4_avx2(uint64_t st[25][4]) {
+    hsh_sha3_v4 HSH_SHA3_LANES(a), HSH_SHA3_LANES(e);
+    hsh_sha3_v4 B0, B1, B2, B3, B4, C0, C1, C2, C3, C4, D0, D1, D2, D3, D4;
+    hsh_sha3_v4 *v = (hsh_sha3_v4 *)st;
+
+    a0 = v[0];   a1 = v[1];   a2 = v[2];   a3 = v[3];   a4 = v[4];
+    a5 = v[5];   a6 = v[6];   a7 = v[7];   a8 = v[8];   a9 = v[9];
+    a10 = v[10]; a11 = v[11]; a12 = v[12]; a13 = v[13]; a14 = v[14];
+    a15 = v[15]; a16 = v[16]; a17 = v[17]; a18 = v[18]; a19 = v[19];
+    a20 = v[20]; a21 = v[21]; a22 = v[22]; a23 = v[23]; a24 = v[24];
+    HSH_SHA3_COMPLEMENTED(a);
+
+    for (int rnd = 0; rnd < HSH_SHA3_NR; rnd += 2) {
+        HSH_SHA3_ROUND(a, e, HSH_SHA3_RC[rnd]);
+        HSH_SHA3_ROUND(e, a, HSH_SHA3_RC[rnd + 1]);
+    }
+
+    HSH_SHA3_COMPLEMENTED(a);
+    v[0] = a0;   v[1] = a1;   v[2] = a2;   v[3] = a3;   v[4] = a4;
+    v[5] = a5;   v[6] = a6;   v[7] = a7;   v[8] = a8;   v[9] = a9;
+    v[10] = a10; v[11] = a11; v[12] = a12; v[13] = a13; v[14] = a14;
+    v[15] = a15; v[16] = a16; v[17] = a17; v[18] = a18; v[19] = a19;
+    v[20] = a20; v[21] = a21; v[22] = a22; v[23] = a23; v[24] = a24;
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "sha3.h"
+#include "sha3_internal.h"
+#include "batch_internal.h"
+#include <string.h>
+
+// Multi-buffer SHA-3: with AVX2, four Keccak states are interleaved lane by
+// lane and permuted together. Each state carries its own message, fed by
+// the shared lane scheduler in batch.c.
+
+#define HSH_SHA3_BATCH_LANES 4
+
+typedef struct {
+    uint64_t st[25][HSH_SHA3_BATCH_LANES];  // st[i][k] is lane i of state k
+    hsh_sha3_ctx proto;                     // rate and output size
+} hsh_sha3_lanes;
+
+static size_t hsh_sha3_lanes_pad(void *arg, unsigned char *out, const unsigned char *tail,
+                                 size_t tail_len, uint64_t len) {
+    hsh_sha3_lanes *s = arg;
+    size_t pad_len;
+    (void)len;
+    memcpy(out, tail, tail_len);
+    hsh_sha3_pad(out, tail_len, s->proto.rate_bytes, HSH_SHA3_DOMAIN, &pad_len);
+    return 1;
+}
+
+#if HSH_X86
+static void hsh_sha3_lanes_kernel(void *arg, const unsigned char *const *blocks) {
+    hsh_sha3_lanes *s = arg;
+    size_t l, i;
+
+    for (l = 0; l < HSH_SHA3_BATCH_LANES; l++) {
+        for (i = 0; i < s->proto.rate_bytes / 8; i++) {
+            uint64_t val;
+            memcpy(&val, blocks[l] + 8 * i, 8);
+            s->st[i][l] ^= val;
+        }
+    }
+    hsh_sha3_f_x4_avx2(s->st);
+}
+#endif
+
+static void hsh_sha3_lanes_reset(void *arg, size_t lane) {
+    hsh_sha3_lanes *s = arg;
+    for (size_t i = 0; i < 25; i++) s->st[i][lane] = 0;
+}
+
+static void hsh_sha3_lanes_compress(void *arg, size_t lane, const unsigned char *data,
+                                    size_t nblocks) {
+    hsh_sha3_lanes *s = arg;
+    hsh_sha3_ctx ctx = s->proto;
+    size_t i;
+
+    if (nblocks == 0) return;
+    for (i = 0; i < 25; i++) ctx.state[i] = s->st[i][lane];
+    hsh_sha3_absorb_blocks(&ctx, data, nblocks);
+    for (i = 0; i < 25; i++) s->st[i][lane] = ctx.state[i];
+}
+
+static void hsh_sha3_lanes_store(void *arg, size_t lane, unsigned char *digest) {
+    hsh_sha3_lanes *s = arg;
+    size_t out_len = (size_t)s->proto.output_bits / 8;
+
+    for (size_t i = 0; i < out_len; i += 8) {
+        uint64_t val = s->st[i / 8][lane];
+        memcpy(digest + i, &val, (out_len - i < 8) ? out_len - i : 8);
+    }
+}
+
+static void hsh_sha3_batch(void (*init)(hsh_sha3_ctx *), const uint8_t *const *data,
+                           const size_t *lens, size_t count, uint8_t *digests) {
+    hsh_sha3_lanes s;
+    hsh_batch_engine engine = {
+        HSH_SHA3_BATCH_LANES, 0, 0, &s,
+        hsh_sha3_lanes_pad, NULL, hsh_sha3_lanes_reset,
+        hsh_sha3_lanes_compress, hsh_sha3_lanes_store,
+    };
+
+    init(&s.proto);
+    engine.block_size = s.proto.rate_bytes;
+    engine.digest_size = (size_t)s.proto.output_bits / 8;
+#if HSH_X86
+    if (hsh_cpu_features() & HSH_CPU_AVX2)
+        engine.kernel = hsh_sha3_lanes_kernel;
+#endif
+    hsh_batch_run(&engine, data, lens, count, digests);
+}
+
+void hsh_sha3_224_batch(const uint8_t *const *data, const size_t *lens, size_t count, uint8_t *digests) {
+    hsh_sha3_batch(hsh_sha3_224_init, data, lens, count, digests);
+}
+
+void hsh_sha3_256_batch(const uint8_t *const *data, const size_t *lens, size_t count, uint8_t *digests) {
+    hsh_sha3_batch(hsh_sha3_256_init, data, lens, count, digests);
+}
+
+void hsh_sha3_384_batch(const uint8_t *const *data, const size_t *lens, size_t count, uint8_t *digests) {
+    hsh_sha3_batch(hsh_sha3_384_init, data, lens, count, digests);
+}
+
+void hsh_sha3_512_batch(const uint8_t *const *data, const size_t *lens, size_t count, uint8_t *digests) {
+    hsh_sha3_batch(hsh_sha3_512_init, data, lens, count, digests);
+}
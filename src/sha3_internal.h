@@ -0,0 +1,110 @@
+#ifndef HSH_SHA3_INTERNAL_H
+#define HSH_SHA3_INTERNAL_H
+
+// Internal: Keccak pieces shared by sha3.c and the multi-lane backends.
+
+#include "sha3.h"
+#include "cpu.h"
+
+extern const uint64_t HSH_SHA3_RC[HSH_SHA3_NR];
+
+// Domain separation bytes (suffix bits plus the first pad bit)
+#define HSH_SHA3_DOMAIN  0x06
+#define HSH_SHAKE_DOMAIN 0x1F
+
+// Pad buf[msg_len..] out to a whole number of rate_bytes blocks with
+// domain ... 0x80; the pad length is stored in *pad_len_out
+void hsh_sha3_pad(uint8_t *buf, size_t msg_len, size_t rate_bytes, uint8_t domain,
+                  size_t *pad_len_out);
+
+// Absorb nblocks whole rate blocks from data into ctx->state
+void hsh_sha3_absorb_blocks(hsh_sha3_ctx *ctx, const uint8_t *data, size_t nblocks);
+
+// The round macros below expect locals B0..B4, C0..C4 and D0..D4 of the
+// lane type (uint64_t for one state, a vector type for several).
+
+// Rotate left; also valid on GCC vector types for the multi-lane kernels
+#define HSH_SHA3_ROL(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+// Lanes kept complemented inside the permutation (lane complementing):
+// with this set every chi row needs a single NOT instead of five
+#define HSH_SHA3_COMPLEMENTED(X) \
+    X##1 = ~X##1; X##2 = ~X##2; X##8 = ~X##8; \
+    X##12 = ~X##12; X##17 = ~X##17; X##20 = ~X##20
+
+// One round from lanes A0..A24 into E0..E24: theta, rho and pi with
+// compile-time offsets, chi on the complemented representation, iota
+#define HSH_SHA3_ROUND(A, E, rc) do { \
+    C0 = A##0 ^ A##5 ^ A##10 ^ A##15 ^ A##20; \
+    C1 = A##1 ^ A##6 ^ A##11 ^ A##16 ^ A##21; \
+    C2 = A##2 ^ A##7 ^ A##12 ^ A##17 ^ A##22; \
+    C3 = A##3 ^ A##8 ^ A##13 ^ A##18 ^ A##23; \
+    C4 = A##4 ^ A##9 ^ A##14 ^ A##19 ^ A##24; \
+    D0 = C4 ^ HSH_SHA3_ROL(C1, 1); \
+    D1 = C0 ^ HSH_SHA3_ROL(C2, 1); \
+    D2 = C1 ^ HSH_SHA3_ROL(C3, 1); \
+    D3 = C2 ^ HSH_SHA3_ROL(C4, 1); \
+    D4 = C3 ^ HSH_SHA3_ROL(C0, 1); \
+    B0 = A##0 ^ D0; \
+    B1 = HSH_SHA3_ROL(A##6 ^ D1, 44); \
+    B2 = HSH_SHA3_ROL(A##12 ^ D2, 43); \
+    B3 = HSH_SHA3_ROL(A##18 ^ D3, 21); \
+    B4 = HSH_SHA3_ROL(A##24 ^ D4, 14); \
+    E##0 = B0 ^ (B1 | B2) ^ (rc); \
+    E##1 = B1 ^ (~B2 | B3); \
+    E##2 = B2 ^ (B3 & B4); \
+    E##3 = B3 ^ (B4 | B0); \
+    E##4 = B4 ^ (B0 & B1); \
+    B0 = HSH_SHA3_ROL(A##3 ^ D3, 28); \
+    B1 = HSH_SHA3_ROL(A##9 ^ D4, 20); \
+    B2 = HSH_SHA3_ROL(A##10 ^ D0, 3); \
+    B3 = HSH_SHA3_ROL(A##16 ^ D1, 45); \
+    B4 = HSH_SHA3_ROL(A##22 ^ D2, 61); \
+    E##5 = B0 ^ (B1 | B2); \
+    E##6 = B1 ^ (B2 & B3); \
+    E##7 = B2 ^ (B3 | ~B4); \
+    E##8 = B3 ^ (B4 | B0); \
+    E##9 = B4 ^ (B0 & B1); \
+    B0 = HSH_SHA3_ROL(A##1 ^ D1, 1); \
+    B1 = HSH_SHA3_ROL(A##7 ^ D2, 6); \
+    B2 = HSH_SHA3_ROL(A##13 ^ D3, 25); \
+    B3 = HSH_SHA3_ROL(A##19 ^ D4, 8); \
+    B4 = HSH_SHA3_ROL(A##20 ^ D0, 18); \
+    E##10 = B0 ^ (B1 | B2); \
+    E##11 = B1 ^ (B2 & B3); \
+    E##12 = B2 ^ (~B3 & B4); \
+    E##13 = ~B3 ^ (B4 | B0); \
+    E##14 = B4 ^ (B0 & B1); \
+    B0 = HSH_SHA3_ROL(A##4 ^ D4, 27); \
+    B1 = HSH_SHA3_ROL(A##5 ^ D0, 36); \
+    B2 = HSH_SHA3_ROL(A##11 ^ D1, 10); \
+    B3 = HSH_SHA3_ROL(A##17 ^ D2, 15); \
+    B4 = HSH_SHA3_ROL(A##23 ^ D3, 56); \
+    E##15 = B0 ^ (B1 & B2); \
+    E##16 = B1 ^ (B2 | B3); \
+    E##17 = B2 ^ (~B3 | B4); \
+    E##18 = ~B3 ^ (B4 & B0); \
+    E##19 = B4 ^ (B0 | B1); \
+    B0 = HSH_SHA3_ROL(A##2 ^ D2, 62); \
+    B1 = HSH_SHA3_ROL(A##8 ^ D3, 55); \
+    B2 = HSH_SHA3_ROL(A##14 ^ D4, 39); \
+    B3 = HSH_SHA3_ROL(A##15 ^ D0, 41); \
+    B4 = HSH_SHA3_ROL(A##21 ^ D1, 2); \
+    E##20 = B0 ^ (~B1 & B2); \
+    E##21 = ~B1 ^ (B2 | B3); \
+    E##22 = B2 ^ (B3 & B4); \
+    E##23 = B3 ^ (B4 | B0); \
+    E##24 = B4 ^ (B0 & B1); \
+} while (0)
+
+#define HSH_SHA3_LANES(X) \
+    X##0, X##1, X##2, X##3, X##4, X##5, X##6, X##7, X##8, X##9, \
+    X##10, X##11, X##12, X##13, X##14, X##15, X##16, X##17, X##18, X##19, \
+    X##20, X##21, X##22, X##23, X##24
+
+#if HSH_X86
+// Keccak-f[1600] on 4 interleaved states: st[i][k] is lane i of state k
+void hsh_sha3_f_x4_avx2(uint64_t st[25][4]);
+#endif
+
+#endif
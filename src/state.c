@@ -0,0 +1,337 @@
+#include "state.h"
+#include <string.h>
+
+/* ============================================
+ * Little-endian field encoding
+ * ============================================ */
+
+static uint8_t *hsh_state_put8(uint8_t *p, uint8_t v)
+{
+    *p = v;
+    return p + 1;
+}
+
+static uint8_t *hsh_state_put32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+    return p + 4;
+}
+
+static uint8_t *hsh_state_put64(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+    return p + 8;
+}
+
+/* n bytes of src, zero-filled up to size */
+static uint8_t *hsh_state_put_bytes(uint8_t *p, const uint8_t *src, size_t n, size_t size)
+{
+    memcpy(p, src, n);
+    memset(p + n, 0, size - n);
+    return p + size;
+}
+
+static uint8_t hsh_state_get8(const uint8_t **p)
+{
+    return *(*p)++;
+}
+
+static uint32_t hsh_state_get32(const uint8_t **p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t)(*p)[i] << (8 * i);
+    *p += 4;
+    return v;
+}
+
+static uint64_t hsh_state_get64(const uint8_t **p)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t)(*p)[i] << (8 * i);
+    *p += 8;
+    return v;
+}
+
+static uint8_t *hsh_state_header(uint8_t *p, uint8_t type)
+{
+    p[0] = 'h';
+    p[1] = 's';
+    p[2] = HSH_STATE_VERSION;
+    p[3] = type;
+    return p + 4;
+}
+
+/* Payload of a snapshot of the given type and size, or NULL */
+static const uint8_t *hsh_state_payload(const uint8_t *in, size_t len, uint8_t type, size_t size)
+{
+    if (len != size) return NULL;
+    if (in[0] != 'h' || in[1] != 's' || in[2] != HSH_STATE_VERSION || in[3] != type)
+        return NULL;
+    return in + 4;
+}
+
+/* ============================================
+ * MD5
+ * ============================================ */
+
+void hsh_md5_serialize(const hsh_md5_ctx *ctx, uint8_t out[HSH_STATE_SIZE_MD5])
+{
+    uint8_t *p = hsh_state_header(out, HSH_STATE_MD5);
+    p = hsh_state_put32(p, ctx->A);
+    p = hsh_state_put32(p, ctx->B);
+    p = hsh_state_put32(p, ctx->C);
+    p = hsh_state_put32(p, ctx->D);
+    p = hsh_state_put64(p, ctx->counter);
+    p = hsh_state_put8(p, (uint8_t)ctx->buffer_len);
+    hsh_state_put_bytes(p, ctx->buffer, ctx->buffer_len, 64);
+}
+
+int hsh_md5_deserialize(hsh_md5_ctx *ctx, const uint8_t *in, size_t len)
+{
+    const uint8_t *p = hsh_state_payload(in, len, HSH_STATE_MD5, HSH_STATE_SIZE_MD5);
+    hsh_md5_ctx tmp;
+
+    if (!p) return -1;
+    tmp.A = hsh_state_get32(&p);
+    tmp.B = hsh_state_get32(&p);
+    tmp.C = hsh_state_get32(&p);
+    tmp.D = hsh_state_get32(&p);
+    tmp.counter = hsh_state_get64(&p);
+    tmp.buffer_len = hsh_state_get8(&p);
+
+    /* The buffer always holds the message length mod 64 bytes */
+    if (tmp.counter % 8 != 0 || tmp.buffer_len != (tmp.counter / 8) % 64) return -1;
+
+    memcpy(tmp.buffer, p, sizeof(tmp.buffer));
+    *ctx = tmp;
+    return 0;
+}
+
+/* ============================================
+ * SHA-1
+ * ============================================ */
+
+void hsh_sha1_serialize(const hsh_sha1_ctx *ctx, uint8_t out[HSH_STATE_SIZE_SHA1])
+{
+    uint8_t *p = hsh_state_header(out, HSH_STATE_SHA1);
+    for (int i = 0; i < 5; i++)
+        p = hsh_state_put32(p, ctx->h[i]);
+    p = hsh_state_put64(p, ctx->message_byte_length);
+    p = hsh_state_put8(p, (uint8_t)ctx->unprocessed_len);
+    hsh_state_put_bytes(p, ctx->unprocessed, ctx->unprocessed_len, HSH_SHA1_BLOCK_SIZE);
+}
+
+int hsh_sha1_deserialize(hsh_sha1_ctx *ctx, const uint8_t *in, size_t len)
+{
+    const uint8_t *p = hsh_state_payload(in, len, HSH_STATE_SHA1, HSH_STATE_SIZE_SHA1);
+    hsh_sha1_ctx tmp;
+
+    if (!p) return -1;
+    for (int i = 0; i < 5; i++)
+        tmp.h[i] = hsh_state_get32(&p);
+    tmp.message_byte_length = hsh_state_get64(&p);
+    tmp.unprocessed_len = hsh_state_get8(&p);
+    if (tmp.unprocessed_len != tmp.message_byte_length % HSH_SHA1_BLOCK_SIZE) return -1;
+
+    memcpy(tmp.unprocessed, p, sizeof(tmp.unprocessed));
+    *ctx = tmp;
+    return 0;
+}
+
+/* ============================================
+ * SHA-2
+ * ============================================ */
+
+void hsh_sha2_256_serialize(const hsh_sha2_256_ctx *ctx, uint8_t out[HSH_STATE_SIZE_SHA2_256])
+{
+    uint8_t *p = hsh_state_header(out, HSH_STATE_SHA2_256);
+    for (int i = 0; i < 8; i++)
+        p = hsh_state_put32(p, ctx->h[i]);
+    p = hsh_state_put64(p, ctx->counter);
+    p = hsh_state_put8(p, (uint8_t)ctx->buffer_size);
+    hsh_state_put_bytes(p, ctx->buffer, ctx->buffer_size, 64);
+}
+
+int hsh_sha2_256_deserialize(hsh_sha2_256_ctx *ctx, const uint8_t *in, size_t len)
+{
+    const uint8_t *p = hsh_state_payload(in, len, HSH_STATE_SHA2_256, HSH_STATE_SIZE_SHA2_256);
+    hsh_sha2_256_ctx tmp;
+
+    if (!p) return -1;
+    for (int i = 0; i < 8; i++)
+        tmp.h[i] = hsh_state_get32(&p);
+    tmp.counter = hsh_state_get64(&p);
+    tmp.buffer_size = hsh_state_get8(&p);
+    if (tmp.counter % 8 != 0 || tmp.buffer_size != (tmp.counter / 8) % 64) return -1;
+
+    memcpy(tmp.buffer, p, sizeof(tmp.buffer));
+    *ctx = tmp;
+    return 0;
+}
+
+void hsh_sha2_512_serialize(const hsh_sha2_512_ctx *ctx, uint8_t out[HSH_STATE_SIZE_SHA2_512])
+{
+    uint8_t *p = hsh_state_header(out, HSH_STATE_SHA2_512);
+    for (int i = 0; i < 8; i++)
+        p = hsh_state_put64(p, ctx->h[i]);
+    p = hsh_state_put64(p, ctx->counter);
+    p = hsh_state_put8(p, (uint8_t)ctx->buffer_size);
+    hsh_state_put_bytes(p, ctx->buffer, ctx->buffer_size, 128);
+}
+
+int hsh_sha2_512_deserialize(hsh_sha2_512_ctx *ctx, const uint8_t *in, size_t len)
+{
+    const uint8_t *p = hsh_state_payload(in, len, HSH_STATE_SHA2_512, HSH_STATE_SIZE_SHA2_512);
+    hsh_sha2_512_ctx tmp;
+
+    if (!p) return -1;
+    for (int i = 0; i < 8; i++)
+        tmp.h[i] = hsh_state_get64(&p);
+    tmp.counter = hsh_state_get64(&p);
+    tmp.buffer_size = hsh_state_get8(&p);
+    if (tmp.counter % 8 != 0 || tmp.buffer_size != (tmp.counter / 8) % 128) return -1;
+
+    memcpy(tmp.buffer, p, sizeof(tmp.buffer));
+    *ctx = tmp;
+    return 0;
+}
+
+/* ============================================
+ * SHA-3 / SHAKE
+ * ============================================ */
+
+void hsh_sha3_serialize(const hsh_sha3_ctx *ctx, uint8_t out[HSH_STATE_SIZE_SHA3])
+{
+    uint8_t *p = hsh_state_header(out, HSH_STATE_SHA3);
+    for (int i = 0; i < HSH_SHA3_STATE_SIZE; i++)
+        p = hsh_state_put64(p, ctx->state[i]);
+    p = hsh_state_put8(p, (uint8_t)ctx->rate_bytes);
+    p = hsh_state_put32(p, (uint32_t)ctx->output_bits);
+    p = hsh_state_put8(p, (uint8_t)ctx->finalized);
+    p = hsh_state_put8(p, (uint8_t)ctx->buf_len);
+    /* Once squeezing, buf_len is a read cursor and buf holds nothing */
+    hsh_state_put_bytes(p, ctx->buf, ctx->finalized ? 0 : ctx->buf_len, HSH_SHA3_MAX_RATE);
+}
+
+int hsh_sha3_deserialize(hsh_sha3_ctx *ctx, const uint8_t *in, size_t len)
+{
+    const uint8_t *p = hsh_state_payload(in, len, HSH_STATE_SHA3, HSH_STATE_SIZE_SHA3);
+    hsh_sha3_ctx tmp;
+
+    if (!p) return -1;
+    for (int i = 0; i < HSH_SHA3_STATE_SIZE; i++)
+        tmp.state[i] = hsh_state_get64(&p);
+    tmp.rate_bytes = hsh_state_get8(&p);
+    uint32_t output_bits = hsh_state_get32(&p);
+    tmp.finalized = hsh_state_get8(&p);
+    tmp.buf_len = hsh_state_get8(&p);
+
+    /* SHA3-n has rate 200 - n/4 bytes; SHAKE128/256 (no output size)
+     * have 168 / 136 */
+    if (output_bits == 224 || output_bits == 256 || output_bits == 384 || output_bits == 512) {
+        if (tmp.rate_bytes != 200 - output_bits / 4) return -1;
+    } else if (output_bits == 0) {
+        if (tmp.rate_bytes != 168 && tmp.rate_bytes != 136) return -1;
+    } else {
+        return -1;
+    }
+    if (tmp.finalized > 1) return -1;
+    if (tmp.finalized ? tmp.buf_len > tmp.rate_bytes : tmp.buf_len >= tmp.rate_bytes) return -1;
+
+    tmp.output_bits = (int)output_bits;
+    tmp.capacity_bits = (int)(1600 - 8 * tmp.rate_bytes);
+    memcpy(tmp.buf, p, sizeof(tmp.buf));
+    *ctx = tmp;
+    return 0;
+}
+
+/* ============================================
+ * BLAKE2
+ * ============================================ */
+
+void hsh_blake2b_serialize(const hsh_blake2b_ctx *ctx, uint8_t out[HSH_STATE_SIZE_BLAKE2B])
+{
+    uint8_t *p = hsh_state_header(out, HSH_STATE_BLAKE2B);
+    for (int i = 0; i < 8; i++)
+        p = hsh_state_put64(p, ctx->h[i]);
+    p = hsh_state_put64(p, ctx->t_low);
+    p = hsh_state_put64(p, ctx->t_high);
+    p = hsh_state_put8(p, (uint8_t)ctx->buffer_len);
+    p = hsh_state_put8(p, (uint8_t)ctx->digest_size);
+    p = hsh_state_put8(p, (uint8_t)ctx->key_pending);
+    for (int i = 0; i < 8; i++)
+        p = hsh_state_put64(p, ctx->key_pending ? ctx->key_h[i] : 0);
+    hsh_state_put_bytes(p, ctx->buffer, ctx->buffer_len, 128);
+}
+
+int hsh_blake2b_deserialize(hsh_blake2b_ctx *ctx, const uint8_t *in, size_t len)
+{
+    const uint8_t *p = hsh_state_payload(in, len, HSH_STATE_BLAKE2B, HSH_STATE_SIZE_BLAKE2B);
+    hsh_blake2b_ctx tmp;
+
+    if (!p) return -1;
+    for (int i = 0; i < 8; i++)
+        tmp.h[i] = hsh_state_get64(&p);
+    tmp.t_low = hsh_state_get64(&p);
+    tmp.t_high = hsh_state_get64(&p);
+    tmp.buffer_len = hsh_state_get8(&p);
+    tmp.digest_size = hsh_state_get8(&p);
+    tmp.key_pending = hsh_state_get8(&p);
+    for (int i = 0; i < 8; i++)
+        tmp.key_h[i] = hsh_state_get64(&p);
+
+    if (tmp.buffer_len > 128 || tmp.digest_size == 0 || tmp.digest_size > 64) return -1;
+    /* The last block is always held back, and a pending key block is the
+     * only thing absorbed so far */
+    if ((tmp.t_low != 0 || tmp.t_high != 0) && tmp.buffer_len == 0) return -1;
+    if (tmp.key_pending > 1) return -1;
+    if (tmp.key_pending && (tmp.t_low != 0 || tmp.t_high != 0 || tmp.buffer_len != 128))
+        return -1;
+
+    memcpy(tmp.buffer, p, sizeof(tmp.buffer));
+    *ctx = tmp;
+    return 0;
+}
+
+void hsh_blake2s_serialize(const hsh_blake2s_ctx *ctx, uint8_t out[HSH_STATE_SIZE_BLAKE2S])
+{
+    uint8_t *p = hsh_state_header(out, HSH_STATE_BLAKE2S);
+    for (int i = 0; i < 8; i++)
+        p = hsh_state_put32(p, ctx->h[i]);
+    p = hsh_state_put64(p, ctx->t);
+    p = hsh_state_put8(p, (uint8_t)ctx->buffer_len);
+    p = hsh_state_put8(p, (uint8_t)ctx->digest_size);
+    p = hsh_state_put8(p, (uint8_t)ctx->key_pending);
+    for (int i = 0; i < 8; i++)
+        p = hsh_state_put32(p, ctx->key_pending ? ctx->key_h[i] : 0);
+    hsh_state_put_bytes(p, ctx->buffer, ctx->buffer_len, 64);
+}
+
+int hsh_blake2s_deserialize(hsh_blake2s_ctx *ctx, const uint8_t *in, size_t len)
+{
+    const uint8_t *p = hsh_state_payload(in, len, HSH_STATE_BLAKE2S, HSH_STATE_SIZE_BLAKE2S);
+    hsh_blake2s_ctx tmp;
+
+    if (!p) return -1;
+    for (int i = 0; i < 8; i++)
+        tmp.h[i] = hsh_state_get32(&p);
+    tmp.t = hsh_state_get64(&p);
+    tmp.buffer_len = hsh_state_get8(&p);
+    tmp.digest_size = hsh_state_get8(&p);
+    tmp.key_pending = hsh_state_get8(&p);
+    for (int i = 0; i < 8; i++)
+        tmp.key_h[i] = hsh_state_get32(&p);
+
+    if (tmp.buffer_len > 64 || tmp.digest_size == 0 || tmp.digest_size > 32) return -1;
+    if (tmp.t != 0 && tmp.buffer_len == 0) return -1;
+    if (tmp.key_pending > 1) return -1;
+    if (tmp.key_pending && (tmp.t != 0 || tmp.buffer_len != 64)) return -1;
+
+    memcpy(tmp.buffer, p, sizeof(tmp.buffer));
+    *ctx = tmp;
+    return 0;
+}
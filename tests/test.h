@@ -0,0 +1,45 @@
+#ifndef HSH_TEST_H
+#define HSH_TEST_H
+
+/* Tiny test harness shared by the files in tests/ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+extern size_t hsh_test_checks;
+extern size_t hsh_test_failures;
+
+/* Records one check; prints what failed with a printf-style label */
+#define HSH_CHECK(cond, ...)                                                  \
+    do {                                                                      \
+        hsh_test_checks++;                                                    \
+        if (!(cond)) {                                                        \
+            hsh_test_failures++;                                              \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);              \
+            fprintf(stderr, __VA_ARGS__);                                     \
+            fputc('\n', stderr);                                              \
+        }                                                                     \
+    } while (0)
+
+/* Compares got[0..len) with the hex string want and reports a mismatch
+ * under label. Returns 1 if equal. */
+int hsh_test_hex(const char *label, const uint8_t *got, size_t len, const char *want);
+
+/* Compares two buffers and reports a mismatch under label */
+int hsh_test_same(const char *label, const uint8_t *got, const uint8_t *want, size_t len);
+
+/* Deterministic pseudo-random bytes: the same (seed, len) always gives the
+ * same output. Returns a malloc()ed buffer (aborts on failure). */
+uint8_t *hsh_test_data(uint64_t seed, size_t len);
+
+/* Test groups, one per file */
+void hsh_test_vectors(void);
+void hsh_test_mac(void);
+void hsh_test_stream(void);
+void hsh_test_batch(void);
+void hsh_test_state(void);
+void hsh_test_merkle(void);
+void hsh_test_cdc(void);
+
+#endif /* HSH_TEST_H */
@@ -0,0 +1,71 @@
+/*
+ * Batch APIs against the scalar one-shot functions. Message lengths mix
+ * the padding edge cases of each block size with long messages, so lanes
+ * finish at different times and get refilled, and the counts cover both
+ * fewer messages than lanes and several full rounds of them.
+ */
+
+#include "test.h"
+#include "md5.h"
+#include "sha2.h"
+#include "sha3.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HSH_TEST_BATCH_MAX 40
+
+typedef struct {
+    const char *name;
+    size_t block_size;
+    size_t digest_size;
+    void (*batch)(const uint8_t *const *, const size_t *, size_t, uint8_t *);
+    void (*oneshot)(const uint8_t *, size_t, uint8_t *);
+} hsh_test_batch_alg;
+
+static const hsh_test_batch_alg hsh_test_batch_algs[] = {
+    {"md5", 64, 16, hsh_md5_batch, hsh_md5},
+    {"sha224", 64, 28, hsh_sha2_224_batch, hsh_sha2_224},
+    {"sha256", 64, 32, hsh_sha2_256_batch, hsh_sha2_256},
+    {"sha384", 128, 48, hsh_sha2_384_batch, hsh_sha2_384},
+    {"sha512", 128, 64, hsh_sha2_512_batch, hsh_sha2_512},
+    {"sha3-224", 144, 28, hsh_sha3_224_batch, hsh_sha3_224},
+    {"sha3-256", 136, 32, hsh_sha3_256_batch, hsh_sha3_256},
+    {"sha3-384", 104, 48, hsh_sha3_384_batch, hsh_sha3_384},
+    {"sha3-512", 72, 64, hsh_sha3_512_batch, hsh_sha3_512},
+};
+
+static void hsh_test_batch_alg_run(const hsh_test_batch_alg *alg, const uint8_t *data) {
+    const size_t b = alg->block_size;
+    const size_t shapes[] = {0, 1, b - 17, b - 16, b - 9, b - 8, b - 1, b, b + 1,
+                             2 * b - 9, 2 * b + 17, 5 * b + 3, 1000, 65536};
+    const size_t nshapes = sizeof(shapes) / sizeof(shapes[0]);
+    const uint8_t *msgs[HSH_TEST_BATCH_MAX] = {0};
+    size_t lens[HSH_TEST_BATCH_MAX] = {0};
+    uint8_t digests[HSH_TEST_BATCH_MAX * 64 + 1], want[64];
+    char label[64];
+
+    for (size_t count = 0; count <= HSH_TEST_BATCH_MAX; count++) {
+        for (size_t i = 0; i < count; i++) {
+            lens[i] = shapes[(i * 5 + count) % nshapes];
+            msgs[i] = data + (i * 13) % 64;  /* odd alignments */
+        }
+        memset(digests, 0xee, sizeof(digests));
+        alg->batch(msgs, lens, count, digests);
+        for (size_t i = 0; i < count; i++) {
+            snprintf(label, sizeof(label), "%s batch of %zu, message %zu (%zu bytes)",
+                     alg->name, count, i, lens[i]);
+            alg->oneshot(msgs[i], lens[i], want);
+            hsh_test_same(label, digests + i * alg->digest_size, want, alg->digest_size);
+        }
+        HSH_CHECK(digests[count * alg->digest_size] == 0xee, "%s batch of %zu wrote past the end",
+                  alg->name, count);
+    }
+}
+
+void hsh_test_batch(void) {
+    uint8_t *data = hsh_test_data(11, 65536 + 64);
+
+    for (size_t i = 0; i < sizeof(hsh_test_batch_algs) / sizeof(hsh_test_batch_algs[0]); i++)
+        hsh_test_batch_alg_run(&hsh_test_batch_algs[i], data);
+    free(data);
+}
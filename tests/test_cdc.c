@@ -0,0 +1,180 @@
+/*
+ * Content-defined chunking: chunk boundaries must not depend on how the
+ * input is split into update() calls, every chunk must respect the size
+ * limits and carry the digest of its bytes, an insertion must only
+ * disturb the chunks around it, and the cut points of a fixed input are
+ * pinned, since they are part of the chunking format.
+ */
+
+#include "test.h"
+#include "cdc.h"
+#include "blake2.h"
+#include "sha2.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HSH_TEST_CDC_LEN   (1024 * 1024 + 4321)
+#define HSH_TEST_CDC_MAX   4096
+
+typedef struct {
+    hsh_cdc_chunk chunks[HSH_TEST_CDC_MAX];
+    size_t count;
+    const uint8_t *input;     /* whole stream, to check the data pointers */
+    size_t bad_data;
+} hsh_test_cdc_list;
+
+static void hsh_test_cdc_emit(void *arg, const hsh_cdc_chunk *chunk, const uint8_t *data) {
+    hsh_test_cdc_list *list = arg;
+
+    if (memcmp(data, list->input + chunk->offset, chunk->length) != 0) list->bad_data++;
+    if (list->count < HSH_TEST_CDC_MAX) list->chunks[list->count] = *chunk;
+    list->count++;
+}
+
+/* Chunks data[0..len) with update() calls of the sizes in pieces, cycling */
+static void hsh_test_cdc_run(const hsh_cdc_params *params, const uint8_t *data, size_t len,
+                             const size_t *pieces, size_t npieces, hsh_test_cdc_list *list) {
+    hsh_cdc_ctx ctx;
+
+    list->count = 0;
+    list->input = data;
+    list->bad_data = 0;
+    HSH_CHECK(hsh_cdc_init(&ctx, params, hsh_test_cdc_emit, list) == 0, "cdc init");
+    for (size_t pos = 0, k = 0; pos < len; k++) {
+        size_t n = pieces[k % npieces] < len - pos ? pieces[k % npieces] : len - pos;
+        hsh_cdc_update(&ctx, data + pos, n);
+        pos += n;
+    }
+    hsh_cdc_finalize(&ctx);
+}
+
+static void hsh_test_cdc_check(const hsh_cdc_params *params, const uint8_t *data, size_t len,
+                               const hsh_test_cdc_list *list, const char *label) {
+    uint8_t digest[HSH_CDC_DIGEST_SIZE];
+    uint64_t offset = 0;
+    size_t bad = 0;
+
+    HSH_CHECK(list->count <= HSH_TEST_CDC_MAX, "%s: too many chunks", label);
+    HSH_CHECK(list->bad_data == 0, "%s: %zu chunks passed wrong data", label, list->bad_data);
+    for (size_t i = 0; i < list->count && i < HSH_TEST_CDC_MAX; i++) {
+        const hsh_cdc_chunk *c = &list->chunks[i];
+        int last = i + 1 == list->count;
+
+        if (c->offset != offset || c->length > params->max_size || c->length == 0 ||
+            (!last && c->length < params->min_size)) {
+            bad++;
+            continue;
+        }
+        if (params->digest == HSH_CDC_SHA256)
+            hsh_sha2_256(data + c->offset, c->length, digest);
+        else
+            hsh_blake2b(data + c->offset, c->length, digest, HSH_CDC_DIGEST_SIZE, NULL, 0);
+        if (memcmp(digest, c->digest, sizeof(digest)) != 0) bad++;
+        offset += c->length;
+    }
+    HSH_CHECK(bad == 0 && offset == len, "%s: %zu bad chunks, %llu of %zu bytes covered", label,
+              bad, (unsigned long long)offset, len);
+}
+
+static int hsh_test_cdc_same(const hsh_test_cdc_list *a, const hsh_test_cdc_list *b) {
+    if (a->count != b->count) return 0;
+    for (size_t i = 0; i < a->count && i < HSH_TEST_CDC_MAX; i++) {
+        if (a->chunks[i].offset != b->chunks[i].offset || a->chunks[i].length != b->chunks[i].length ||
+            memcmp(a->chunks[i].digest, b->chunks[i].digest, HSH_CDC_DIGEST_SIZE) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+static void hsh_test_cdc_params(void) {
+    hsh_cdc_params bad[] = {
+        {32, 256, 1024, HSH_CDC_SHA256},              /* min below the limit */
+        {512, 256, 1024, HSH_CDC_SHA256},             /* min above avg */
+        {64, 2048, 1024, HSH_CDC_SHA256},             /* avg above max */
+        {64, 256, HSH_CDC_MAX_LIMIT + 1, HSH_CDC_SHA256},
+        {64, 256, 1024, (hsh_cdc_digest)7},
+    };
+    hsh_cdc_ctx ctx;
+
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+        HSH_CHECK(hsh_cdc_init(&ctx, &bad[i], hsh_test_cdc_emit, NULL) == -1,
+                  "cdc parameters %zu accepted", i);
+}
+
+void hsh_test_cdc(void) {
+    static const hsh_cdc_params params[] = {
+        {2048, 8192, 65536, HSH_CDC_SHA256},
+        {64, 256, 1024, HSH_CDC_BLAKE2B_256},
+    };
+    /* First chunk lengths of hsh_test_data(61, ...) under params[0] */
+    static const size_t pinned[] = {10274, 7105, 9389, 9083, 15785, 8349, 3664, 2439, 17587, 8532};
+    static const size_t whole[] = {HSH_TEST_CDC_LEN};
+    static const size_t split_a[] = {1, 4095, 4096, 4097, 100003};
+    static const size_t split_b[] = {65536};
+    static const size_t split_c[] = {7, 1, 300, 2049};
+    hsh_test_cdc_list *a = malloc(sizeof(*a)), *b = malloc(sizeof(*b));
+    uint8_t *data = hsh_test_data(61, HSH_TEST_CDC_LEN + 100);
+    char label[64];
+
+    if (!a || !b) abort();
+    hsh_test_cdc_params();
+
+    for (size_t p = 0; p < sizeof(params) / sizeof(params[0]); p++) {
+        const size_t len = p == 0 ? HSH_TEST_CDC_LEN : HSH_TEST_CDC_LEN / 4;
+
+        snprintf(label, sizeof(label), "cdc params %zu, one update", p);
+        hsh_test_cdc_run(&params[p], data, len, whole, 1, a);
+        hsh_test_cdc_check(&params[p], data, len, a, label);
+
+        snprintf(label, sizeof(label), "cdc params %zu, uneven updates", p);
+        hsh_test_cdc_run(&params[p], data, len, split_a, 5, b);
+        hsh_test_cdc_check(&params[p], data, len, b, label);
+        HSH_CHECK(hsh_test_cdc_same(a, b), "%s: boundaries moved", label);
+
+        snprintf(label, sizeof(label), "cdc params %zu, 64 KiB updates", p);
+        hsh_test_cdc_run(&params[p], data, len, split_b, 1, b);
+        HSH_CHECK(hsh_test_cdc_same(a, b), "%s: boundaries moved", label);
+
+        snprintf(label, sizeof(label), "cdc params %zu, small updates", p);
+        hsh_test_cdc_run(&params[p], data, len, split_c, 4, b);
+        HSH_CHECK(hsh_test_cdc_same(a, b), "%s: boundaries moved", label);
+
+        if (p == 0) {
+            for (size_t i = 0; i < sizeof(pinned) / sizeof(pinned[0]); i++)
+                HSH_CHECK(i < a->count && a->chunks[i].length == pinned[i],
+                          "cdc chunk %zu is %zu bytes, expected %zu", i,
+                          i < a->count ? a->chunks[i].length : 0, pinned[i]);
+        }
+    }
+
+    /* 100 bytes inserted in the middle: chunks away from the edit keep
+     * their digests */
+    {
+        uint8_t *edited = malloc(HSH_TEST_CDC_LEN + 100);
+        size_t kept = 0;
+
+        if (!edited) abort();
+        memcpy(edited, data, HSH_TEST_CDC_LEN / 2);
+        memset(edited + HSH_TEST_CDC_LEN / 2, 'x', 100);
+        memcpy(edited + HSH_TEST_CDC_LEN / 2 + 100, data + HSH_TEST_CDC_LEN / 2,
+               HSH_TEST_CDC_LEN - HSH_TEST_CDC_LEN / 2);
+        hsh_test_cdc_run(&params[0], data, HSH_TEST_CDC_LEN, whole, 1, a);
+        hsh_test_cdc_run(&params[0], edited, HSH_TEST_CDC_LEN + 100, whole, 1, b);
+        hsh_test_cdc_check(&params[0], edited, HSH_TEST_CDC_LEN + 100, b, "cdc after an insertion");
+        for (size_t i = 0; i < a->count && i < HSH_TEST_CDC_MAX; i++) {
+            for (size_t j = 0; j < b->count && j < HSH_TEST_CDC_MAX; j++) {
+                if (memcmp(a->chunks[i].digest, b->chunks[j].digest, HSH_CDC_DIGEST_SIZE) == 0) {
+                    kept++;
+                    break;
+                }
+            }
+        }
+        HSH_CHECK(kept + 3 >= a->count, "cdc insertion changed %zu of %zu chunks",
+                  a->count - kept, a->count);
+        free(edited);
+    }
+
+    free(data);
+    free(a);
+    free(b);
+}
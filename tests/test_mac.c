@@ -0,0 +1,409 @@
+/*
+ * Keyed hashing: HMAC (RFC 2202 for SHA-1, RFC 4231 for SHA-2), keyed and
+ * personalized BLAKE2 (the reference KAT key 00 01 02 ... over messages
+ * 00 01 02 ...), and BLAKE3 hash / keyed_hash / derive_key with extended
+ * output over the 0, 1, ..., 250, 0, 1, ... input of the reference vectors.
+ */
+
+#include "test.h"
+#include "hmac.h"
+#include "blake2.h"
+#include "blake3.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ==== HMAC ==== */
+
+/*
+ * RFC 4231 test cases 1-7, then RFC 2202 cases 6 and 7 (whose 80-byte key
+ * differs from RFC 4231); RFC 2202 cases 1-5 share the inputs of RFC 4231.
+ * A key or message given as NULL is len bytes of fill, or 0x01, 0x02, ...
+ * for the key fill 0x01. Case 5 is truncated to 128 bits for SHA-2.
+ */
+static const struct {
+    uint8_t key_fill;
+    size_t key_len;
+    const char *key;
+    uint8_t data_fill;
+    size_t data_len;
+    const char *data;
+    const char *sha1, *sha224, *sha256, *sha384, *sha512;
+} hsh_test_hmac_cases[] = {
+    {0x0b, 20, NULL, 0, 8, "Hi There",
+     "b617318655057264e28bc0b6fb378c8ef146be00",
+     "896fb1128abbdf196832107cd49df33f47b4b1169912ba4f53684b22",
+     "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7",
+     "afd03944d84895626b0825f4ab46907f15f9dadbe4101ec682aa034c7cebc59cfaea9ea9076ede7f4af152e8b2fa9cb6",
+     "87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cdedaa833b7d6b8a702038b274eaea3f4e4be9d914eeb61f1702e696c203a126854"},
+    {0, 4, "Jefe", 0, 28, "what do ya want for nothing?",
+     "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79",
+     "a30e01098bc6dbbf45690f3a7e9e6d0f8bbea2a39e6148008fd05e44",
+     "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843",
+     "af45d2e376484031617f78d2b58a6b1b9c7ef464f5a01b47e42ec3736322445e8e2240ca5e69e2c78b3239ecfab21649",
+     "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea2505549758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737"},
+    {0xaa, 20, NULL, 0xdd, 50, NULL,
+     "125d7342b9ac11cd91a39af48aa17b4f63f175d3",
+     "7fb3cb3588c6c1f6ffa9694d7d6ad2649365b0c1f65d69d1ec8333ea",
+     "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe",
+     "88062608d3e6ad8a0aa2ace014c8a86f0aa635d947ac9febe83ef4e55966144b2a5ab39dc13814b94e3ab6e101a34f27",
+     "fa73b0089d56a284efb0f0756c890be9b1b5dbdd8ee81a3655f83e33b2279d39bf3e848279a722c806b485a47e67c807b946a337bee8942674278859e13292fb"},
+    {0x01, 25, NULL, 0xcd, 50, NULL,
+     "4c9007f4026250c6bc8414f9bf50c86c2d7235da",
+     "6c11506874013cac6a2abc1bb382627cec6a90d86efc012de7afec5a",
+     "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b",
+     "3e8a69b7783c25851933ab6290af6ca77a9981480850009cc5577c6e1f573b4e6801dd23c4a7d679ccf8a386c674cffb",
+     "b0ba465637458c6990e5a8c5f61d4af7e576d97ff94b872de76f8050361ee3dba91ca5c11aa25eb4d679275cc5788063a5f19741120c4f2de2adebeb10a298dd"},
+    {0x0c, 20, NULL, 0, 20, "Test With Truncation",
+     "4c1a03424b55e07fe7f27be1d58bb9324a9a5a04",
+     "0e2aea68a90c8d37c988bcdb9fca6fa8",
+     "a3b6167473100ee06e0c796c2955552b",
+     "3abf34c3503b2a23a46efc619baef897",
+     "415fad6271580a531d4179bc891d87a6"},
+    {0xaa, 131, NULL, 0, 54, "Test Using Larger Than Block-Size Key - Hash Key First",
+     NULL,
+     "95e9a0db962095adaebe9b2d6f0dbce2d499f112f2d2b7273fa6870e",
+     "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54",
+     "4ece084485813e9088d2c63a041bc5b44f9ef1012a2b588f3cd11f05033ac4c60c2ef6ab4030fe8296248df163f44952",
+     "80b24263c7c1a3ebb71493c1dd7be8b49b46d1f41b4aeec1121b013783f8f3526b56d037e05f2598bd0fd2215d6a1e5295e64f73f63f0aec8b915a985d786598"},
+    {0xaa, 131, NULL, 0, 152, "This is a test using a larger than block-size key and a larger than block-size data. The key needs to be hashed before being used by the HMAC algorithm.",
+     NULL,
+     "3a854166ac5d9f023f54d517d0b39dbd946770db9c2b95c9f6f565d1",
+     "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2",
+     "6617178e941f020d351e2f254e8fd32c602420feb0b8fb9adccebb82461e99c5a678cc31e799176d3860e6110c46523e",
+     "e37b6a775dc87dbaa4dfa9f96e5e3ffddebd71f8867289865df5a32d20cdc944b6022cac3c4982b10d5eeb55c3e4de15134676fb6de0446065c97440fa8c6a58"},
+    {0xaa, 80, NULL, 0, 54, "Test Using Larger Than Block-Size Key - Hash Key First",
+     "aa4ae5e15272d00e95705637ce8a3b55ed402112",
+     NULL,
+     NULL,
+     NULL,
+     NULL},
+    {0xaa, 80, NULL, 0, 73, "Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data",
+     "e8e99d0f45237d786d6bbaa7965c7808bbff1a91",
+     NULL,
+     NULL,
+     NULL,
+     NULL},
+};
+
+#define HSH_TEST_HMAC(name, ctx_type, size)                                          \
+    static void hsh_test_hmac_##name(const uint8_t *key, size_t key_len,              \
+                                     const uint8_t *data, size_t len, uint8_t *mac) { \
+        ctx_type ctx, copy;                                                           \
+        uint8_t again[size];                                                          \
+                                                                                      \
+        hsh_hmac_##name##_init(&ctx, key, key_len);                                   \
+        copy = ctx;                                                                   \
+        hsh_hmac_##name##_update(&ctx, data, len / 3);                                \
+        hsh_hmac_##name##_update(&ctx, data + len / 3, len - len / 3);                \
+        hsh_hmac_##name##_finalize(&ctx, mac);                                        \
+        hsh_hmac_##name(&copy, data, len, again);                                     \
+        hsh_test_same("hmac-" #name " from a copied key context", again, mac, size);  \
+    }
+
+HSH_TEST_HMAC(sha1, hsh_hmac_sha1_ctx, 20)
+HSH_TEST_HMAC(sha224, hsh_hmac_sha224_ctx, 28)
+HSH_TEST_HMAC(sha256, hsh_hmac_sha256_ctx, 32)
+HSH_TEST_HMAC(sha384, hsh_hmac_sha384_ctx, 48)
+HSH_TEST_HMAC(sha512, hsh_hmac_sha512_ctx, 64)
+
+static void hsh_test_fill(uint8_t *out, uint8_t fill, size_t len, const char *text) {
+    if (text)
+        memcpy(out, text, len);
+    else
+        for (size_t i = 0; i < len; i++)
+            out[i] = fill == 0x01 ? (uint8_t)(i + 1) : fill;
+}
+
+static void hsh_test_hmac(void) {
+    static const struct {
+        const char *name;
+        void (*mac)(const uint8_t *, size_t, const uint8_t *, size_t, uint8_t *);
+    } algs[] = {
+        {"hmac-sha1", hsh_test_hmac_sha1},     {"hmac-sha224", hsh_test_hmac_sha224},
+        {"hmac-sha256", hsh_test_hmac_sha256}, {"hmac-sha384", hsh_test_hmac_sha384},
+        {"hmac-sha512", hsh_test_hmac_sha512},
+    };
+    uint8_t key[131], data[160], mac[64];
+    char label[64];
+
+    for (size_t i = 0; i < sizeof(hsh_test_hmac_cases) / sizeof(hsh_test_hmac_cases[0]); i++) {
+        const char *want[5] = {
+            hsh_test_hmac_cases[i].sha1, hsh_test_hmac_cases[i].sha224,
+            hsh_test_hmac_cases[i].sha256, hsh_test_hmac_cases[i].sha384,
+            hsh_test_hmac_cases[i].sha512,
+        };
+
+        hsh_test_fill(key, hsh_test_hmac_cases[i].key_fill, hsh_test_hmac_cases[i].key_len,
+                      hsh_test_hmac_cases[i].key);
+        hsh_test_fill(data, hsh_test_hmac_cases[i].data_fill, hsh_test_hmac_cases[i].data_len,
+                      hsh_test_hmac_cases[i].data);
+        for (size_t a = 0; a < 5; a++) {
+            if (!want[a]) continue;
+            snprintf(label, sizeof(label), "%s case %zu", algs[a].name, i + 1);
+            algs[a].mac(key, hsh_test_hmac_cases[i].key_len, data, hsh_test_hmac_cases[i].data_len,
+                        mac);
+            hsh_test_hex(label, mac, strlen(want[a]) / 2, want[a]);
+        }
+    }
+}
+
+/* ==== BLAKE2 ==== */
+
+/* Keyed with the full-length key 00 01 02 ..., message 00 01 .. len - 1 */
+static const struct {
+    const char *alg;
+    size_t len;
+    const char *hex;
+} hsh_test_blake2_keyed[] = {
+    {"blake2b", 0, "10ebb67700b1868efb4417987acf4690ae9d972fb7a590c2f02871799aaa4786b5e996e8f0f4eb981fc214b005f42d2ff4233499391653df7aefcbc13fc51568"},
+    {"blake2b", 1, "961f6dd1e4dd30f63901690c512e78e4b45e4742ed197c3c5e45c549fd25f2e4187b0bc9fe30492b16b0d0bc4ef9b0f34c7003fac09a5ef1532e69430234cebd"},
+    {"blake2b", 64, "65676d800617972fbd87e4b9514e1c67402b7a331096d3bfac22f1abb95374abc942f16e9ab0ead33b87c91968a6e509e119ff07787b3ef483e1dcdccf6e3022"},
+    {"blake2b", 128, "72065ee4dd91c2d8509fa1fc28a37c7fc9fa7d5b3f8ad3d0d7a25626b57b1b44788d4caf806290425f9890a3a2a35a905ab4b37acfd0da6e4517b2525c9651e4"},
+    {"blake2b", 129, "64475dfe7600d7171bea0b394e27c9b00d8e74dd1e416a79473682ad3dfdbb706631558055cfc8a40e07bd015a4540dcdea15883cbbf31412df1de1cd4152b91"},
+    {"blake2b", 255, "142709d62e28fcccd0af97fad0f8465b971e82201dc51070faa0372aa43e92484be1c1e73ba10906d5d1853db6a4106e0a7bf9800d373d6dee2d46d62ef2a461"},
+    {"blake2s", 0, "48a8997da407876b3d79c0d92325ad3b89cbb754d86ab71aee047ad345fd2c49"},
+    {"blake2s", 1, "40d15fee7c328830166ac3f918650f807e7e01e177258cdc0a39b11f598066f1"},
+    {"blake2s", 63, "c65382513f07460da39833cb666c5ed82e61b9e998f4b0c4287cee56c3cc9bcd"},
+    {"blake2s", 64, "8975b0577fd35566d750b362b0897a26c399136df07bababbde6203ff2954ed4"},
+    {"blake2s", 65, "21fe0ceb0052be7fb0f004187cacd7de67fa6eb0938d927677f2398c132317a8"},
+    {"blake2s", 255, "3fb735061abc519dfe979e54c1ee5bfad0a9d858b3315bad34bde999efd724dd"},
+    {"blake2bp", 0, "9d9461073e4eb640a255357b839f394b838c6ff57c9b686a3f76107c1066728f3c9956bd785cbc3bf79dc2ab578c5a0c063b9d9c405848de1dbe821cd05c940a"},
+    {"blake2bp", 255, "96fbcbb60bd313b8845033e5bc058a38027438572d7e7957f3684f6268aadd3ad08d21767ed6878685331ba98571487e12470aad669326716e46667f69f8d7e8"},
+    {"blake2sp", 0, "715cb13895aeb678f6124160bff21465b30f4f6874193fc851b4621043f09cc6"},
+    {"blake2sp", 255, "0c8a36597d7461c63a94732821c941856c668376606c86a52de0ee4104c615db"},
+};
+
+/* "abc" with a digest size, key and personalization */
+static const struct {
+    const char *alg;
+    size_t digest_size;
+    const char *key;
+    const char *personal;
+    const char *hex;
+} hsh_test_blake2_personal[] = {
+    {"blake2b", 32, "", "hsh test person!", "cb07f07f91b44dc7c9e5acef9a30d9c3d066d759c51b66e68d40a42ac42387c5"},
+    {"blake2b", 48, "secret key", "hsh test person!", "09a18a1aee3d23062c8ccda55972e55ef2247fb6281cd775dfeae463b67f0c85885f52f2c41ff2992643a66e777fd5d1"},
+    {"blake2b", 20, "", "short", "e084a94538452078858379541dd8c0315ec93b5e"},
+    {"blake2s", 20, "", "hshtest!", "ae8ffc03a6a46d06dc93100850c2cfb6ec1432cf"},
+    {"blake2s", 32, "secret key", "hsh", "27aaf7ee7c7c767d1372a065bca02c7271dca00c391287cdb1291e1857982cc1"},
+    {"blake2s", 16, "k", "", "f335237426ff5582d0c607ef240684b5"},
+};
+
+static void hsh_test_blake2(void) {
+    uint8_t key[64], msg[256], digest[64], again[64];
+    char label[64];
+
+    for (size_t i = 0; i < sizeof(key); i++) key[i] = (uint8_t)i;
+    for (size_t i = 0; i < sizeof(msg); i++) msg[i] = (uint8_t)i;
+
+    for (size_t i = 0; i < sizeof(hsh_test_blake2_keyed) / sizeof(hsh_test_blake2_keyed[0]); i++) {
+        const char *alg = hsh_test_blake2_keyed[i].alg;
+        size_t len = hsh_test_blake2_keyed[i].len;
+        size_t size = strlen(hsh_test_blake2_keyed[i].hex) / 2;
+
+        snprintf(label, sizeof(label), "keyed %s length %zu", alg, len);
+        if (strcmp(alg, "blake2b") == 0) {
+            hsh_blake2b_ctx ctx, copy;
+            HSH_CHECK(hsh_blake2b(msg, len, digest, size, key, size) == 0, "%s", label);
+            hsh_test_hex(label, digest, size, hsh_test_blake2_keyed[i].hex);
+            /* Streamed, and from a copy of the context after keyed init */
+            hsh_blake2b_init(&ctx, size, key, size, NULL, 0);
+            copy = ctx;
+            for (size_t j = 0; j < len; j++) hsh_blake2b_update(&ctx, msg + j, 1);
+            hsh_blake2b_finalize(&ctx, again);
+            hsh_test_same(label, again, digest, size);
+            hsh_blake2b_update(&copy, msg, len);
+            hsh_blake2b_finalize(&copy, again);
+            hsh_test_same(label, again, digest, size);
+        } else if (strcmp(alg, "blake2s") == 0) {
+            hsh_blake2s_ctx ctx, copy;
+            HSH_CHECK(hsh_blake2s(msg, len, digest, size, key, size) == 0, "%s", label);
+            hsh_test_hex(label, digest, size, hsh_test_blake2_keyed[i].hex);
+            hsh_blake2s_init(&ctx, size, key, size, NULL, 0);
+            copy = ctx;
+            for (size_t j = 0; j < len; j++) hsh_blake2s_update(&ctx, msg + j, 1);
+            hsh_blake2s_finalize(&ctx, again);
+            hsh_test_same(label, again, digest, size);
+            hsh_blake2s_update(&copy, msg, len);
+            hsh_blake2s_finalize(&copy, again);
+            hsh_test_same(label, again, digest, size);
+        } else if (strcmp(alg, "blake2bp") == 0) {
+            HSH_CHECK(hsh_blake2bp(msg, len, digest, size, key, size) == 0, "%s", label);
+            hsh_test_hex(label, digest, size, hsh_test_blake2_keyed[i].hex);
+        } else {
+            HSH_CHECK(hsh_blake2sp(msg, len, digest, size, key, size) == 0, "%s", label);
+            hsh_test_hex(label, digest, size, hsh_test_blake2_keyed[i].hex);
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(hsh_test_blake2_personal) / sizeof(hsh_test_blake2_personal[0]); i++) {
+        const char *k = hsh_test_blake2_personal[i].key, *p = hsh_test_blake2_personal[i].personal;
+        size_t size = hsh_test_blake2_personal[i].digest_size;
+
+        snprintf(label, sizeof(label), "%s-%zu key \"%s\" personal \"%s\"",
+                 hsh_test_blake2_personal[i].alg, 8 * size, k, p);
+        if (strcmp(hsh_test_blake2_personal[i].alg, "blake2b") == 0) {
+            hsh_blake2b_ctx ctx;
+            HSH_CHECK(hsh_blake2b_init(&ctx, size, (const uint8_t *)k, strlen(k),
+                                       (const uint8_t *)p, strlen(p)) == 0, "%s", label);
+            hsh_blake2b_update(&ctx, (const uint8_t *)"abc", 3);
+            hsh_blake2b_finalize(&ctx, digest);
+        } else {
+            hsh_blake2s_ctx ctx;
+            HSH_CHECK(hsh_blake2s_init(&ctx, size, (const uint8_t *)k, strlen(k),
+                                       (const uint8_t *)p, strlen(p)) == 0, "%s", label);
+            hsh_blake2s_update(&ctx, (const uint8_t *)"abc", 3);
+            hsh_blake2s_finalize(&ctx, digest);
+        }
+        hsh_test_hex(label, digest, size, hsh_test_blake2_personal[i].hex);
+    }
+
+    /* Parameters outside the limits are rejected */
+    hsh_blake2b_ctx b;
+    hsh_blake2s_ctx s;
+    HSH_CHECK(hsh_blake2b_init(&b, 0, NULL, 0, NULL, 0) == -1, "blake2b digest size 0");
+    HSH_CHECK(hsh_blake2b_init(&b, 65, NULL, 0, NULL, 0) == -1, "blake2b digest size 65");
+    HSH_CHECK(hsh_blake2b_init(&b, 64, key, 65, NULL, 0) == -1, "blake2b key length 65");
+    HSH_CHECK(hsh_blake2b_init(&b, 64, NULL, 0, msg, 17) == -1, "blake2b personal length 17");
+    HSH_CHECK(hsh_blake2s_init(&s, 33, NULL, 0, NULL, 0) == -1, "blake2s digest size 33");
+    HSH_CHECK(hsh_blake2s_init(&s, 32, key, 33, NULL, 0) == -1, "blake2s key length 33");
+    HSH_CHECK(hsh_blake2s_init(&s, 32, NULL, 0, msg, 9) == -1, "blake2s personal length 9");
+}
+
+/* ==== BLAKE3 ==== */
+
+#define HSH_TEST_BLAKE3_KEY     "hsh blake3 test key, 32 bytes..!"
+#define HSH_TEST_BLAKE3_CONTEXT "hsh 2026-10-17 test vectors derive_key"
+#define HSH_TEST_BLAKE3_XOF     80
+
+/* hash (80-byte output), keyed_hash and derive_key of len bytes */
+static const struct {
+    size_t len;
+    const char *hash;
+    const char *keyed;
+    const char *derive;
+} hsh_test_blake3[] = {
+    {0,
+     "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262e00f03e7b69af26b7faaf09fcd333050338ddfe085b8cc869ca98b206c08243a26f5487789e8f660afe6c99ef9e0c52b",
+     "a0144fa06e1e7306590282d864d21539f4f367ccd6da0a0b39a4b3315e5edff9",
+     "1db88e66c67da1c3db5dcf8892406b3facfa7d07985616e04a02ec95d091b897"},
+    {1,
+     "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213c3a6cb8bf623e20cdb535f8d1a5ffb86342d9c0b64aca3bce1d31f60adfa137b358ad4d79f97b47c3d5e79f179df87a3",
+     "a28f29c687f204a248b205d0865e9318e0dadae86f2abca8a632cd5b930311b5",
+     "e74edfd5afe60416910d23ed5a6d32066103810fab2719a2b5c39a4b292ed217"},
+    {63,
+     "e9bc37a594daad83be9470df7f7b3798297c3d834ce80ba85d6e207627b7db7b1197012b1e7d9af4d7cb7bdd1f3bb49a90a9b5dec3ea2bbc6eaebce77f4e470cbf4687093b5352f04e4a4570fba23316",
+     "6290163bb1159a1671d414eb0b8146fd8a6cf8202618c91f60c656fcd2ef1b9d",
+     "efb907fc2b186ea4d4aec8772eb7f82a3169cd4ffcf5727e731a10e33b65c8ee"},
+    {64,
+     "4eed7141ea4a5cd4b788606bd23f46e212af9cacebacdc7d1f4c6dc7f2511b98fc9cc56cb831ffe33ea8e7e1d1df09b26efd2767670066aa82d023b1dfe8ab1b2b7fbb5b97592d46ffe3e05a6a9b592e",
+     "837eca0f3a1d0560d3eb861aebac7627bd97ffe65eacc7750bb14d33af9c5c87",
+     "34cc221fe2fee8acd6931c57a96bc4f496c022235bb080b0f00347cd5613e80e"},
+    {65,
+     "de1e5fa0be70df6d2be8fffd0e99ceaa8eb6e8c93a63f2d8d1c30ecb6b263dee0e16e0a4749d6811dd1d6d1265c29729b1b75a9ac346cf93f0e1d7296dfcfd4313b3a227faaaaf7757cc95b4e87a49be",
+     "32e9a2c8b1f54d9d2cc0fc1bfde988f2bf201d555cec2117c64fd0282a3af7f1",
+     "03a449228d2fa8aa946b6f503c54698f15229cc324a264cc179672587fd887ea"},
+    {1023,
+     "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11a182d27a591b05592b15607500e1e8dd56bc6c7fc063715b7a1d737df5bad3339c56778957d870eb9717b57ea3d9fb68",
+     "3eb2e62979e5a4c5f6f0af1f90107cb71827eafaefbd957dc6410992ade30264",
+     "602686650c4dbbd40f604d176ed85a1b0cbbebab5dbb1fa8ddf3164d1885ed0a"},
+    {1024,
+     "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af71cf8107265ecdaf8505b95d8fcec83a98a6a96ea5109d2c179c47a387ffbb404756f6eeae7883b446b70ebb144527c20",
+     "2e1038b243bc0efa52a44440aef91647afff4628b26b48a612d02b70fb07f0c1",
+     "5fe1be4c447d9abf26b69eab495c2737a6dad842ff3285da7a32dd77ccc88cb1"},
+    {1025,
+     "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444f4c4a22b4b399155358a994e52bf255de60035742ec71bd08ac275a1b51cc6bfe332b0ef84b409108cda080e6269ed4b",
+     "318bf75d09984579ceb79d0035c66365c90271c6f18c692adcf83120f1740c8e",
+     "66abe6244106f3041b76e9cd7d538590c7aa90e288c575355f77786511fa34f4"},
+    {2048,
+     "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a9a60bf80001410ec9eea6698cd537939fad4749edd484cb541aced55cd9bf54764d063f23f6f1e32e12958ba5cfeb1bf",
+     "5c9191bf4cbea8ca0a674ec9f0df0afba048031cbc86060c7600f3a6f10d5219",
+     "a236145fbc605580552c3c4846e4cb6d0e9ae3c4c5e49f2e5bad81ccd2812288"},
+    {2049,
+     "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b687952256303096de31d71d74103403822a2e0bc1eb193e7aecc9643a76b7bbc0c9f9c52e8783aae98764ca468962b5c2ec92f0c74eb5",
+     "2b6ecbddb1905334b530df2f24d4022757e4a5046190e9fa614932f49e701fce",
+     "f693a7e1e98dada8e7ee0a53b5c9bfd500bf0a24cc67cdc0eb600f157e949154"},
+    {3072,
+     "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd29a3f6b0b978d6608335c09dc94ccf682f9951cdfc501bfe47b9c9189a6fc7b404d120258506341a6d802857322fbd20d",
+     "ae676bdda4d1969d3a582bc636e3cf4986cf1f8d09a2250b31fe42fea1c0ca36",
+     "15f23aee29d29336c516e69806878319cbdb3cf01d378e0aca9624055a705f7a"},
+    {3073,
+     "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd39a27ae3b79d68d89da9bf25bc27139ae65a324918a5f9b7828181e52cf373c84f35b639b7fccbb985b6f2fa56aea0c18",
+     "4c41a186e054ddcf99041b544cd9baf07dc43ae37958bbd7a8f831e34331e471",
+     "1680d6ffec9315be924b233f579bb51c53f2842f5cdd6c2b71c68a583d0d56d5"},
+    {4096,
+     "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e9690289e9409ddb1b99768eafe1623da896faf7e1114bebeadc1be30829b6f8af707d85c298f4f0ff4d9438aef948335612",
+     "4d6a7d44b3e132ca5337a047c15be6c9c8eb201805c45cdf7d1bac117c220f07",
+     "e69868a69157894bc63d147e252b283e553e3d80c2ad9f54599a5c9a1475fa8b"},
+    {4097,
+     "9b4052b38f1c5fc8b1f9ff7ac7b27cd242487b3d890d15c96a1c25b8aa0fb99505f91b0b5600a11251652eacfa9497b31cd3c409ce2e45cfe6c0a016967316c426bd26f619eab5d70af9a418b845c608",
+     "db432d1ee2a063601dc243ade18489f9825f5b9e0112709e2dcd2b720aa83954",
+     "638b551090ad57afa81f9ce4a67dcf896d497b40da030ce88132e424a085b7b6"},
+    {8193,
+     "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3bb2282aa69be089359ea1154b9a9286c4a56af4de975a9aa4a5c497654914d279bea60bb6d2cf7225a2fa0ff5ef56bbe4",
+     "837a4c0531dcb0f0ec62d53941ed670cea671b59ce8b3794f922448a5ed10f20",
+     "deef90949eda0adb7d9a546ac78b466171ab6b3e127ce565bc4f13f2750ccde6"},
+    {16384,
+     "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde49d764c270176e53e97bdffa58d549073f2c660be0e81293767ed4e4929f9ad34bbb39a529334c57c4a381ffd2a6d4bfd",
+     "cb2c428394667b438da138a6200f200710cf65b5b953cc819385bdc4a18acc92",
+     "159667f8b00e41539ae7a0e290d3ee3b0a0de835ff325598df36ad878bd254d3"},
+    {31744,
+     "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47860cc51f2b0c28a7b77304bd55fe73af663c02d3f52ea053ba43431ca5bab7bfea2f5e9d7121770d88f70ae9649ea713",
+     "92d30a3a8c5c851e5ef2e2de7b423e7a5d2e344282816dced597d7526c4addc6",
+     "a3a946f1eda98076ddcb2c071ca1afd253c1c2dc9ab6f414a6ca14fcc42b269e"},
+    {102400,
+     "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085e01c59dab908c04c3342b816941a26d69c2605ebee5ec5291cc55e15b76146e6745f0601156c3596cb75065a9c57f355",
+     "767b3fef2129ad32d5202e8e92bd853cce080031261720d7456be3e47924852d",
+     "225042bf98d08adad49c9aa9cbc80f9aae27f2026c931a5ff26535c9714bd7a5"},
+};
+
+static void hsh_test_blake3_vectors(void) {
+    const uint8_t *key = (const uint8_t *)HSH_TEST_BLAKE3_KEY;
+    uint8_t out[HSH_TEST_BLAKE3_XOF], again[HSH_TEST_BLAKE3_XOF];
+    char label[64];
+
+    for (size_t i = 0; i < sizeof(hsh_test_blake3) / sizeof(hsh_test_blake3[0]); i++) {
+        size_t len = hsh_test_blake3[i].len;
+        uint8_t *msg = malloc(len ? len : 1);
+        hsh_blake3_ctx ctx;
+
+        if (!msg) abort();
+        for (size_t j = 0; j < len; j++) msg[j] = (uint8_t)(j % 251);
+
+        snprintf(label, sizeof(label), "blake3 hash length %zu", len);
+        hsh_blake3(msg, len, out, HSH_TEST_BLAKE3_XOF);
+        hsh_test_hex(label, out, HSH_TEST_BLAKE3_XOF, hsh_test_blake3[i].hash);
+        hsh_blake3_init(&ctx);
+        for (size_t pos = 0; pos < len;) {
+            size_t n = len - pos < 100 + pos ? len - pos : 100 + pos;
+            hsh_blake3_update(&ctx, msg + pos, n);
+            pos += n;
+        }
+        hsh_blake3_finalize(&ctx, again, HSH_TEST_BLAKE3_XOF);
+        hsh_test_same(label, again, out, HSH_TEST_BLAKE3_XOF);
+        /* A shorter output is a prefix of the longer one */
+        hsh_blake3_finalize(&ctx, again, 32);
+        hsh_test_same(label, again, out, 32);
+
+        snprintf(label, sizeof(label), "blake3 keyed_hash length %zu", len);
+        hsh_blake3_keyed(key, msg, len, out, 32);
+        hsh_test_hex(label, out, 32, hsh_test_blake3[i].keyed);
+        hsh_blake3_init_keyed(&ctx, key);
+        hsh_blake3_update(&ctx, msg, len);
+        hsh_blake3_finalize(&ctx, again, 32);
+        hsh_test_same(label, again, out, 32);
+
+        snprintf(label, sizeof(label), "blake3 derive_key length %zu", len);
+        hsh_blake3_init_derive_key(&ctx, HSH_TEST_BLAKE3_CONTEXT);
+        hsh_blake3_update(&ctx, msg, len);
+        hsh_blake3_finalize(&ctx, out, 32);
+        hsh_test_hex(label, out, 32, hsh_test_blake3[i].derive);
+        free(msg);
+    }
+}
+
+void hsh_test_mac(void) {
+    hsh_test_hmac();
+    hsh_test_blake2();
+    hsh_test_blake3_vectors();
+}
@@ -0,0 +1,89 @@
+/*
+ * hsh_test: known-answer and consistency tests for every algorithm.
+ *
+ * The binary checks whatever backends the CPU features allow; "make test"
+ * runs it once per HSH_CPU level and thread count, so each SIMD kernel is
+ * compared against the same vectors as the generic code.
+ */
+
+#include "test.h"
+#include "hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+size_t hsh_test_checks;
+size_t hsh_test_failures;
+
+static void hsh_test_to_hex(const uint8_t *p, size_t len, char *out) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = digits[p[i] >> 4];
+        out[2 * i + 1] = digits[p[i] & 15];
+    }
+    out[2 * len] = '\0';
+}
+
+int hsh_test_hex(const char *label, const uint8_t *got, size_t len, const char *want) {
+    char hex[2 * 256 + 1];
+    int ok;
+
+    if (len > 256) len = 256;
+    hsh_test_to_hex(got, len, hex);
+    ok = strlen(want) == 2 * len && strcmp(hex, want) == 0;
+    HSH_CHECK(ok, "%s\n  got  %s\n  want %s", label, hex, want);
+    return ok;
+}
+
+int hsh_test_same(const char *label, const uint8_t *got, const uint8_t *want, size_t len) {
+    int ok = memcmp(got, want, len) == 0;
+    HSH_CHECK(ok, "%s", label);
+    return ok;
+}
+
+uint8_t *hsh_test_data(uint64_t seed, size_t len) {
+    uint8_t *p = malloc(len ? len : 1);
+    uint64_t x = seed, word = 0;
+
+    if (!p) {
+        fprintf(stderr, "hsh_test: out of memory\n");
+        exit(2);
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (i % 8 == 0) {
+            /* splitmix64 */
+            uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+        p[i] = (uint8_t)(word >> (8 * (i % 8)));
+    }
+    return p;
+}
+
+int main(void) {
+    static const struct {
+        const char *name;
+        void (*fn)(void);
+    } groups[] = {
+        {"vectors", hsh_test_vectors}, {"mac", hsh_test_mac},
+        {"stream", hsh_test_stream},   {"batch", hsh_test_batch},
+        {"state", hsh_test_state},     {"merkle", hsh_test_merkle},
+        {"cdc", hsh_test_cdc},
+    };
+    const char *cpu = getenv("HSH_CPU");
+
+    printf("hsh_test: HSH_CPU=%s, backends:", cpu ? cpu : "(unset)");
+    for (size_t i = 0; i < hsh_hash_count(); i++)
+        printf(" %s=%s", hsh_hash_get(i)->name, hsh_hash_backend(hsh_hash_get(i)));
+    printf("\n");
+
+    for (size_t i = 0; i < sizeof(groups) / sizeof(groups[0]); i++) {
+        size_t before = hsh_test_failures;
+        groups[i].fn();
+        printf("  %-8s %s\n", groups[i].name, hsh_test_failures == before ? "ok" : "FAILED");
+    }
+
+    printf("hsh_test: %zu checks, %zu failed\n", hsh_test_checks, hsh_test_failures);
+    return hsh_test_failures ? 1 : 0;
+}
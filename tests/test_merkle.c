@@ -0,0 +1,201 @@
+/*
+ * Merkle tree: roots against a from-scratch reference built level by level
+ * (RFC 6962 prefixes, unset leaves all zero, padding to a power of two),
+ * single and batch updates including repeated indices, inclusion proofs,
+ * and a file-backed tree closed and reopened.
+ */
+
+#include "test.h"
+#include "merkle.h"
+#include "sha2.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef uint8_t hsh_test_digest[HSH_MERKLE_DIGEST_SIZE];
+
+/* Root over leaf digests[0..leaves), the rest of the power of two zero */
+static void hsh_test_merkle_ref(const hsh_test_digest *digests, uint64_t leaves,
+                                uint8_t root[HSH_MERKLE_DIGEST_SIZE]) {
+    uint64_t width = 1;
+    hsh_test_digest *level;
+
+    while (width < leaves) width *= 2;
+    level = calloc(width, sizeof(*level));
+    if (!level) abort();
+    memcpy(level, digests, leaves * sizeof(*level));
+    for (; width > 1; width /= 2) {
+        for (uint64_t i = 0; i < width / 2; i++) {
+            uint8_t msg[1 + 2 * HSH_MERKLE_DIGEST_SIZE];
+            msg[0] = 0x01;
+            memcpy(msg + 1, level[2 * i], 2 * HSH_MERKLE_DIGEST_SIZE);
+            hsh_sha2_256(msg, sizeof(msg), level[i]);
+        }
+    }
+    memcpy(root, level[0], HSH_MERKLE_DIGEST_SIZE);
+    free(level);
+}
+
+static int hsh_test_merkle_matches(const hsh_merkle_tree *tree, const hsh_test_digest *digests,
+                                   const char *label) {
+    uint8_t root[HSH_MERKLE_DIGEST_SIZE], want[HSH_MERKLE_DIGEST_SIZE];
+
+    hsh_merkle_root(tree, root);
+    hsh_test_merkle_ref(digests, tree->leaves, want);
+    return hsh_test_same(label, root, want, sizeof(root));
+}
+
+static void hsh_test_merkle_known(void) {
+    hsh_merkle_tree single, batch;
+    hsh_merkle_leaf leaves[5];
+    char text[5][8];
+    uint8_t root[HSH_MERKLE_DIGEST_SIZE];
+
+    HSH_CHECK(hsh_merkle_init(&single, 0) == -1, "tree of 0 leaves accepted");
+
+    /* One leaf: the root is the leaf digest itself */
+    HSH_CHECK(hsh_merkle_init(&single, 1) == 0, "tree of 1 leaf");
+    hsh_merkle_root(&single, root);
+    hsh_test_hex("empty 1-leaf root", root, sizeof(root),
+                 "0000000000000000000000000000000000000000000000000000000000000000");
+    hsh_merkle_update(&single, 0, (const uint8_t *)"leaf 0", 6);
+    hsh_merkle_root(&single, root);
+    hsh_test_hex("1-leaf root", root, sizeof(root),
+                 "1bb97dcc21635d47e2663efdfd0a174686d98dd701352dd2cd06e8b43fd3d305");
+    hsh_merkle_close(&single);
+
+    /* Five leaves "leaf 0" .. "leaf 4" padded to eight */
+    HSH_CHECK(hsh_merkle_init(&single, 5) == 0 && hsh_merkle_init(&batch, 5) == 0, "5-leaf trees");
+    for (int i = 0; i < 5; i++) {
+        snprintf(text[i], sizeof(text[i]), "leaf %d", i);
+        hsh_merkle_update(&single, (uint64_t)i, (const uint8_t *)text[i], 6);
+        leaves[i].index = (uint64_t)(4 - i);
+        leaves[i].data = (const uint8_t *)text[4 - i];
+        leaves[i].len = 6;
+    }
+    HSH_CHECK(hsh_merkle_update_batch(&batch, leaves, 5) == 0, "5-leaf batch");
+    hsh_merkle_root(&single, root);
+    hsh_test_hex("5-leaf root", root, sizeof(root),
+                 "cfafdd77eeff9ac87e880eaba7334aea77d7909158cd9bf5939ce9d82900a8c6");
+    hsh_merkle_root(&batch, root);
+    hsh_test_hex("5-leaf root from a batch", root, sizeof(root),
+                 "cfafdd77eeff9ac87e880eaba7334aea77d7909158cd9bf5939ce9d82900a8c6");
+    hsh_merkle_close(&single);
+    hsh_merkle_close(&batch);
+}
+
+static void hsh_test_merkle_updates(uint64_t count) {
+    hsh_test_digest *digests = calloc(count, sizeof(*digests));
+    uint8_t *data = hsh_test_data(count, 4096);
+    hsh_merkle_leaf *batch = malloc(600 * sizeof(*batch));
+    uint8_t root[HSH_MERKLE_DIGEST_SIZE], again[HSH_MERKLE_DIGEST_SIZE];
+    hsh_test_digest proof[HSH_MERKLE_MAX_DEPTH];
+    uint64_t x = count;
+    hsh_merkle_tree tree;
+    char label[64];
+
+    if (!digests || !batch) abort();
+    HSH_CHECK(hsh_merkle_init(&tree, count) == 0, "tree of %llu leaves", (unsigned long long)count);
+    snprintf(label, sizeof(label), "%llu leaves, empty", (unsigned long long)count);
+    hsh_test_merkle_matches(&tree, digests, label);
+
+    /* Single updates, each checked against the reference */
+    for (int i = 0; i < 40; i++) {
+        uint64_t index = (x = x * 6364136223846793005ULL + 1442695040888963407ULL) % count;
+        size_t off = (size_t)(x >> 40) % 2048, len = (size_t)(x >> 20) % 2048;
+
+        HSH_CHECK(hsh_merkle_update(&tree, index, data + off, len) == 0, "update");
+        hsh_merkle_leaf_hash(data + off, len, digests[index]);
+        snprintf(label, sizeof(label), "%llu leaves, update %d", (unsigned long long)count, i);
+        hsh_test_merkle_matches(&tree, digests, label);
+    }
+
+    /* Batches with repeated indices (the last entry wins), small and large
+     * enough to be hashed on the pool */
+    const size_t sizes[] = {1, 3, 64, 300, 600};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (size_t i = 0; i < sizes[s]; i++) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            batch[i].index = (x >> 11) % (count < 50 ? count : count / 3 + 1);
+            batch[i].data = data + (x >> 40) % 2048;
+            batch[i].len = (size_t)(x >> 24) % 300;
+        }
+        HSH_CHECK(hsh_merkle_update_batch(&tree, batch, sizes[s]) == 0, "batch");
+        for (size_t i = 0; i < sizes[s]; i++)
+            hsh_merkle_leaf_hash(batch[i].data, batch[i].len, digests[batch[i].index]);
+        snprintf(label, sizeof(label), "%llu leaves, batch of %zu", (unsigned long long)count, sizes[s]);
+        hsh_test_merkle_matches(&tree, digests, label);
+    }
+
+    /* An out-of-range index fails and leaves the tree alone */
+    hsh_merkle_root(&tree, root);
+    batch[1].index = count;
+    HSH_CHECK(hsh_merkle_update_batch(&tree, batch, 2) == -1, "batch with index out of range");
+    HSH_CHECK(hsh_merkle_update(&tree, count, data, 1) == -1, "update out of range");
+    hsh_merkle_root(&tree, again);
+    hsh_test_same("tree unchanged by a failed batch", again, root, sizeof(root));
+
+    /* Proofs verify for their own leaf and nothing else */
+    for (uint64_t k = 0; k < 12 && k < count; k++) {
+        uint64_t index = (k * 7919) % count;
+
+        snprintf(label, sizeof(label), "%llu leaves, proof of %llu", (unsigned long long)count,
+                 (unsigned long long)index);
+        HSH_CHECK(hsh_merkle_proof(&tree, index, proof) == 0, "%s", label);
+        HSH_CHECK(hsh_merkle_verify(root, index, digests[index], (const uint8_t (*)[32])proof,
+                                    tree.depth) == 1, "%s", label);
+        if (tree.depth == 0) continue;
+        HSH_CHECK(hsh_merkle_verify(root, index ^ 1, digests[index], (const uint8_t (*)[32])proof,
+                                    tree.depth) == 0 ||
+                  memcmp(digests[index], proof[0], HSH_MERKLE_DIGEST_SIZE) == 0,
+                  "%s: verifies at the sibling index", label);
+        proof[tree.depth - 1][5] ^= 1;
+        HSH_CHECK(hsh_merkle_verify(root, index, digests[index], (const uint8_t (*)[32])proof,
+                                    tree.depth) == 0, "%s: tampered proof verifies", label);
+    }
+    HSH_CHECK(hsh_merkle_proof(&tree, count, proof) == -1, "proof out of range");
+
+    hsh_merkle_close(&tree);
+    free(batch);
+    free(data);
+    free(digests);
+}
+
+static void hsh_test_merkle_file(void) {
+    char path[] = "/tmp/hsh_test_merkle_XXXXXX";
+    uint8_t root[HSH_MERKLE_DIGEST_SIZE], again[HSH_MERKLE_DIGEST_SIZE];
+    hsh_merkle_tree tree;
+    int fd = mkstemp(path);
+
+    HSH_CHECK(fd >= 0, "mkstemp");
+    if (fd < 0) return;
+    close(fd);
+
+    /* mkstemp left an empty file, which open initializes */
+    HSH_CHECK(hsh_merkle_open(&tree, path, 777) == 0, "open new tree file");
+    hsh_merkle_update(&tree, 5, (const uint8_t *)"abc", 3);
+    hsh_merkle_update(&tree, 776, (const uint8_t *)"xyz", 3);
+    hsh_merkle_root(&tree, root);
+    HSH_CHECK(hsh_merkle_sync(&tree) == 0, "sync");
+    hsh_merkle_close(&tree);
+
+    HSH_CHECK(hsh_merkle_open(&tree, path, 0) == 0 && tree.leaves == 777, "reopen tree file");
+    hsh_merkle_root(&tree, again);
+    hsh_test_same("root after reopening", again, root, sizeof(root));
+    hsh_merkle_close(&tree);
+
+    errno = 0;
+    HSH_CHECK(hsh_merkle_open(&tree, path, 778) == -1 && errno == EINVAL,
+              "tree file opened with another leaf count");
+    unlink(path);
+}
+
+void hsh_test_merkle(void) {
+    hsh_test_merkle_known();
+    hsh_test_merkle_updates(1);
+    hsh_test_merkle_updates(2);
+    hsh_test_merkle_updates(1000);
+    hsh_test_merkle_updates(4096);
+    hsh_test_merkle_file();
+}
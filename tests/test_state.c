@@ -0,0 +1,118 @@
+/*
+ * Context snapshots: a state serialized mid-message, restored into a
+ * scratch context and finished must give the uninterrupted digest; the
+ * snapshot of the restored state must match byte for byte; and truncated
+ * or mislabeled snapshots must be rejected.
+ */
+
+#include "test.h"
+#include "state.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HSH_TEST_STATE_LEN 1000
+
+static const size_t hsh_test_state_cuts[] = {0, 1, 63, 64, 65, 127, 128, 129, 135, 136, 137, 999};
+
+static void hsh_test_blake2b_keyed_init(hsh_blake2b_ctx *ctx) {
+    (void)hsh_blake2b_init(ctx, 48, (const uint8_t *)"state key", 9, (const uint8_t *)"personal", 8);
+}
+
+static void hsh_test_blake2s_keyed_init(hsh_blake2s_ctx *ctx) {
+    (void)hsh_blake2s_init(ctx, 32, (const uint8_t *)"state key", 9, NULL, 0);
+}
+
+static void hsh_test_blake2b_plain_init(hsh_blake2b_ctx *ctx) {
+    (void)hsh_blake2b_init(ctx, 64, NULL, 0, NULL, 0);
+}
+
+#define HSH_TEST_STATE(name, ctx_type, type, size, init, update, finalize, digest_len)       \
+    static void hsh_test_state_##name(const uint8_t *data) {                                 \
+        uint8_t snap[size], again[size], want[64], got[64];                                   \
+        ctx_type a, b;                                                                         \
+        char label[64];                                                                        \
+                                                                                               \
+        init(&a);                                                                              \
+        update(&a, data, HSH_TEST_STATE_LEN);                                                  \
+        finalize(&a, want);                                                                    \
+        for (size_t c = 0; c < sizeof(hsh_test_state_cuts) / sizeof(hsh_test_state_cuts[0]); c++) { \
+            size_t cut = hsh_test_state_cuts[c];                                              \
+                                                                                               \
+            snprintf(label, sizeof(label), "%s snapshot after %zu bytes", #name, cut);         \
+            init(&a);                                                                          \
+            update(&a, data, cut);                                                             \
+            hsh_##type##_serialize(&a, snap);                                                 \
+            memset(&b, 0x5a, sizeof(b));                                                       \
+            HSH_CHECK(hsh_##type##_deserialize(&b, snap, size) == 0, "%s: rejected", label);  \
+            hsh_##type##_serialize(&b, again);                                                \
+            hsh_test_same(label, again, snap, size);                                           \
+            update(&b, data + cut, HSH_TEST_STATE_LEN - cut);                                  \
+            finalize(&b, got);                                                                 \
+            hsh_test_same(label, got, want, digest_len);                                       \
+                                                                                               \
+            HSH_CHECK(hsh_##type##_deserialize(&b, snap, size - 1) == -1, "%s: short", label); \
+            snap[2]++;                                                                         \
+            HSH_CHECK(hsh_##type##_deserialize(&b, snap, size) == -1, "%s: version", label);  \
+            snap[2]--;                                                                         \
+            snap[3] ^= 0x40;                                                                   \
+            HSH_CHECK(hsh_##type##_deserialize(&b, snap, size) == -1, "%s: type", label);     \
+        }                                                                                      \
+    }
+
+HSH_TEST_STATE(md5, hsh_md5_ctx, md5, HSH_STATE_SIZE_MD5,
+               hsh_md5_init, hsh_md5_update, hsh_md5_finalize, 16)
+HSH_TEST_STATE(sha1, hsh_sha1_ctx, sha1, HSH_STATE_SIZE_SHA1,
+               hsh_sha1_init, hsh_sha1_update, hsh_sha1_finalize, 20)
+HSH_TEST_STATE(sha224, hsh_sha2_224_ctx, sha2_256, HSH_STATE_SIZE_SHA2_256,
+               hsh_sha2_224_init, hsh_sha2_224_update, hsh_sha2_224_finalize, 28)
+HSH_TEST_STATE(sha256, hsh_sha2_256_ctx, sha2_256, HSH_STATE_SIZE_SHA2_256,
+               hsh_sha2_256_init, hsh_sha2_256_update, hsh_sha2_256_finalize, 32)
+HSH_TEST_STATE(sha384, hsh_sha2_384_ctx, sha2_512, HSH_STATE_SIZE_SHA2_512,
+               hsh_sha2_384_init, hsh_sha2_384_update, hsh_sha2_384_finalize, 48)
+HSH_TEST_STATE(sha512, hsh_sha2_512_ctx, sha2_512, HSH_STATE_SIZE_SHA2_512,
+               hsh_sha2_512_init, hsh_sha2_512_update, hsh_sha2_512_finalize, 64)
+HSH_TEST_STATE(sha3_256, hsh_sha3_ctx, sha3, HSH_STATE_SIZE_SHA3,
+               hsh_sha3_256_init, hsh_sha3_update, hsh_sha3_finalize, 32)
+HSH_TEST_STATE(sha3_512, hsh_sha3_ctx, sha3, HSH_STATE_SIZE_SHA3,
+               hsh_sha3_512_init, hsh_sha3_update, hsh_sha3_finalize, 64)
+HSH_TEST_STATE(blake2b, hsh_blake2b_ctx, blake2b, HSH_STATE_SIZE_BLAKE2B,
+               hsh_test_blake2b_plain_init, hsh_blake2b_update, hsh_blake2b_finalize, 64)
+HSH_TEST_STATE(blake2b_keyed, hsh_blake2b_ctx, blake2b, HSH_STATE_SIZE_BLAKE2B,
+               hsh_test_blake2b_keyed_init, hsh_blake2b_update, hsh_blake2b_finalize, 48)
+HSH_TEST_STATE(blake2s_keyed, hsh_blake2s_ctx, blake2s, HSH_STATE_SIZE_BLAKE2S,
+               hsh_test_blake2s_keyed_init, hsh_blake2s_update, hsh_blake2s_finalize, 32)
+
+/* A SHAKE context saved while squeezing continues the same output */
+static void hsh_test_state_shake(const uint8_t *data) {
+    uint8_t want[400], got[400], snap[HSH_STATE_SIZE_SHA3];
+    hsh_shake_ctx a, b;
+
+    hsh_shake256(data, 500, want, sizeof(want));
+    for (size_t cut = 0; cut < sizeof(want); cut += 67) {
+        hsh_shake256_init(&a);
+        hsh_shake_update(&a, data, 500);
+        hsh_shake_squeeze(&a, got, cut);
+        hsh_sha3_serialize(&a, snap);
+        HSH_CHECK(hsh_sha3_deserialize(&b, snap, sizeof(snap)) == 0, "shake256 squeeze snapshot");
+        hsh_shake_squeeze(&b, got + cut, sizeof(want) - cut);
+        hsh_test_same("shake256 squeeze snapshot", got, want, sizeof(want));
+    }
+}
+
+void hsh_test_state(void) {
+    uint8_t *data = hsh_test_data(51, HSH_TEST_STATE_LEN);
+
+    hsh_test_state_md5(data);
+    hsh_test_state_sha1(data);
+    hsh_test_state_sha224(data);
+    hsh_test_state_sha256(data);
+    hsh_test_state_sha384(data);
+    hsh_test_state_sha512(data);
+    hsh_test_state_sha3_256(data);
+    hsh_test_state_sha3_512(data);
+    hsh_test_state_blake2b(data);
+    hsh_test_state_blake2b_keyed(data);
+    hsh_test_state_blake2s_keyed(data);
+    hsh_test_state_shake(data);
+    free(data);
+}
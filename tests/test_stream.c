@@ -0,0 +1,127 @@
+/*
+ * Streaming against one-shot hashing for every registered algorithm: the
+ * same message fed whole, split around block boundaries, byte by byte and
+ * in uneven pieces must give the one-shot digest. Also covers the threaded
+ * paths (BLAKE3 subtrees, multi-digest tiles) against the sequential ones.
+ */
+
+#include "test.h"
+#include "hash.h"
+#include "blake3.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void hsh_test_stream_alg(const hsh_hash_alg *alg, const uint8_t *data) {
+    const size_t b = alg->block_size;
+    const size_t lens[] = {0, 1, b - 1, b, b + 1, 2 * b - 1, 2 * b, 3 * b + 5, 1000, 8193, 100000};
+    uint8_t want[HSH_HASH_MAX_DIGEST], got[HSH_HASH_MAX_DIGEST];
+    hsh_hash_ctx ctx;
+    char label[96];
+
+    for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        const size_t len = lens[l];
+        const size_t splits[] = {1, b - 1, b, b + 1, 2 * b + 3, len / 2, len - 1};
+
+        hsh_hash(alg, data, len, want);
+
+        snprintf(label, sizeof(label), "%s length %zu, one update", alg->name, len);
+        hsh_hash_init(&ctx, alg);
+        hsh_hash_update(&ctx, data, len);
+        hsh_hash_finalize(&ctx, got);
+        hsh_test_same(label, got, want, alg->digest_size);
+
+        for (size_t s = 0; s < sizeof(splits) / sizeof(splits[0]); s++) {
+            if (splits[s] == 0 || splits[s] >= len) continue;
+            snprintf(label, sizeof(label), "%s length %zu, split at %zu", alg->name, len, splits[s]);
+            hsh_hash_init(&ctx, alg);
+            hsh_hash_update(&ctx, data, splits[s]);
+            hsh_hash_update(&ctx, NULL, 0);
+            hsh_hash_update(&ctx, data + splits[s], len - splits[s]);
+            hsh_hash_finalize(&ctx, got);
+            hsh_test_same(label, got, want, alg->digest_size);
+        }
+
+        if (len <= 3 * b + 5) {
+            snprintf(label, sizeof(label), "%s length %zu, byte by byte", alg->name, len);
+            hsh_hash_init(&ctx, alg);
+            for (size_t i = 0; i < len; i++) hsh_hash_update(&ctx, data + i, 1);
+            hsh_hash_finalize(&ctx, got);
+            hsh_test_same(label, got, want, alg->digest_size);
+        }
+
+        /* Piece sizes cycling through values below, at and above a block */
+        snprintf(label, sizeof(label), "%s length %zu, uneven pieces", alg->name, len);
+        hsh_hash_init(&ctx, alg);
+        for (size_t pos = 0, k = 0; pos < len; k++) {
+            size_t piece = (k * 37 + 1) % (3 * b);
+            if (piece > len - pos) piece = len - pos;
+            hsh_hash_update(&ctx, data + pos, piece);
+            pos += piece;
+        }
+        hsh_hash_finalize(&ctx, got);
+        hsh_test_same(label, got, want, alg->digest_size);
+    }
+}
+
+static void hsh_test_stream_blake3_parallel(void) {
+    const size_t len = 9 * 1024 * 1024 + 1234;
+    uint8_t *data = hsh_test_data(31, len);
+    uint8_t want[32], got[32];
+    hsh_blake3_ctx ctx;
+
+    hsh_blake3(data, len, want, 32);
+
+    hsh_blake3_init(&ctx);
+    hsh_blake3_update_parallel(&ctx, data, len);
+    hsh_blake3_finalize(&ctx, got, 32);
+    hsh_test_same("blake3 update_parallel", got, want, 32);
+
+    /* After a partial chunk the subtrees no longer start at a chunk boundary */
+    hsh_blake3_init(&ctx);
+    hsh_blake3_update(&ctx, data, 1500);
+    hsh_blake3_update_parallel(&ctx, data + 1500, len - 1500);
+    hsh_blake3_finalize(&ctx, got, 32);
+    hsh_test_same("blake3 update_parallel after a partial chunk", got, want, 32);
+    free(data);
+}
+
+static void hsh_test_stream_multi(void) {
+    const size_t len = 3 * 1024 * 1024 + 77;
+    const hsh_hash_alg *algs[] = {
+        &hsh_hash_md5, &hsh_hash_sha1, &hsh_hash_sha256, &hsh_hash_sha512,
+        &hsh_hash_sha3_256, &hsh_hash_blake2b, &hsh_hash_blake2sp, &hsh_hash_blake3,
+    };
+    const size_t count = sizeof(algs) / sizeof(algs[0]);
+    uint8_t *data = hsh_test_data(41, len);
+    uint8_t digests[HSH_HASH_MULTI_MAX][HSH_HASH_MAX_DIGEST];
+    uint8_t *out[HSH_HASH_MULTI_MAX];
+    uint8_t want[HSH_HASH_MAX_DIGEST];
+    hsh_hash_multi_ctx ctx;
+
+    for (size_t i = 0; i < count; i++) out[i] = digests[i];
+    for (int threaded = 0; threaded <= 1; threaded++) {
+        HSH_CHECK(hsh_hash_multi_init(&ctx, algs, count, threaded) == 0, "multi init");
+        hsh_hash_multi_update(&ctx, data, 1000);
+        hsh_hash_multi_update(&ctx, data + 1000, len - 1000);
+        hsh_hash_multi_finalize(&ctx, out);
+        for (size_t i = 0; i < count; i++) {
+            char label[64];
+            snprintf(label, sizeof(label), "multi-digest %s, threaded %d", algs[i]->name, threaded);
+            hsh_hash(algs[i], data, len, want);
+            hsh_test_same(label, digests[i], want, algs[i]->digest_size);
+        }
+    }
+    HSH_CHECK(hsh_hash_multi_init(&ctx, algs, 0, 0) == -1, "multi init with no algorithms");
+    free(data);
+}
+
+void hsh_test_stream(void) {
+    uint8_t *data = hsh_test_data(21, 100000);
+
+    for (size_t i = 0; i < hsh_hash_count(); i++)
+        hsh_test_stream_alg(hsh_hash_get(i), data);
+    free(data);
+
+    hsh_test_stream_blake3_parallel();
+    hsh_test_stream_multi();
+}
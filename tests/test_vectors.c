@@ -0,0 +1,248 @@
+/*
+ * Known-answer tests. The messages are the FIPS 180 / FIPS 202 examples
+ * ("abc", the 448- and 896-bit messages, one million 'a') plus the empty
+ * string, run through every algorithm of the registry. BLAKE2 values follow
+ * RFC 7693 and the reference tree-mode parameters for BLAKE2bp / BLAKE2sp,
+ * BLAKE3 values come from the reference implementation.
+ */
+
+#include "test.h"
+#include "hash.h"
+#include "sha2.h"
+#include "sha3.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HSH_TEST_MILLION 1000000
+
+static const char *const hsh_test_messages[] = {
+    "",
+    "abc",
+    "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+    NULL,  /* one million 'a' */
+};
+
+/* Digests of hsh_test_messages[0..4] */
+static const struct {
+    const char *alg;
+    const char *hex[5];
+} hsh_test_kat[] = {
+    {"md5",
+     {"d41d8cd98f00b204e9800998ecf8427e",
+      "900150983cd24fb0d6963f7d28e17f72",
+      "8215ef0796a20bcaaae116d3876c664a",
+      "03dd8807a93175fb062dfb55dc7d359c",
+      "7707d6ae4e027c70eea2a935c2296f21"}},
+    {"sha1",
+     {"da39a3ee5e6b4b0d3255bfef95601890afd80709",
+      "a9993e364706816aba3e25717850c26c9cd0d89d",
+      "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+      "a49b2446a02c645bf419f995b67091253a04a259",
+      "34aa973cd4c4daa4f61eeb2bdbad27316534016f"}},
+    {"sha224",
+     {"d14a028c2a3a2bc9476102bb288234c415a2b01f828ea62ac5b3e42f",
+      "23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7",
+      "75388b16512776cc5dba5da1fd890150b0c6455cb4f58b1952522525",
+      "c97ca9a559850ce97a04a96def6d99a9e0e0e2ab14e6b8df265fc0b3",
+      "20794655980c91d8bbb4c1ea97618a4bf03f42581948b2ee4ee7ad67"}},
+    {"sha256",
+     {"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+      "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+      "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"}},
+    {"sha384",
+     {"38b060a751ac96384cd9327eb1b1e36a21fdb71114be07434c0cc7bf63f6e1da274edebfe76f65fbd51ad2f14898b95b",
+      "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7",
+      "3391fdddfc8dc7393707a65b1b4709397cf8b1d162af05abfe8f450de5f36bc6b0455a8520bc4e6f5fe95b1fe3c8452b",
+      "09330c33f71147e83d192fc782cd1b4753111b173b3b05d22fa08086e3b0f712fcc7c71a557e2db966c3e9fa91746039",
+      "9d0e1809716474cb086e834e310a4a1ced149e9c00f248527972cec5704c2a5b07b8b3dc38ecc4ebae97ddd87f3d8985"}},
+    {"sha512",
+     {"cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e",
+      "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+      "204a8fc6dda82f0a0ced7beb8e08a41657c16ef468b228a8279be331a703c33596fd15c13b1b07f9aa1d3bea57789ca031ad85c7a71dd70354ec631238ca3445",
+      "8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909",
+      "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b"}},
+    {"sha3-224",
+     {"6b4e03423667dbb73b6e15454f0eb1abd4597f9a1b078e3f5b5a6bc7",
+      "e642824c3f8cf24ad09234ee7d3c766fc9a3a5168d0c94ad73b46fdf",
+      "8a24108b154ada21c9fd5574494479ba5c7e7ab76ef264ead0fcce33",
+      "543e6868e1666c1a643630df77367ae5a62a85070a51c14cbf665cbc",
+      "d69335b93325192e516a912e6d19a15cb51c6ed5c15243e7a7fd653c"}},
+    {"sha3-256",
+     {"a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a",
+      "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532",
+      "41c0dba2a9d6240849100376a8235e2c82e1b9998a999e21db32dd97496d3376",
+      "916f6061fe879741ca6469b43971dfdb28b1a32dc36cb3254e812be27aad1d18",
+      "5c8875ae474a3634ba4fd55ec85bffd661f32aca75c6d699d0cdcb6c115891c1"}},
+    {"sha3-384",
+     {"0c63a75b845e4f7d01107d852e4c2485c51a50aaaa94fc61995e71bbee983a2ac3713831264adb47fb6bd1e058d5f004",
+      "ec01498288516fc926459f58e2c6ad8df9b473cb0fc08c2596da7cf0e49be4b298d88cea927ac7f539f1edf228376d25",
+      "991c665755eb3a4b6bbdfb75c78a492e8c56a22c5c4d7e429bfdbc32b9d4ad5aa04a1f076e62fea19eef51acd0657c22",
+      "79407d3b5916b59c3e30b09822974791c313fb9ecc849e406f23592d04f625dc8c709b98b43b3852b337216179aa7fc7",
+      "eee9e24d78c1855337983451df97c8ad9eedf256c6334f8e948d252d5e0e76847aa0774ddb90a842190d2c558b4b8340"}},
+    {"sha3-512",
+     {"a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a615b2123af1f5f94c11e3e9402c3ac558f500199d95b6d3e301758586281dcd26",
+      "b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0",
+      "04a371e84ecfb5b8b77cb48610fca8182dd457ce6f326a0fd3d7ec2f1e91636dee691fbe0c985302ba1b0d8dc78c086346b533b49c030d99a27daf1139d6e75e",
+      "afebb2ef542e6579c50cad06d2e578f9f8dd6881d7dc824d26360feebf18a4fa73e3261122948efcfd492e74e82e2189ed0fb440d187f382270cb455f21dd185",
+      "3c3a876da14034ab60627c077bb98f7e120a2a5370212dffb3385a18d4f38859ed311d0a9d5141ce9cc5c66ee689b266a8aa18ace8282a0e0db596c90b0a7b87"}},
+    {"shake128",
+     {"7f9c2ba4e88f827d616045507605853ed73b8093f6efbc88eb1a6eacfa66ef26",
+      "5881092dd818bf5cf8a3ddb793fbcba74097d5c526a6d35f97b83351940f2cc8",
+      "1a96182b50fb8c7e74e0a707788f55e98209b8d91fade8f32f8dd5cff7bf21f5",
+      "7b6df6ff181173b6d7898d7ff63fb07b7c237daf471a5ae5602adbccef9ccf4b",
+      "9d222c79c4ff9d092cf6ca86143aa411e369973808ef97093255826c5572ef58"}},
+    {"shake256",
+     {"46b9dd2b0ba88d13233b3feb743eeb243fcd52ea62b81b82b50c27646ed5762fd75dc4ddd8c0f200cb05019d67b592f6fc821c49479ab48640292eacb3b7c4be",
+      "483366601360a8771c6863080cc4114d8db44530f8f1e1ee4f94ea37e78b5739d5a15bef186a5386c75744c0527e1faa9f8726e462a12a4feb06bd8801e751e4",
+      "4d8c2dd2435a0128eefbb8c36f6f87133a7911e18d979ee1ae6be5d4fd2e332940d8688a4e6a59aa8060f1f9bc996c05aca3c696a8b66279dc672c740bb224ec",
+      "98be04516c04cc73593fef3ed0352ea9f6443942d6950e29a372a681c3deaf4535423709b02843948684e029010badcc0acd8303fc85fdad3eabf4f78cae1656",
+      "3578a7a4ca9137569cdf76ed617d31bb994fca9c1bbf8b184013de8234dfd13a3fd124d4df76c0a539ee7dd2f6e1ec346124c815d9410e145eb561bcd97b18ab"}},
+    {"blake2b",
+     {"786a02f742015903c6c6fd852552d272912f4740e15847618a86e217f71f5419d25e1031afee585313896444934eb04b903a685b1448b755d56f701afe9be2ce",
+      "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d17d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923",
+      "7285ff3e8bd768d69be62b3bf18765a325917fa9744ac2f582a20850bc2b1141ed1b3e4528595acc90772bdf2d37dc8a47130b44f33a02e8730e5ad8e166e888",
+      "ce741ac5930fe346811175c5227bb7bfcd47f42612fae46c0809514f9e0e3a11ee1773287147cdeaeedff50709aa716341fe65240f4ad6777d6bfaf9726e5e52",
+      "98fb3efb7206fd19ebf69b6f312cf7b64e3b94dbe1a17107913975a793f177e1d077609d7fba363cbba00d05f7aa4e4fa8715d6428104c0a75643b0ff3fd3eaf"}},
+    {"blake2s",
+     {"69217a3079908094e11121d042354a7c1f55b6482ca1a51e1b250dfd1ed0eef9",
+      "508c5e8c327c14e2e1a72ba34eeb452f37458b209ed63a294d999b4c86675982",
+      "6f4df5116a6f332edab1d9e10ee87df6557beab6259d7663f3bcd5722c13f189",
+      "358dd2ed0780d4054e76cb6f3a5bce2841e8e2f547431d4d09db21b66d941fc7",
+      "bec0c0e6cde5b67acb73b81f79a67a4079ae1c60dac9d2661af18e9f8b50dfa5"}},
+    {"blake2bp",
+     {"b5ef811a8038f70b628fa8b294daae7492b1ebe343a80eaabbf1f6ae664dd67b9d90b0120791eab81dc96985f28849f6a305186a85501b405114bfa678df9380",
+      "b91a6b66ae87526c400b0a8b53774dc65284ad8f6575f8148ff93dff943a6ecd8362130f22d6dae633aa0f91df4ac89aaff31d0f1b923c898e82025dedbdad6e",
+      "c5a0341eebb615503e229330e06a3dce8805b434ca758e899e72ac40bac36e637b70098a24ae5c3c4d39a183a43eb974823e3ddb5b09e07ad1e526e905f65bc4",
+      "ba148fde74a1392b3498e204fd60123b20c31e8c7e1b73c05400a46d31fc947c27643c8350ea62b4aad424675cd0370eaab0fe73ed1f1962e3b1390d0bf9c045",
+      "4fd1b8c1e05baa115dbf00df2eb2d217e935f5332b55a20d018109f6b5e08009711b40ae8ff73cf94017796a5a9675dbd2b8341a13f010eb33563dd2ffbbea5e"}},
+    {"blake2sp",
+     {"dd0e891776933f43c7d032b08a917e25741f8aa9a12c12e1cac8801500f2ca4f",
+      "70f75b58f1fecab821db43c88ad84edde5a52600616cd22517b7bb14d440a7d5",
+      "3d107e42f17c13c82b436ebb651a48def67e7772fa06f4738ee968c7f4d8b48b",
+      "b2e3f1eec25bf8897a33a3a6f234a0a589ff21cf342785189875b5a98899127d",
+      "106cd96590d84eede13f09f3940b8e1a7c728988f9b771f811a2f21fd768cc92"}},
+    {"blake3",
+     {"af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262",
+      "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85",
+      "c19012cc2aaf0dc3d8e5c45a1b79114d2df42abb2a410bf54be09e891af06ff8",
+      "553e1aa2a477cb3166e6ab38c12d59f6c5017f0885aaf079f217da00cfca363f",
+      "616f575a1b58d4c9797d4217b9730ae5e6eb319d76edef6549b46f4efe31ff8b"}},
+};
+
+/* XOF output longer than one rate block, for "abc" */
+static const struct {
+    const char *alg;
+    size_t len;
+    const char *hex;
+} hsh_test_xof[] = {
+    {"shake128", 176, "5881092dd818bf5cf8a3ddb793fbcba74097d5c526a6d35f97b83351940f2cc844c50af32acd3f2cdd066568706f509bc1bdde58295dae3f891a9a0fca5783789a41f8611214ce612394df286a62d1a2252aa94db9c538956c717dc2bed4f232a0294c857c730aa16067ac1062f1201fb0d377cfb9cde4c63599b27f3462bba4a0ed296c801f9ff7f57302bb3076ee145f97a32ae68e76ab66c48d51675bd49acc29082f5647584e6aa01b3f5af05780"},
+    {"shake256", 144, "483366601360a8771c6863080cc4114d8db44530f8f1e1ee4f94ea37e78b5739d5a15bef186a5386c75744c0527e1faa9f8726e462a12a4feb06bd8801e751e41385141204f329979fd3047a13c5657724ada64d2470157b3cdc288620944d78dbcddbd912993f0913f164fb2ce95131a2d09a3e6d51cbfc622720d7a75c6334e8a2d7ec71a7cc29cf0ea610eeff1a58"},
+};
+
+/* SHA-256 tree hash of hsh_test_data(seed, len) */
+static const struct {
+    uint64_t seed;
+    size_t len;
+    size_t leaf_size;
+    const char *hex;
+} hsh_test_tree[] = {
+    {1, 0, 1024, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {1, 1024, 1024, "fb7b923c15a037cd5cddb90a445a0af795376a58896ba81b6677fcbf75d7bba7"},
+    {1, 10000, 1024, "251b02eeecde7dc2dc03d7324dde630808eba8c4a603fb1adf7e12622962e77b"},
+    {2, 3670016, 1048576, "6638815843998ce84f42cc5fffee7b4f46091dafe83aa2f00868d40572d74fa2"},
+};
+
+static void hsh_test_registry(void) {
+    uint8_t *million = malloc(HSH_TEST_MILLION);
+    uint8_t digest[HSH_HASH_MAX_DIGEST];
+    char label[64];
+
+    if (!million) abort();
+    memset(million, 'a', HSH_TEST_MILLION);
+
+    HSH_CHECK(hsh_hash_count() == sizeof(hsh_test_kat) / sizeof(hsh_test_kat[0]),
+              "registry has %zu algorithms, vectors cover %zu", hsh_hash_count(),
+              sizeof(hsh_test_kat) / sizeof(hsh_test_kat[0]));
+
+    for (size_t i = 0; i < sizeof(hsh_test_kat) / sizeof(hsh_test_kat[0]); i++) {
+        const hsh_hash_alg *alg = hsh_hash_find(hsh_test_kat[i].alg);
+
+        HSH_CHECK(alg != NULL, "%s not registered", hsh_test_kat[i].alg);
+        if (!alg) continue;
+        for (size_t m = 0; m < 5; m++) {
+            const uint8_t *msg = hsh_test_messages[m] ? (const uint8_t *)hsh_test_messages[m] : million;
+            size_t len = hsh_test_messages[m] ? strlen(hsh_test_messages[m]) : HSH_TEST_MILLION;
+
+            snprintf(label, sizeof(label), "%s message %zu", alg->name, m);
+            hsh_hash(alg, msg, len, digest);
+            hsh_test_hex(label, digest, alg->digest_size, hsh_test_kat[i].hex[m]);
+        }
+    }
+    free(million);
+}
+
+static void hsh_test_shake(void) {
+    uint8_t out[256];
+
+    for (size_t i = 0; i < sizeof(hsh_test_xof) / sizeof(hsh_test_xof[0]); i++) {
+        int is128 = strcmp(hsh_test_xof[i].alg, "shake128") == 0;
+
+        if (is128)
+            hsh_shake128((const uint8_t *)"abc", 3, out, hsh_test_xof[i].len);
+        else
+            hsh_shake256((const uint8_t *)"abc", 3, out, hsh_test_xof[i].len);
+        hsh_test_hex(hsh_test_xof[i].alg, out, hsh_test_xof[i].len, hsh_test_xof[i].hex);
+
+        /* Squeezing in odd pieces continues the same stream */
+        hsh_shake_ctx ctx;
+        uint8_t pieces[256];
+        size_t pos = 0, step = 1;
+
+        if (is128) hsh_shake128_init(&ctx); else hsh_shake256_init(&ctx);
+        hsh_shake_update(&ctx, (const uint8_t *)"abc", 3);
+        while (pos < hsh_test_xof[i].len) {
+            size_t n = step < hsh_test_xof[i].len - pos ? step : hsh_test_xof[i].len - pos;
+            hsh_shake_squeeze(&ctx, pieces + pos, n);
+            pos += n;
+            step = step * 3 + 1;
+        }
+        hsh_test_same("shake squeeze in pieces", pieces, out, hsh_test_xof[i].len);
+    }
+}
+
+static void hsh_test_sha256_tree(void) {
+    uint8_t digest[32];
+
+    for (size_t i = 0; i < sizeof(hsh_test_tree) / sizeof(hsh_test_tree[0]); i++) {
+        uint8_t *data = hsh_test_data(hsh_test_tree[i].seed, hsh_test_tree[i].len);
+        hsh_sha2_256_tree_ctx ctx;
+        char label[64];
+
+        snprintf(label, sizeof(label), "sha256 tree %zu/%zu", hsh_test_tree[i].len,
+                 hsh_test_tree[i].leaf_size);
+        HSH_CHECK(hsh_sha2_256_tree(data, hsh_test_tree[i].len, hsh_test_tree[i].leaf_size,
+                                    digest) == 0, "%s", label);
+        hsh_test_hex(label, digest, 32, hsh_test_tree[i].hex);
+
+        /* Updates that do not line up with leaves */
+        hsh_sha2_256_tree_init(&ctx, hsh_test_tree[i].leaf_size);
+        for (size_t pos = 0; pos < hsh_test_tree[i].len;) {
+            size_t n = hsh_test_tree[i].len - pos < 777 + pos / 3 ? hsh_test_tree[i].len - pos : 777 + pos / 3;
+            hsh_sha2_256_tree_update(&ctx, data + pos, n);
+            pos += n;
+        }
+        hsh_sha2_256_tree_finalize(&ctx, digest);
+        hsh_test_hex(label, digest, 32, hsh_test_tree[i].hex);
+        free(data);
+    }
+    HSH_CHECK(hsh_sha2_256_tree(NULL, 0, 0, digest) == -1, "tree leaf_size 0 accepted");
+}
+
+void hsh_test_vectors(void) {
+    hsh_test_registry();
+    hsh_test_shake();
+    hsh_test_sha256_tree();
+}
@@ -0,0 +1,508 @@
+/*
+ * hshsum: print or check message digests, like sha256sum / b2sum, for any
+ * algorithm of the hsh_hash registry.
+ *
+ *   hshsum [-a alg] [-r] [-j threads] [-s] [file|dir ...]
+ *   hshsum -c [-a alg] [-q] [-j threads] [-s] [sumfile ...]
+ *   hshsum -l
+ *
+ *   -a  algorithm (default sha256), see -l
+ *   -c  read "digest  path" lines and verify them; as in coreutils, a
+ *       line starting with a backslash has \\, \n and \r escapes in path
+ *   -q  with -c, only report failures
+ *   -r  hash directory trees recursively (symlinks to directories are not
+ *       followed)
+ *   -j  worker threads (default: online CPUs)
+ *   -s  print file count, bytes and throughput to stderr when done
+ *   -l  list algorithms with the backend selected on this machine
+ *
+ * Files are hashed on a work-stealing pool: every worker owns a deque of
+ * tasks, largest files first, and idle workers steal from the tail of
+ * the others. Files under 64 KiB are batched so that one task is not a
+ * single open / read / close. A file is hashed by a single worker, since
+ * all but the tree-mode algorithms are strictly sequential; BLAKE3 and
+ * BLAKE2bp / BLAKE2sp split large files over libhsh's own thread pool
+ * when it is not already busy. Output is in argument / directory order.
+ */
+
+#include "hash.h"
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define SUM_SMALL_FILE   (64 * 1024)
+#define SUM_BATCH_BYTES  (1024 * 1024)
+#define SUM_BATCH_FILES  256
+#define SUM_MAX_THREADS  256
+
+/* ==== File list ==== */
+
+typedef struct {
+    char *path;
+    uint64_t size;
+    char *expected;          /* check mode: hex digest from the sum file */
+    uint8_t digest[HSH_HASH_MAX_DIGEST];
+    int err;                 /* errno of a failed open / read */
+    int strategy;
+    int done;
+} sum_file;
+
+/* Consecutive files [first, first + count) hashed by one worker */
+typedef struct {
+    size_t first;
+    size_t count;
+    uint64_t bytes;
+} sum_task;
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t *tasks;
+    size_t head, tail;
+} sum_deque;
+
+static struct {
+    const hsh_hash_alg *alg;
+    sum_file *files;
+    size_t count, cap;
+    sum_task *tasks;
+    sum_deque *deques;
+    size_t threads;
+    pthread_mutex_t lock;    /* guards sum_file.done */
+    pthread_cond_t done;
+    uint64_t strategies[3];
+    int recursive;
+    int failed;
+} sum;
+
+/* realloc() / strdup() that give up with status 2 when memory runs out */
+static void *sum_xrealloc(void *p, size_t size) {
+    p = realloc(p, size);
+    if (!p) {
+        fprintf(stderr, "hshsum: out of memory\n");
+        exit(2);
+    }
+    return p;
+}
+
+static char *sum_xstrdup(const char *s) {
+    size_t len = strlen(s) + 1;
+    return memcpy(sum_xrealloc(NULL, len), s, len);
+}
+
+static void sum_add_file(const char *path, uint64_t size, const char *expected) {
+    if (sum.count == sum.cap) {
+        sum.cap = sum.cap ? 2 * sum.cap : 256;
+        sum.files = sum_xrealloc(sum.files, sum.cap * sizeof(sum_file));
+    }
+    sum_file *f = &sum.files[sum.count++];
+    memset(f, 0, sizeof(*f));
+    f->path = sum_xstrdup(path);
+    f->size = size;
+    f->expected = expected ? sum_xstrdup(expected) : NULL;
+}
+
+static int sum_cmp_name(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Adds the regular files below dir, in name order */
+static void sum_walk(const char *dir) {
+    DIR *d = opendir(dir);
+    struct dirent *e;
+    char **names = NULL;
+    size_t n = 0, cap = 0;
+
+    if (!d) {
+        fprintf(stderr, "hshsum: %s: %s\n", dir, strerror(errno));
+        sum.failed = 1;
+        return;
+    }
+    while ((e = readdir(d)) != NULL) {
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+        if (n == cap) {
+            cap = cap ? 2 * cap : 64;
+            names = sum_xrealloc(names, cap * sizeof(char *));
+        }
+        names[n++] = sum_xstrdup(e->d_name);
+    }
+    closedir(d);
+    qsort(names, n, sizeof(char *), sum_cmp_name);
+
+    for (size_t i = 0; i < n; i++) {
+        size_t len = strlen(dir);
+        char *path = sum_xrealloc(NULL, len + strlen(names[i]) + 2);
+        struct stat st;
+
+        sprintf(path, "%s%s%s", dir, len && dir[len - 1] == '/' ? "" : "/", names[i]);
+        /* Symlinked directories are skipped, symlinked files followed */
+        if (lstat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            sum_walk(path);
+        } else if (stat(path, &st) != 0) {
+            fprintf(stderr, "hshsum: %s: %s\n", path, strerror(errno));
+            sum.failed = 1;
+        } else if (S_ISREG(st.st_mode)) {
+            sum_add_file(path, (uint64_t)st.st_size, NULL);
+        }
+        free(path);
+        free(names[i]);
+    }
+    free(names);
+}
+
+static void sum_add_arg(const char *path) {
+    struct stat st;
+    int found = strcmp(path, "-") != 0 && stat(path, &st) == 0;
+
+    if (found && S_ISDIR(st.st_mode)) {
+        if (sum.recursive) {
+            sum_walk(path);
+        } else {
+            fprintf(stderr, "hshsum: %s: Is a directory\n", path);
+            sum.failed = 1;
+        }
+        return;
+    }
+    /* Errors are reported when the file is hashed, in order */
+    sum_add_file(path, found ? (uint64_t)st.st_size : 0, NULL);
+}
+
+/* ==== Check files ==== */
+
+static int sum_is_hex(const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!((s[i] >= '0' && s[i] <= '9') || (s[i] >= 'a' && s[i] <= 'f') ||
+              (s[i] >= 'A' && s[i] <= 'F')))
+            return 0;
+    }
+    return 1;
+}
+
+/* Undoes sum_put_path() in place. Returns -1 for an unknown escape. */
+static int sum_unescape(char *s) {
+    char *out = s;
+
+    for (; *s; s++) {
+        if (*s != '\\') {
+            *out++ = *s;
+            continue;
+        }
+        switch (*++s) {
+        case '\\': *out++ = '\\'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        default: return -1;
+        }
+    }
+    *out = '\0';
+    return 0;
+}
+
+/* Reads "<hex>  <path>" (or "<hex> *<path>") lines; a leading backslash
+ * marks an escaped path */
+static void sum_read_checks(const char *sumfile) {
+    FILE *in = strcmp(sumfile, "-") == 0 ? stdin : fopen(sumfile, "r");
+    size_t hex_len = 2 * sum.alg->digest_size, bad = 0;
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+
+    if (!in) {
+        fprintf(stderr, "hshsum: %s: %s\n", sumfile, strerror(errno));
+        sum.failed = 1;
+        return;
+    }
+    while ((len = getline(&line, &cap, in)) > 0) {
+        char *hex = line;
+        int escaped = line[0] == '\\';
+
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+            line[--len] = '\0';
+        hex += escaped;
+        len -= escaped;
+        if ((size_t)len < hex_len + 3 || !sum_is_hex(hex, hex_len) || hex[hex_len] != ' ' ||
+            (hex[hex_len + 1] != ' ' && hex[hex_len + 1] != '*')) {
+            bad++;
+            continue;
+        }
+        hex[hex_len] = '\0';
+
+        char *path = hex + hex_len + 2;
+        struct stat st;
+        if (escaped && sum_unescape(path) != 0) {
+            bad++;
+            continue;
+        }
+        sum_add_file(path, stat(path, &st) == 0 ? (uint64_t)st.st_size : 0, hex);
+    }
+    free(line);
+    if (in != stdin) fclose(in);
+
+    if (bad) {
+        fprintf(stderr, "hshsum: %s: %zu line%s improperly formatted\n",
+                sumfile, bad, bad == 1 ? "" : "s");
+        sum.failed = 1;
+    }
+}
+
+/* ==== Work-stealing pool ==== */
+
+static int sum_cmp_task(const void *a, const void *b) {
+    uint64_t x = ((const sum_task *)a)->bytes, y = ((const sum_task *)b)->bytes;
+    return (x < y) - (x > y);
+}
+
+/* Groups the file list into tasks and deals them out, largest first */
+static size_t sum_make_tasks(void) {
+    size_t ntasks = 0;
+
+    sum.tasks = sum_xrealloc(NULL, (sum.count ? sum.count : 1) * sizeof(sum_task));
+    for (size_t i = 0; i < sum.count;) {
+        sum_task *t = &sum.tasks[ntasks++];
+        t->first = i;
+        t->count = 1;
+        t->bytes = sum.files[i].size;
+        i++;
+        if (t->bytes >= SUM_SMALL_FILE) continue;
+        while (i < sum.count && sum.files[i].size < SUM_SMALL_FILE &&
+               t->count < SUM_BATCH_FILES && t->bytes < SUM_BATCH_BYTES) {
+            t->bytes += sum.files[i].size;
+            t->count++;
+            i++;
+        }
+    }
+    qsort(sum.tasks, ntasks, sizeof(sum_task), sum_cmp_task);
+
+    sum.deques = sum_xrealloc(NULL, sum.threads * sizeof(sum_deque));
+    memset(sum.deques, 0, sum.threads * sizeof(sum_deque));
+    for (size_t w = 0; w < sum.threads; w++) {
+        pthread_mutex_init(&sum.deques[w].lock, NULL);
+        sum.deques[w].tasks = sum_xrealloc(NULL, (ntasks / sum.threads + 1) * sizeof(size_t));
+    }
+    for (size_t i = 0; i < ntasks; i++) {
+        sum_deque *q = &sum.deques[i % sum.threads];
+        q->tasks[q->tail++] = i;
+    }
+    return ntasks;
+}
+
+/* Own work from the head (largest first), stolen work from the tail */
+static int sum_next_task(size_t self, size_t *task) {
+    for (size_t k = 0; k < sum.threads; k++) {
+        sum_deque *q = &sum.deques[(self + k) % sum.threads];
+        int found = 0;
+
+        pthread_mutex_lock(&q->lock);
+        if (q->head < q->tail) {
+            *task = k == 0 ? q->tasks[q->head++] : q->tasks[--q->tail];
+            found = 1;
+        }
+        pthread_mutex_unlock(&q->lock);
+        if (found) return 1;
+    }
+    return 0;
+}
+
+static void sum_hash_one(sum_file *f) {
+    hsh_hash_file_stats st;
+    int ret;
+
+    if (strcmp(f->path, "-") == 0)
+        ret = hsh_hash_fd(sum.alg, STDIN_FILENO, f->digest, &st);
+    else
+        ret = hsh_hash_file(sum.alg, f->path, f->digest, &st);
+    if (ret != 0) {
+        f->err = errno;
+    } else {
+        f->strategy = st.strategy;
+        f->size = st.bytes;
+    }
+}
+
+static void *sum_worker(void *arg) {
+    size_t self = (size_t)(uintptr_t)arg, t;
+
+    while (sum_next_task(self, &t)) {
+        const sum_task *task = &sum.tasks[t];
+        for (size_t i = task->first; i < task->first + task->count; i++) {
+            sum_hash_one(&sum.files[i]);
+            pthread_mutex_lock(&sum.lock);
+            sum.files[i].done = 1;
+            pthread_cond_broadcast(&sum.done);
+            pthread_mutex_unlock(&sum.lock);
+        }
+    }
+    return NULL;
+}
+
+/* ==== Output ==== */
+
+static void sum_hex(const uint8_t *digest, size_t len, char *out) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = digits[digest[i] >> 4];
+        out[2 * i + 1] = digits[digest[i] & 15];
+    }
+    out[2 * len] = '\0';
+}
+
+static int sum_needs_escape(const char *path) {
+    return strpbrk(path, "\\\n\r") != NULL;
+}
+
+/* Writes path with backslash, newline and carriage return escaped, as
+ * coreutils does; the caller marks the line with a leading backslash */
+static void sum_put_path(const char *path) {
+    for (; *path; path++) {
+        switch (*path) {
+        case '\\': fputs("\\\\", stdout); break;
+        case '\n': fputs("\\n", stdout); break;
+        case '\r': fputs("\\r", stdout); break;
+        default: putchar(*path);
+        }
+    }
+}
+
+/* Prints results in list order as soon as each one is ready */
+static void sum_report(int check, int quiet, size_t *mismatches, size_t *unreadable) {
+    char hex[2 * HSH_HASH_MAX_DIGEST + 1];
+
+    for (size_t i = 0; i < sum.count; i++) {
+        sum_file *f = &sum.files[i];
+
+        pthread_mutex_lock(&sum.lock);
+        while (!f->done)
+            pthread_cond_wait(&sum.done, &sum.lock);
+        pthread_mutex_unlock(&sum.lock);
+
+        const char *status = NULL;
+        int escape = sum_needs_escape(f->path);
+
+        if (f->err) {
+            fprintf(stderr, "hshsum: %s: %s\n", f->path, strerror(f->err));
+            if (check) status = "FAILED open or read";
+            (*unreadable)++;
+        } else {
+            sum.strategies[f->strategy]++;
+            sum_hex(f->digest, sum.alg->digest_size, hex);
+            if (!check) {
+                printf("%s%s  ", escape ? "\\" : "", hex);
+                sum_put_path(f->path);
+                putchar('\n');
+            } else if (strcasecmp(hex, f->expected) != 0) {
+                status = "FAILED";
+                (*mismatches)++;
+            } else if (!quiet) {
+                status = "OK";
+            }
+        }
+        if (status) {
+            if (escape) putchar('\\');
+            sum_put_path(f->path);
+            printf(": %s\n", status);
+        }
+    }
+}
+
+/* ==== Main ==== */
+
+static double sum_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void sum_usage(void) {
+    fprintf(stderr, "usage: hshsum [-a alg] [-r] [-j threads] [-s] [file|dir ...]\n"
+                    "       hshsum -c [-a alg] [-q] [-j threads] [-s] [sumfile ...]\n"
+                    "       hshsum -l\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    int check = 0, quiet = 0, stats = 0, opt;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t mismatches = 0, unreadable = 0;
+    pthread_t tids[SUM_MAX_THREADS];
+    double start = sum_now();
+    uint64_t bytes = 0;
+
+    sum.alg = &hsh_hash_sha256;
+    while ((opt = getopt(argc, argv, "a:cqrj:slh")) != -1) {
+        switch (opt) {
+        case 'a':
+            sum.alg = hsh_hash_find(optarg);
+            if (!sum.alg) {
+                fprintf(stderr, "hshsum: unknown algorithm '%s' (see -l)\n", optarg);
+                return 2;
+            }
+            break;
+        case 'c': check = 1; break;
+        case 'q': quiet = 1; break;
+        case 'r': sum.recursive = 1; break;
+        case 'j': threads = strtol(optarg, NULL, 10); break;
+        case 's': stats = 1; break;
+        case 'l':
+            for (size_t i = 0; i < hsh_hash_count(); i++) {
+                const hsh_hash_alg *alg = hsh_hash_get(i);
+                printf("%-10s %3zu bits  %s\n", alg->name, 8 * alg->digest_size,
+                       hsh_hash_backend(alg));
+            }
+            return 0;
+        default: sum_usage();
+        }
+    }
+    if (threads < 1) threads = 1;
+    if (threads > SUM_MAX_THREADS) threads = SUM_MAX_THREADS;
+
+    if (optind == argc) {
+        if (check) sum_read_checks("-"); else sum_add_arg("-");
+    }
+    for (int i = optind; i < argc; i++) {
+        if (check) sum_read_checks(argv[i]); else sum_add_arg(argv[i]);
+    }
+
+    sum.threads = (size_t)threads < sum.count ? (size_t)threads : (sum.count ? sum.count : 1);
+    pthread_mutex_init(&sum.lock, NULL);
+    pthread_cond_init(&sum.done, NULL);
+    sum_make_tasks();
+    for (size_t w = 0; w < sum.threads; w++) {
+        if (pthread_create(&tids[w], NULL, sum_worker, (void *)(uintptr_t)w) != 0) {
+            fprintf(stderr, "hshsum: cannot create threads\n");
+            return 2;
+        }
+    }
+
+    sum_report(check, quiet, &mismatches, &unreadable);
+    for (size_t w = 0; w < sum.threads; w++)
+        pthread_join(tids[w], NULL);
+
+    if (check && mismatches)
+        fprintf(stderr, "hshsum: WARNING: %zu computed checksum%s did NOT match\n",
+                mismatches, mismatches == 1 ? "" : "s");
+    if (check && unreadable)
+        fprintf(stderr, "hshsum: WARNING: %zu listed file%s could not be read\n",
+                unreadable, unreadable == 1 ? "" : "s");
+
+    if (stats) {
+        double secs = sum_now() - start;
+        for (size_t i = 0; i < sum.count; i++)
+            if (!sum.files[i].err) bytes += sum.files[i].size;
+        fprintf(stderr, "hshsum: %s (%s), %zu files, %llu bytes, %zu threads, %.3f s, "
+                        "%.3f GB/s, %.0f files/s (mmap %llu, read %llu, pipeline %llu)\n",
+                sum.alg->name, hsh_hash_backend(sum.alg), sum.count, (unsigned long long)bytes,
+                sum.threads, secs, secs > 0 ? (double)bytes / secs * 1e-9 : 0.0,
+                secs > 0 ? (double)sum.count / secs : 0.0,
+                (unsigned long long)sum.strategies[HSH_HASH_FILE_MMAP],
+                (unsigned long long)sum.strategies[HSH_HASH_FILE_READ],
+                (unsigned long long)sum.strategies[HSH_HASH_FILE_PIPELINE]);
+    }
+
+    return sum.failed || mismatches || unreadable ? 1 : 0;
+}